@@ -1,23 +1,254 @@
 /*
     Milestone A Test Application
     Tests basic plugin loading and synthetic MIDI rendering
+
+    Options:
+        --reference-synth   Use the built-in reference synth instead of Serum2
+        --manifest FILE     Render every job of a JSONL manifest (see README)
+        --workers N         Number of render workers for --manifest (default 1)
+        --pin-threads       Pin each worker thread to its own CPU core
+        --shard-dir DIR     Pack renders into per-worker shard files in DIR
+        --shard-size-mb N   Start a new shard after N MB (default 1024)
+        --no-cache          Render every job even if a verified cached render exists
+        --lockstep N        Experimental: render up to N views of a preset together per worker
+        --block-size N|auto Override every job's block size; "auto" uses the fastest measured
+                            size for the plugin (remembered in data/outmeta/block_size.json)
+        --supervise         Render in sandboxed worker processes (--workers of them) that are
+                            restarted when a plugin crashes or hangs
+        --job-timeout S     Supervisor mode: fail a job and restart its worker after S seconds
+                            (default 30s plus 20x the job's audio length)
+        --plugin-path DIRS  Search these VST3 directories (":"-separated, ";" on Windows) before
+                            $SERUM_VST3_PATH and the platform defaults
+        --scan-jobs N       Plugin bundles scanned at once (default one per CPU core)
+        --log-level LEVEL   debug, info (default), warning or error
+        --log-json          Write log lines as JSON objects
+        --log-file FILE     Append the log to FILE instead of stdout
 */
 
 #include <JuceHeader.h>
 #include "vst/PluginScanner.h"
 #include "vst/PluginFactory.h"
+#include "vst/ReferenceSynth.h"
 #include "midi/SyntheticMidiGenerator.h"
 #include "render/OfflineRenderer.h"
 #include "render/AudioStats.h"
+#include "render/RenderFarm.h"
+#include "render/RenderManifest.h"
+#include "render/RenderCache.h"
+#include "render/BlockSizeTuner.h"
+#include "render/RenderMetadata.h"
+#include "render/RenderSupervisor.h"
+#include "render/RenderWorkerProcess.h"
 #include "common/Log.h"
 #include "common/Paths.h"
 
 using namespace serum;
 
+/**
+ * Plugin scanner settings from --plugin-path and --scan-jobs
+ */
+static PluginScanOptions getScanOptions(const juce::ArgumentList& args)
+{
+    PluginScanOptions options;
+    options.searchPaths = PluginScanner::splitSearchPath(args.getValueForOption("--plugin-path"));
+    options.numJobs = args.getValueForOption("--scan-jobs").getIntValue();
+    return options;
+}
+
+/**
+ * Block size with the best throughput for a plugin, measured once and remembered
+ * @return the block size, 0 if it could not be measured
+ */
+static int chooseBlockSize(PluginFactory& factory, const juce::PluginDescription& desc)
+{
+    const double sampleRate = RenderSettings().sampleRate;
+    auto cacheFile = BlockSizeTuner::getDefaultCacheFile();
+    auto pluginId = desc.createIdentifierString();
+    
+    int blockSize = BlockSizeTuner::loadTunedBlockSize(cacheFile, pluginId, sampleRate);
+    if (blockSize > 0)
+    {
+        logInfo("Using tuned block size " + juce::String(blockSize) + " for " + desc.name);
+        return blockSize;
+    }
+    
+    juce::String errorMsg;
+    auto plugin = factory.createPlugin(desc, errorMsg, sampleRate);
+    if (plugin == nullptr)
+    {
+        logError("Cannot tune block size: " + errorMsg);
+        return 0;
+    }
+    
+    logInfo("Measuring block sizes for " + desc.name);
+    BlockSizeTuner tuner(*plugin);
+    blockSize = tuner.tune(sampleRate);
+    
+    if (blockSize > 0)
+        BlockSizeTuner::saveTunedBlockSize(cacheFile, pluginId, sampleRate, blockSize);
+    
+    return blockSize;
+}
+
+/**
+ * Render every job of a manifest on a worker pool
+ */
+static int runRenderFarm(PluginFactory& factory, const juce::PluginDescription& desc,
+                         const juce::File& manifestFile, const RenderFarmOptions& options)
+{
+    RenderManifest manifest;
+    juce::String errorMsg;
+    if (!manifest.open(manifestFile, errorMsg))
+        return 1;
+    
+    ensureDirectoryExists(getOutputWavDir());
+    
+    // Instances start prepared for the first job's settings
+    RenderSettings firstSettings;
+    RenderManifest::readFirstJobSettings(manifestFile, firstSettings);
+    
+    RenderFarm farm(factory, desc, options);
+    if (!farm.createWorkers(errorMsg, firstSettings))
+    {
+        logError("Failed to create workers: " + errorMsg);
+        return 1;
+    }
+    
+    // Every preset state is read once, shared by all workers
+    farm.getStateStore().scan(getPresetStatesDir());
+    
+    RenderFarmSummary summary;
+    bool ok = farm.run(manifest, summary);
+    
+    if (manifest.getNumInvalidLines() > 0)
+    {
+        logError("Skipped " + juce::String(manifest.getNumInvalidLines()) + " invalid manifest lines");
+        ok = false;
+    }
+    
+    return ok ? 0 : 1;
+}
+
+/**
+ * Render every job of a manifest in sandboxed worker processes
+ */
+static int runSupervisor(const juce::PluginDescription& desc, const juce::File& manifestFile,
+                         const RenderFarmOptions& farmOptions, const juce::ArgumentList& args)
+{
+    if (farmOptions.lockstepViews > 1)
+    {
+        logError("--supervise cannot be combined with --lockstep");
+        return 1;
+    }
+    
+    ensureDirectoryExists(getOutputWavDir());
+    
+    RenderSupervisorOptions options;
+    options.numWorkers = farmOptions.numWorkers;
+    options.blockSize = farmOptions.blockSize;
+    options.cacheDirectory = farmOptions.cacheDirectory;
+    options.shardDirectory = farmOptions.shardDirectory;
+    options.maxShardBytes = farmOptions.maxShardBytes;
+    options.jobTimeoutSec = args.getValueForOption("--job-timeout").getDoubleValue();
+    options.quarantineFile = RenderSupervisor::getDefaultQuarantineFile();
+    options.logDirectory = getOutputMetaDir().getChildFile("logs");
+    options.logJson = args.containsOption("--log-json");
+    
+    RenderSupervisor supervisor(desc, options);
+    RenderSupervisorSummary summary;
+    return supervisor.run(manifestFile, summary) ? 0 : 1;
+}
+
 int main(int argc, char* argv[])
 {
     juce::ScopedJuceInitialiser_GUI juceInit;
     
+    // Launched by a supervisor as one of its workers
+    RenderWorkerProcess workerProcess;
+    if (workerProcess.initialiseFromCommandLine(juce::StringArray(argv + 1, argc - 1).joinIntoString(" "),
+                                                renderWorkerProcessId))
+        return workerProcess.run();
+    
+    juce::ArgumentList args(argc, argv);
+    
+    // Launched by a PluginScanner to inspect one bundle
+    if (PluginScanner::isScanWorkerCommandLine(args))
+        return PluginScanner::runScanWorker(args);
+    
+    if (!configureLoggingFromArgs(args))
+        return 1;
+    
+    const bool useReferenceSynth = args.containsOption("--reference-synth");
+    const int numWorkers = args.getValueForOption("--workers").getIntValue();
+    const auto manifestPath = args.getValueForOption("--manifest");
+    
+    if (numWorkers > 0 && manifestPath.isEmpty())
+    {
+        logError("--workers requires --manifest <file.jsonl>");
+        return 1;
+    }
+    
+    if (manifestPath.isNotEmpty())
+    {
+        logInfo("=== Batch Render Farm ===");
+        PluginScanner scanner(getScanOptions(args));
+        auto referenceDesc = ReferenceSynth::createDescription();
+        const juce::PluginDescription* farmDesc = &referenceDesc;
+        
+        if (!useReferenceSynth)
+        {
+            if (!scanner.loadOrScan() || (farmDesc = scanner.findSerum2()) == nullptr)
+            {
+                logError("Serum2 not found! Use --reference-synth to render without it");
+                return 1;
+            }
+        }
+        
+        PluginFactory factory;
+        auto cwd = juce::File::getCurrentWorkingDirectory();
+        
+        RenderFarmOptions options;
+        options.numWorkers = juce::jmax(1, numWorkers);
+        options.pinThreads = args.containsOption("--pin-threads");
+        options.lockstepViews = juce::jmax(1, args.getValueForOption("--lockstep").getIntValue());
+        options.timingReportFile = getOutputMetaDir().getChildFile("timings")
+            .getChildFile("batch_" + juce::Time::getCurrentTime().formatted("%Y%m%d_%H%M%S") + ".json");
+        
+        auto blockSize = args.getValueForOption("--block-size");
+        if (blockSize == "auto")
+        {
+            options.blockSize = chooseBlockSize(factory, *farmDesc);
+            if (options.blockSize <= 0)
+                return 1;
+        }
+        else if (blockSize.isNotEmpty())
+        {
+            options.blockSize = blockSize.getIntValue();
+            if (options.blockSize <= 0)
+            {
+                logError("--block-size must be a positive number or \"auto\"");
+                return 1;
+            }
+        }
+        
+        if (!args.containsOption("--no-cache"))
+            options.cacheDirectory = RenderCache::getDefaultDirectory();
+        
+        auto shardDir = args.getValueForOption("--shard-dir");
+        if (shardDir.isNotEmpty())
+        {
+            options.shardDirectory = cwd.getChildFile(shardDir);
+            int shardSizeMB = args.getValueForOption("--shard-size-mb").getIntValue();
+            if (shardSizeMB > 0)
+                options.maxShardBytes = static_cast<int64>(shardSizeMB) * 1024 * 1024;
+        }
+        
+        if (args.containsOption("--supervise"))
+            return runSupervisor(*farmDesc, cwd.getChildFile(manifestPath), options, args);
+        
+        return runRenderFarm(factory, *farmDesc, cwd.getChildFile(manifestPath), options);
+    }
+    
     logInfo("=== Milestone A: Plugin Load & Basic Rendering Test ===");
     
     // Test configuration
@@ -31,8 +262,9 @@ int main(int argc, char* argv[])
     
     // Step 1: Scan for plugins
     logInfo("Step 1: Scanning for VST3 plugins");
-    PluginScanner scanner;
-    if (!scanner.loadOrScan())
+    PluginScanner scanner(getScanOptions(args));
+    auto referenceDesc = ReferenceSynth::createDescription();
+    if (!useReferenceSynth && !scanner.loadOrScan())
     {
         logError("Failed to scan plugins");
         return 1;
@@ -40,11 +272,11 @@ int main(int argc, char* argv[])
     
     // Step 2: Find Serum2
     logInfo("Step 2: Finding Serum2 plugin");
-    auto* desc = scanner.findSerum2();
+    auto* desc = useReferenceSynth ? &referenceDesc : scanner.findSerum2();
     if (desc == nullptr)
     {
         logError("Serum2 not found!");
-        logError("Please ensure Serum2 is installed in: C:\\Program Files\\Common Files\\VST3\\");
+        logError("Searched: " + scanner.getSearchPaths().joinIntoString(", "));
         return 1;
     }
     
@@ -54,7 +286,7 @@ int main(int argc, char* argv[])
     logInfo("Step 3: Creating plugin instance");
     PluginFactory factory;
     juce::String errorMsg;
-    auto plugin = factory.createPlugin(*desc, errorMsg);
+    auto plugin = factory.createPlugin(*desc, errorMsg, sampleRate, blockSize);
     
     if (plugin == nullptr)
     {
@@ -90,12 +322,30 @@ int main(int argc, char* argv[])
     );
     
     AudioStats stats;
+    getThreadPhaseTimings().reset();
     if (!renderer.renderToFile(outputFile, stats))
     {
         logError("Rendering failed");
         return 1;
     }
     
+    // Machine-readable record of the render, including where the time went
+    RenderMetadata metadata;
+    metadata.job.noteName = noteName;
+    metadata.job.velocity = velocity;
+    metadata.job.outputFile = outputFile;
+    metadata.job.settings.sampleRate = sampleRate;
+    metadata.job.settings.blockSize = blockSize;
+    metadata.job.settings.warmupSec = warmupSec;
+    metadata.job.settings.renderSec = renderSec;
+    metadata.job.settings.tailSec = tailSec;
+    metadata.stats = stats;
+    metadata.renderedTailSec = tailSec;
+    metadata.timings = getThreadPhaseTimings();
+    metadata.writeToFile(RenderMetadata::getFileFor(outputFile));
+    logInfo("Render time: " + juce::String(metadata.timings.getTotalSeconds() * 1000.0, 1) + " ms ("
+            + juce::JSON::toString(metadata.timings.toVar(), true) + ")");
+    
     // Step 7: Verify output
     logInfo("Step 7: Verifying output");
     if (!outputFile.existsAsFile())
@@ -0,0 +1,92 @@
+/*
+    Render Benchmark
+    Microbenchmarks for the render pipeline hot paths
+
+    Usage:
+        RenderBenchmark [suite ...] [--blocks N] [--hash-mb N] [--views N] [--rounds N] [--render-sec S]
+                        [--renders N] [--io-mb N] [--shm-mb N] [--log-level LEVEL] [--log-json] [--log-file FILE]
+
+    Suites:
+        render      Renders/sec, realtime factor, I/O throughput and allocations
+        stats       AudioStats kernels against the original scalar loop
+        hash        SHA-256 and fast 128-bit hashing throughput
+        lockstep    Multi-instance lockstep rendering against sequential renders
+        blocksize   Render throughput of the reference synth across block sizes
+        shm         Shared-memory audio ring throughput (GB/s)
+*/
+
+#include <JuceHeader.h>
+#include "bench/Benchmark.h"
+#include "common/Log.h"
+#include <algorithm>
+#include <iterator>
+
+using namespace serum;
+
+struct BenchmarkSuite
+{
+    const char* name;
+    bool (*run)(const juce::ArgumentList& args);
+};
+
+static const BenchmarkSuite suites[] = {
+    { "render",    runRenderBenchmark },
+    { "stats",     runStatsBenchmark },
+    { "hash",      runHashBenchmark },
+    { "lockstep",  runLockstepBenchmark },
+    { "blocksize", runBlockSizeBenchmark },
+    { "shm",       runShmBenchmark },
+};
+
+// Options followed by a value, which is not a suite name
+static const juce::StringArray valueOptions {
+    "--blocks", "--hash-mb", "--views", "--rounds", "--render-sec", "--renders",
+    "--io-mb", "--shm-mb", "--log-level", "--log-file"
+};
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInit;
+    juce::ArgumentList args(argc, argv);
+    if (!configureLoggingFromArgs(args))
+        return 1;
+    
+    // Positional arguments select suites; none runs everything. The token after
+    // an option that takes a value ("--blocks 2000") is that option's value.
+    juce::StringArray selected;
+    for (int i = 0; i < args.size(); ++i)
+    {
+        const auto& arg = args[i];
+        if (arg.isOption())
+        {
+            if (!arg.text.contains("=") && valueOptions.contains(arg.text))
+                ++i;
+        }
+        else
+        {
+            selected.add(arg.text);
+        }
+    }
+    
+    for (const auto& name : selected)
+    {
+        if (std::none_of(std::begin(suites), std::end(suites),
+                         [&name](const BenchmarkSuite& suite) { return name == suite.name; }))
+        {
+            logError("Unknown benchmark suite: " + name);
+            return 1;
+        }
+    }
+    
+    bool ok = true;
+    for (const auto& suite : suites)
+    {
+        if (!selected.isEmpty() && !selected.contains(suite.name))
+            continue;
+        
+        logInfo(juce::String("=== Benchmark: ") + suite.name + " ===");
+        ok = suite.run(args) && ok;
+    }
+    
+    return ok ? 0 : 1;
+}
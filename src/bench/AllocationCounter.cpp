@@ -0,0 +1,81 @@
+#include "bench/AllocationCounter.h"
+#include <cstdlib>
+#include <new>
+
+namespace serum {
+
+// Zero-initialized, so safe to touch from inside malloc
+static thread_local int64 threadAllocations = 0;
+
+int64 getThreadAllocationCount()
+{
+    return threadAllocations;
+}
+
+} // namespace serum
+
+#if defined(__GLIBC__)
+
+// On glibc, wrap malloc itself: this also catches juce::HeapBlock (audio
+// buffers), which bypasses operator new. free() is left alone.
+extern "C" void* __libc_malloc(size_t size);
+extern "C" void* __libc_calloc(size_t count, size_t size);
+extern "C" void* __libc_realloc(void* ptr, size_t size);
+
+extern "C" void* malloc(size_t size)
+{
+    ++serum::threadAllocations;
+    return __libc_malloc(size);
+}
+
+extern "C" void* calloc(size_t count, size_t size)
+{
+    ++serum::threadAllocations;
+    return __libc_calloc(count, size);
+}
+
+extern "C" void* realloc(void* ptr, size_t size)
+{
+    ++serum::threadAllocations;
+    return __libc_realloc(ptr, size);
+}
+
+#else
+
+// Elsewhere, count the global operator new. Aligned and nothrow variants
+// keep their default implementations.
+void* operator new(std::size_t size)
+{
+    ++serum::threadAllocations;
+    if (void* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size)
+{
+    return ::operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace serum {
+
+/**
+ * Heap allocations made by the calling thread since it started
+ * Counted by the global operator new replacement linked into the benchmark;
+ * differences between two calls give the allocations of the code in between.
+ */
+int64 getThreadAllocationCount();
+
+/**
+ * Counts the calling thread's allocations over a scope
+ */
+class ScopedAllocationCounter
+{
+public:
+    ScopedAllocationCounter() : startCount(getThreadAllocationCount()) {}
+
+    int64 getCount() const { return getThreadAllocationCount() - startCount; }
+
+private:
+    int64 startCount;
+};
+
+} // namespace serum
@@ -0,0 +1,13 @@
+#include "bench/Benchmark.h"
+#include "common/Log.h"
+
+namespace serum {
+
+void reportBenchmark(const juce::String& name, double seconds, double items, const juce::String& unit)
+{
+    double rate = seconds > 0.0 ? items / seconds : 0.0;
+    logInfo(name.paddedRight(' ', 36) + juce::String(seconds * 1000.0, 2).paddedLeft(' ', 10) + " ms  "
+            + juce::String(rate / 1.0e6, 2).paddedLeft(' ', 10) + " M" + unit + "/s");
+}
+
+} // namespace serum
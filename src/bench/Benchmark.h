@@ -0,0 +1,64 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace serum {
+
+/**
+ * Wall-clock timer for benchmarks
+ */
+class BenchmarkTimer
+{
+public:
+    BenchmarkTimer() : startTicks(juce::Time::getHighResolutionTicks()) {}
+    
+    double getElapsedSeconds() const
+    {
+        return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+    }
+    
+private:
+    int64 startTicks;
+};
+
+/**
+ * Log one benchmark result line
+ * @param name Benchmark case name
+ * @param seconds Wall time
+ * @param items Work items processed in that time
+ * @param unit Name of the work item (e.g. "samples")
+ */
+void reportBenchmark(const juce::String& name, double seconds, double items, const juce::String& unit);
+
+/**
+ * OfflineRenderer renders/sec and realtime factor with the reference synth,
+ * WavWriter and AudioStats throughput, and allocations on each path
+ */
+bool runRenderBenchmark(const juce::ArgumentList& args);
+
+/**
+ * AudioStats kernels against the original scalar implementation
+ */
+bool runStatsBenchmark(const juce::ArgumentList& args);
+
+/**
+ * SHA-256 and the fast 128-bit hash against juce::SHA256
+ */
+bool runHashBenchmark(const juce::ArgumentList& args);
+
+/**
+ * Per-view cost of lockstep rendering against sequential OfflineRenderer runs
+ */
+bool runLockstepBenchmark(const juce::ArgumentList& args);
+
+/**
+ * Render throughput across block sizes, whole and split at MIDI events
+ */
+bool runBlockSizeBenchmark(const juce::ArgumentList& args);
+
+/**
+ * Shared-memory audio ring throughput between two mappings, in GB/s
+ */
+bool runShmBenchmark(const juce::ArgumentList& args);
+
+} // namespace serum
@@ -0,0 +1,43 @@
+#include "bench/Benchmark.h"
+#include "render/BlockSizeTuner.h"
+#include "vst/ReferenceSynth.h"
+#include "common/Log.h"
+
+namespace serum {
+
+bool runBlockSizeBenchmark(const juce::ArgumentList& args)
+{
+    double seconds = args.getValueForOption("--render-sec").getDoubleValue();
+    if (seconds <= 0.0)
+        seconds = 4.0;
+
+    const double sampleRate = 44100.0;
+    ReferenceSynth synth;
+    BlockSizeTuner tuner(synth);
+    tuner.setCandidates({ 32, 64, 128, 256, 512, 1024, 2048, 4096, 8192 });
+    tuner.setRenderSeconds(seconds);
+
+    logInfo("Block size sweep: " + juce::String(seconds) + "s arpeggio on the reference synth");
+
+    bool ok = true;
+    for (bool split : { false, true })
+    {
+        tuner.setSplitAtEvents(split);
+        int best = tuner.tune(sampleRate);
+        ok = ok && best > 0;
+
+        for (const auto& measurement : tuner.getMeasurements())
+        {
+            auto name = juce::String(split ? "blocksize/split-" : "blocksize/") + juce::String(measurement.blockSize);
+            logInfo(name.paddedRight(' ', 36)
+                    + juce::String(measurement.samplesPerSecond / 1.0e6, 2).paddedLeft(' ', 10) + " Msamples/s  "
+                    + juce::String(measurement.samplesPerSecond / sampleRate, 1).paddedLeft(' ', 8) + "x realtime");
+        }
+
+        logInfo(juce::String("  fastest") + (split ? " (split at events): " : ": ") + juce::String(best));
+    }
+
+    return ok;
+}
+
+} // namespace serum
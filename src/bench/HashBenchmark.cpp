@@ -0,0 +1,61 @@
+#include "bench/Benchmark.h"
+#include "common/Hash.h"
+#include "common/Log.h"
+
+namespace serum {
+
+bool runHashBenchmark(const juce::ArgumentList& args)
+{
+    int megabytes = args.getValueForOption("--hash-mb").getIntValue();
+    if (megabytes <= 0)
+        megabytes = 256;
+
+    const size_t size = static_cast<size_t>(megabytes) * 1024 * 1024;
+    juce::MemoryBlock data(size);
+    juce::Random random(1234);
+    random.fillBitsRandomly(data.getData(), size);
+
+    logInfo("Hash benchmark: " + juce::String(megabytes) + " MB in memory");
+    const double bytes = static_cast<double>(size);
+
+    // Baseline: JUCE's SHA-256, as computeSHA256 used to call it
+    BenchmarkTimer juceTimer;
+    juce::SHA256 juceSha(data.getData(), size);
+    reportBenchmark("hash/juce-sha256", juceTimer.getElapsedSeconds(), bytes, "B");
+
+    BenchmarkTimer shaTimer;
+    SHA256Hasher sha;
+    sha.update(data.getData(), size);
+    auto shaHex = sha.finalizeHex();
+    reportBenchmark("hash/sha256", shaTimer.getElapsedSeconds(), bytes, "B");
+
+    // Incremental in render-block sized pieces (512 stereo float samples)
+    const size_t chunk = 512 * 2 * sizeof(float);
+    auto* bytesIn = static_cast<const char*>(data.getData());
+
+    BenchmarkTimer fastTimer;
+    FastHasher128 fast;
+    for (size_t offset = 0; offset < size; offset += chunk)
+        fast.update(bytesIn + offset, juce::jmin(chunk, size - offset));
+    auto fastHash = fast.finalize();
+    reportBenchmark("hash/fast128-streamed", fastTimer.getElapsedSeconds(), bytes, "B");
+
+    // Results must not depend on how the input was split
+    bool ok = true;
+    if (shaHex != juceSha.toHexString().toStdString())
+    {
+        logError("  sha256 differs from juce::SHA256");
+        ok = false;
+    }
+
+    if (fastHash != computeFastHash128(data.getData(), size))
+    {
+        logError("  streamed fast128 differs from one-shot");
+        ok = false;
+    }
+
+    logInfo("  fast128: " + fastHash.toHexString());
+    return ok;
+}
+
+} // namespace serum
@@ -0,0 +1,120 @@
+#include "bench/Benchmark.h"
+#include "render/LockstepRenderer.h"
+#include "render/OfflineRenderer.h"
+#include "midi/SyntheticMidiGenerator.h"
+#include "vst/ReferenceSynth.h"
+#include "common/Log.h"
+#include <memory>
+#include <vector>
+
+namespace serum {
+
+namespace {
+
+const double sampleRate = 44100.0;
+const int blockSize = 512;
+const double warmupSec = 0.2;
+const double renderSec = 2.0;
+const double tailSec = 1.0;
+
+const char* const noteNames[] = { "C3", "E3", "G3", "C4", "E4", "G4", "C5", "E5" };
+
+struct View
+{
+    std::unique_ptr<SyntheticMidiGenerator> midi;
+    NullSink nullSink;
+    std::unique_ptr<HashingSink> hashingSink;
+
+    View(const juce::String& noteName, int velocity)
+        : midi(std::make_unique<SyntheticMidiGenerator>(noteName, velocity, renderSec, sampleRate))
+        , hashingSink(std::make_unique<HashingSink>(nullSink))
+    {
+        midi->generate();
+    }
+};
+
+} // namespace
+
+bool runLockstepBenchmark(const juce::ArgumentList& args)
+{
+    int numViews = args.getValueForOption("--views").getIntValue();
+    if (numViews <= 0)
+        numViews = 4;
+
+    int rounds = args.getValueForOption("--rounds").getIntValue();
+    if (rounds <= 0)
+        rounds = 8;
+
+    logInfo("Lockstep benchmark: " + juce::String(rounds) + " rounds of " + juce::String(numViews)
+            + " views (reference synth, " + juce::String(renderSec) + "s + " + juce::String(tailSec) + "s tail)");
+
+    std::vector<std::unique_ptr<View>> views;
+    for (int i = 0; i < numViews; ++i)
+        views.push_back(std::make_unique<View>(noteNames[i % 8], 40 + (i * 29) % 88));
+
+    // Sequential baseline: one instance, one OfflineRenderer per view
+    ReferenceSynth sequentialSynth;
+    RenderSession sequentialSession(sequentialSynth);
+    std::vector<Hash128> sequentialHashes(static_cast<size_t>(numViews));
+    int64 samplesPerView = 0;
+
+    BenchmarkTimer sequentialTimer;
+    for (int round = 0; round < rounds; ++round)
+    {
+        for (int i = 0; i < numViews; ++i)
+        {
+            auto& view = *views[static_cast<size_t>(i)];
+            OfflineRenderer renderer(sequentialSession, *view.midi, sampleRate, blockSize, renderSec, tailSec, warmupSec);
+            AudioStats stats;
+            renderer.render(*view.hashingSink, stats);
+            sequentialHashes[static_cast<size_t>(i)] = view.hashingSink->getAudioHash();
+            samplesPerView = view.nullSink.getNumSamplesWritten();
+        }
+    }
+    double sequentialSeconds = sequentialTimer.getElapsedSeconds();
+    sequentialSession.release();
+
+    // Lockstep: one instance per view on a shared block clock
+    std::vector<std::unique_ptr<ReferenceSynth>> synths;
+    std::vector<std::unique_ptr<RenderSession>> sessions;
+    LockstepRenderer lockstep(sampleRate, blockSize, renderSec, tailSec, warmupSec);
+    for (int i = 0; i < numViews; ++i)
+    {
+        synths.push_back(std::make_unique<ReferenceSynth>());
+        sessions.push_back(std::make_unique<RenderSession>(*synths.back()));
+        auto& view = *views[static_cast<size_t>(i)];
+        lockstep.addLane(*sessions.back(), *view.midi, *view.hashingSink);
+    }
+
+    bool ok = true;
+    BenchmarkTimer lockstepTimer;
+    for (int round = 0; round < rounds; ++round)
+        ok = lockstep.render() && ok;
+    double lockstepSeconds = lockstepTimer.getElapsedSeconds();
+
+    for (auto& session : sessions)
+        session->release();
+
+    const double totalViews = static_cast<double>(rounds) * numViews;
+    const double samples = totalViews * static_cast<double>(samplesPerView);
+    reportBenchmark("lockstep/sequential", sequentialSeconds, samples, "samples");
+    reportBenchmark("lockstep/lockstep-" + juce::String(numViews), lockstepSeconds, samples, "samples");
+
+    logInfo("  per view: sequential " + juce::String(sequentialSeconds * 1000.0 / totalViews, 3)
+            + " ms, lockstep " + juce::String(lockstepSeconds * 1000.0 / totalViews, 3) + " ms ("
+            + juce::String(sequentialSeconds / juce::jmax(lockstepSeconds, 1.0e-9), 2) + "x)");
+
+    // Instances are independent, so every view must match its sequential render
+    for (int i = 0; i < numViews; ++i)
+    {
+        if (!(views[static_cast<size_t>(i)]->hashingSink->getAudioHash() == sequentialHashes[static_cast<size_t>(i)]))
+        {
+            logError("  lockstep view " + juce::String(i) + " differs from the sequential render");
+            ok = false;
+        }
+    }
+
+    return ok;
+}
+
+} // namespace serum
@@ -0,0 +1,318 @@
+#include "bench/Benchmark.h"
+#include "bench/AllocationCounter.h"
+#include "render/OfflineRenderer.h"
+#include "render/RenderSession.h"
+#include "render/WavWriter.h"
+#include "render/AudioStats.h"
+#include "midi/MidiTimeline.h"
+#include "midi/SyntheticMidiGenerator.h"
+#include "vst/ReferenceSynth.h"
+#include "common/Log.h"
+
+namespace serum {
+
+namespace {
+
+const double sampleRate = 44100.0;
+const int blockSize = 512;
+const double warmupSec = 0.2;
+const double renderSec = 2.0;
+const double tailSec = 1.0;
+
+void fillTestBlock(juce::AudioBuffer<float>& block)
+{
+    juce::Random random(42);
+    for (int ch = 0; ch < block.getNumChannels(); ++ch)
+    {
+        float* data = block.getWritePointer(ch);
+        for (int i = 0; i < block.getNumSamples(); ++i)
+            data[i] = 0.5f * std::sin(0.02f * static_cast<float>(i)) + 0.2f * (random.nextFloat() - 0.5f);
+    }
+}
+
+void reportAllocations(const juce::String& what, int64 allocations, int64 steps, const juce::String& stepName)
+{
+    auto line = "  allocations (" + what + "): " + juce::String(allocations) + " over "
+              + juce::String(steps) + " " + stepName;
+
+    if (allocations == 0)
+        logInfo(line);
+    else
+        logWarning(line);
+}
+
+/**
+ * OfflineRenderer with the reference synth into a NullSink
+ */
+bool benchmarkOfflineRenderer(int numRenders, int numHarmonics)
+{
+    ReferenceSynth synth;
+    synth.setNumHarmonics(numHarmonics);
+    RenderSession session(synth);
+
+    SyntheticMidiGenerator midi("C4", 100, renderSec, sampleRate);
+    midi.generate();
+
+    OfflineRenderer renderer(session, midi, sampleRate, blockSize, renderSec, tailSec, warmupSec);
+    NullSink sink;
+    AudioStats stats;
+
+    // Untimed: prepareToPlay and first-touch allocations
+    if (!renderer.render(sink, stats))
+        return false;
+
+    bool ok = true;
+    ScopedAllocationCounter allocations;
+    BenchmarkTimer timer;
+    for (int i = 0; i < numRenders; ++i)
+        ok = renderer.render(sink, stats) && ok;
+    double seconds = timer.getElapsedSeconds();
+    int64 allocationCount = allocations.getCount();
+
+    session.release();
+
+    // Warmup samples are processed too, so they count towards the realtime factor
+    const double audioSecondsPerRender = warmupSec + renderSec + tailSec;
+    const double samples = static_cast<double>(numRenders) * audioSecondsPerRender * sampleRate;
+
+    reportBenchmark("render/offline-" + juce::String(numHarmonics) + "h", seconds, samples, "samples");
+    logInfo("  renders/sec: " + juce::String(numRenders / juce::jmax(seconds, 1.0e-9), 2)
+            + ", realtime factor: " + juce::String(numRenders * audioSecondsPerRender / juce::jmax(seconds, 1.0e-9), 1) + "x");
+
+    // Logging allocates a fixed amount per render; the block loop should not
+    logInfo("  allocations per render: " + juce::String(static_cast<double>(allocationCount) / numRenders, 1));
+    return ok;
+}
+
+/**
+ * RenderSession steady state: processing blocks with MIDI events and the
+ * reset between renders must not allocate. Fails the suite if they do.
+ */
+bool checkSessionAllocations(int numBlocks)
+{
+    ReferenceSynth synth;
+    RenderSession session(synth);
+    session.prepare(sampleRate, blockSize);
+
+    auto& block = session.getBuffer();
+    auto& midi = session.getMidiBuffer();
+    const auto noteOn = juce::MidiMessage::noteOn(1, 60, static_cast<juce::uint8>(100));
+    const auto noteOff = juce::MidiMessage::noteOff(1, 60);
+
+    // A note every eight blocks, released mid-block, and a reset every 64
+    auto processBlock = [&](int i)
+    {
+        midi.clear();
+        if (i % 8 == 0)
+            midi.addEvent(noteOn, blockSize / 4);
+        else if (i % 8 == 4)
+            midi.addEvent(noteOff, blockSize / 2);
+
+        block.clear();
+        session.processSplitAtEvents(block, midi);
+
+        if (i % 64 == 63)
+            session.resetForNextRender();
+    };
+
+    // Not counted: first-touch growth
+    for (int i = 0; i < 64; ++i)
+        processBlock(i);
+
+    ScopedAllocationCounter allocations;
+    for (int i = 0; i < numBlocks; ++i)
+        processBlock(i);
+    int64 allocationCount = allocations.getCount();
+
+    session.release();
+
+    reportAllocations("RenderSession", allocationCount, numBlocks, "blocks");
+    if (allocationCount != 0)
+        logError("  RenderSession allocates in steady state");
+
+    return allocationCount == 0;
+}
+
+/**
+ * Steady-state renders must not allocate: MidiTimeline::popEvents over a busy
+ * pattern, and OfflineRenderer::render through a persistent session into a
+ * NullSink. Enabled log lines allocate by design, so logging is limited to
+ * warnings while counting. Fails the suite if either path allocates.
+ */
+bool checkRenderAllocations(int numRenders)
+{
+    const auto previousLogLevel = getLogLevel();
+    setLogLevel(LogLevel::Warning);
+
+    // Arpeggio under a filter sweep, popped block by block like a render does
+    const auto lengthSamples = static_cast<int64>(renderSec * sampleRate);
+    const juce::Array<int> chord { 60, 64, 67, 72 };
+    MidiTimeline timeline;
+    timeline.addArpeggio(1, chord, 100, 0, lengthSamples - 1, 2205, 0.5,
+                         MidiTimeline::ArpeggioDirection::UpDown);
+    timeline.addControllerRamp(1, 74, 0, 127, 0, lengthSamples - 1, 44);
+    timeline.compile();
+
+    juce::MidiBuffer midi;
+    midi.ensureSize(4096);
+    const int64 numBlocks = (lengthSamples + blockSize - 1) / blockSize;
+    auto popAll = [&]
+    {
+        timeline.reset();
+        for (int64 i = 0; i < numBlocks; ++i)
+            timeline.popEvents(i * blockSize, blockSize, midi);
+    };
+
+    // Not counted: first-touch growth
+    popAll();
+
+    int64 timelineAllocations;
+    {
+        ScopedAllocationCounter allocations;
+        for (int i = 0; i < numRenders; ++i)
+            popAll();
+        timelineAllocations = allocations.getCount();
+    }
+
+    ReferenceSynth synth;
+    RenderSession session(synth);
+    SyntheticMidiGenerator generator("C4", 100, renderSec, sampleRate);
+    generator.generate();
+
+    OfflineRenderer renderer(session, generator, sampleRate, blockSize, renderSec, tailSec, warmupSec);
+    NullSink sink;
+    AudioStats stats;
+
+    // Not counted: prepareToPlay and first-touch growth
+    bool ok = renderer.render(sink, stats);
+
+    int64 renderAllocations;
+    {
+        ScopedAllocationCounter allocations;
+        for (int i = 0; i < numRenders; ++i)
+            ok = renderer.render(sink, stats) && ok;
+        renderAllocations = allocations.getCount();
+    }
+
+    session.release();
+    setLogLevel(previousLogLevel);
+
+    reportAllocations("MidiTimeline::popEvents", timelineAllocations, numRenders * numBlocks, "blocks");
+    reportAllocations("OfflineRenderer::render", renderAllocations, numRenders, "renders");
+
+    if (timelineAllocations != 0)
+        logError("  MidiTimeline::popEvents allocates in steady state");
+    if (renderAllocations != 0)
+        logError("  OfflineRenderer::render allocates in steady state");
+
+    return ok && timelineAllocations == 0 && renderAllocations == 0;
+}
+
+/**
+ * WavWriter throughput and steady-state allocations per sample format
+ */
+bool benchmarkWavWriter(int megabytes)
+{
+    juce::AudioBuffer<float> block(2, blockSize);
+    fillTestBlock(block);
+
+    const int64 bytesPerBlock = static_cast<int64>(blockSize) * 2 * static_cast<int64>(sizeof(float));
+    const int64 numBlocks = juce::jmax<int64>(1, static_cast<int64>(megabytes) * 1024 * 1024 / bytesPerBlock);
+    const auto tempDir = juce::File::getSpecialLocation(juce::File::tempDirectory);
+
+    bool ok = true;
+    for (auto format : { SampleFormat::Pcm16, SampleFormat::Pcm24, SampleFormat::Float32,
+                         SampleFormat::RawFloat32, SampleFormat::Npy })
+    {
+        auto file = tempDir.getChildFile(juce::String("render_benchmark_") + getSampleFormatName(format)
+                                         + getSampleFormatExtension(format));
+
+        WavWriter writer;
+        if (!writer.open(file, sampleRate, 2, format, blockSize))
+        {
+            logError(juce::String("  cannot open ") + file.getFullPathName());
+            ok = false;
+            continue;
+        }
+
+        // First block outside the measurement, it may grow internal buffers
+        writer.writeBlock(block);
+
+        ScopedAllocationCounter allocations;
+        BenchmarkTimer timer;
+        for (int64 i = 1; i < numBlocks; ++i)
+            ok = writer.writeBlock(block) && ok;
+        int64 allocationCount = allocations.getCount();
+        writer.close();
+        double seconds = timer.getElapsedSeconds();
+
+        // Rate in float input bytes, independent of the encoding
+        auto name = juce::String("io/wav-") + getSampleFormatName(format);
+        reportBenchmark(name, seconds, static_cast<double>((numBlocks - 1) * bytesPerBlock), "B");
+        logInfo("  file size: " + juce::String(file.getSize() / (1024 * 1024)) + " MB");
+        reportAllocations(getSampleFormatName(format), allocationCount, numBlocks - 1, "blocks");
+
+        file.deleteFile();
+    }
+
+    return ok;
+}
+
+/**
+ * AudioStats with the selected kernel, steady-state allocations
+ */
+bool benchmarkAudioStats(int numBlocks)
+{
+    juce::AudioBuffer<float> block(2, blockSize);
+    fillTestBlock(block);
+
+    AudioStats stats;
+    stats.updateBlock(block);
+
+    ScopedAllocationCounter allocations;
+    BenchmarkTimer timer;
+    for (int i = 0; i < numBlocks; ++i)
+        stats.updateBlock(block);
+    double seconds = timer.getElapsedSeconds();
+    int64 allocationCount = allocations.getCount();
+    stats.finalize();
+
+    reportBenchmark(juce::String("stats/") + getStatsKernelName(AudioStats::getKernel()),
+                    seconds, static_cast<double>(numBlocks) * blockSize * 2, "samples");
+    reportAllocations("AudioStats", allocationCount, numBlocks, "blocks");
+    return allocationCount == 0;
+}
+
+} // namespace
+
+bool runRenderBenchmark(const juce::ArgumentList& args)
+{
+    int numRenders = args.getValueForOption("--renders").getIntValue();
+    if (numRenders <= 0)
+        numRenders = 20;
+
+    int ioMegabytes = args.getValueForOption("--io-mb").getIntValue();
+    if (ioMegabytes <= 0)
+        ioMegabytes = 256;
+
+    int numBlocks = args.getValueForOption("--blocks").getIntValue();
+    if (numBlocks <= 0)
+        numBlocks = 20000;
+
+    logInfo("Render throughput benchmark: " + juce::String(numRenders) + " renders of "
+            + juce::String(warmupSec + renderSec + tailSec) + "s, " + juce::String(ioMegabytes) + " MB per format");
+
+    bool ok = true;
+
+    // Light and heavy stand-ins for a real patch
+    for (int harmonics : { 1, 16 })
+        ok = benchmarkOfflineRenderer(numRenders, harmonics) && ok;
+
+    ok = checkSessionAllocations(numBlocks) && ok;
+    ok = checkRenderAllocations(numRenders) && ok;
+    ok = benchmarkWavWriter(ioMegabytes) && ok;
+    ok = benchmarkAudioStats(numBlocks) && ok;
+    return ok;
+}
+
+} // namespace serum
@@ -0,0 +1,116 @@
+#include "bench/Benchmark.h"
+#include "bench/AllocationCounter.h"
+#include "render/ShmAudioRing.h"
+#include "common/Log.h"
+#include <thread>
+
+namespace serum {
+
+namespace {
+
+/**
+ * Stream numBlocks stereo blocks from a producer thread to this thread
+ * The two sides map the ring separately, as a worker process and its
+ * consumer would; the consumer reads every block in place
+ */
+bool benchmarkRing(int blockSize, int64 numBlocks, int numSlots)
+{
+    juce::String errorMsg;
+    auto consumer = ShmAudioRing::create(ShmAudioRing::makeUniqueName("bench"), numSlots, 2, blockSize, errorMsg);
+    auto producer = consumer != nullptr ? ShmAudioRing::open(consumer->getName(), errorMsg) : nullptr;
+    if (producer == nullptr)
+    {
+        logError("  cannot set up ring: " + errorMsg);
+        return false;
+    }
+
+    juce::AudioBuffer<float> block(2, blockSize);
+    block.clear();
+
+    bool producerOk = true;
+    int64 producerAllocations = 0;
+
+    BenchmarkTimer timer;
+    std::thread producerThread([&]
+    {
+        ScopedAllocationCounter allocations;
+        for (int64 i = 0; i < numBlocks && producerOk; ++i)
+        {
+            // Sequence number in the first sample, checked by the consumer
+            block.setSample(0, 0, static_cast<float>(i & 0xffff));
+            producerOk = producer->writeBlock(1, block);
+        }
+        producerAllocations = allocations.getCount();
+    });
+
+    bool ok = true;
+    float checksum = 0.0f;
+    ShmMessage message;
+    for (int64 i = 0; i < numBlocks; ++i)
+    {
+        if (!consumer->read(message, 5000))
+        {
+            logError("  consumer timed out after " + juce::String(i) + " blocks");
+            ok = false;
+            break;
+        }
+
+        if (message.audio.getNumSamples() != blockSize
+            || message.audio.getSample(0, 0) != static_cast<float>(i & 0xffff))
+            ok = false;
+
+        checksum += message.audio.getSample(1, blockSize - 1);
+        consumer->release();
+    }
+
+    producerThread.join();
+    double seconds = timer.getElapsedSeconds();
+
+    const double bytes = static_cast<double>(numBlocks) * blockSize * 2 * sizeof(float);
+    auto name = "shm/ring-" + juce::String(blockSize);
+    reportBenchmark(name, seconds, static_cast<double>(numBlocks), "blocks");
+    logInfo("  throughput: " + juce::String(bytes / juce::jmax(seconds, 1.0e-9) / 1.0e9, 2) + " GB/s ("
+            + juce::String(static_cast<double>(consumer->getMappedBytes()) / (1024.0 * 1024.0), 2) + " MB ring, "
+            + juce::String(consumer->getNumSlots()) + " slots)");
+
+    if (producerAllocations != 0)
+        logWarning("  producer allocations: " + juce::String(producerAllocations) + " over "
+                   + juce::String(numBlocks) + " blocks");
+
+    if (!ok || !producerOk || checksum != 0.0f)
+    {
+        logError("  " + name + ": blocks lost, reordered or corrupted");
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace
+
+bool runShmBenchmark(const juce::ArgumentList& args)
+{
+    if (!ShmAudioRing::isSupported())
+    {
+        logInfo("shm: shared-memory rings are not supported on this platform");
+        return true;
+    }
+
+    int megabytes = args.getValueForOption("--shm-mb").getIntValue();
+    if (megabytes <= 0)
+        megabytes = 2048;
+
+    logInfo("Shared-memory ring benchmark: " + juce::String(megabytes) + " MB of stereo float blocks per case");
+
+    bool ok = true;
+    for (int blockSize : { 512, 4096 })
+    {
+        const int64 bytesPerBlock = static_cast<int64>(blockSize) * 2 * static_cast<int64>(sizeof(float));
+        const int64 numBlocks = juce::jmax<int64>(1, static_cast<int64>(megabytes) * 1024 * 1024 / bytesPerBlock);
+        ok = benchmarkRing(blockSize, numBlocks, 32) && ok;
+    }
+
+    return ok;
+}
+
+} // namespace serum
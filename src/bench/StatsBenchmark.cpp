@@ -0,0 +1,124 @@
+#include "bench/Benchmark.h"
+#include "render/AudioStats.h"
+#include "common/Log.h"
+#include <cmath>
+
+namespace serum {
+
+namespace {
+
+/**
+ * The original per-sample scalar loop, kept as the benchmark baseline
+ */
+struct LegacyStats
+{
+    float peakL = 0.0f;
+    float peakR = 0.0f;
+    double sumSquaresL = 0.0;
+    double sumSquaresR = 0.0;
+
+    void updateBlock(const juce::AudioBuffer<float>& block)
+    {
+        int numSamples = block.getNumSamples();
+
+        const float* leftData = block.getReadPointer(0);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float sample = std::abs(leftData[i]);
+            peakL = std::max(peakL, sample);
+            sumSquaresL += sample * sample;
+        }
+
+        const float* rightData = block.getReadPointer(1);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float sample = std::abs(rightData[i]);
+            peakR = std::max(peakR, sample);
+            sumSquaresR += sample * sample;
+        }
+    }
+};
+
+void fillTestSignal(juce::AudioBuffer<float>& buffer)
+{
+    juce::Random random(1234);
+    for (int ch = 0; ch < buffer.getNumChannels(); ++ch)
+    {
+        float* data = buffer.getWritePointer(ch);
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            data[i] = 0.8f * std::sin(0.013f * static_cast<float>(i + ch * 7))
+                    + 0.3f * (random.nextFloat() - 0.5f);
+    }
+}
+
+} // namespace
+
+bool runStatsBenchmark(const juce::ArgumentList& args)
+{
+    const int blockSize = 512;
+    int iterations = args.getValueForOption("--blocks").getIntValue();
+    if (iterations <= 0)
+        iterations = 20000;
+    const double samples = static_cast<double>(iterations) * blockSize * 2;
+
+    juce::AudioBuffer<float> block(2, blockSize);
+    fillTestSignal(block);
+
+    logInfo("AudioStats benchmark: " + juce::String(iterations) + " stereo blocks of " + juce::String(blockSize));
+
+    // Baseline: original implementation (peak + sum of squares only)
+    LegacyStats legacy;
+    BenchmarkTimer legacyTimer;
+    for (int i = 0; i < iterations; ++i)
+        legacy.updateBlock(block);
+    double legacySeconds = legacyTimer.getElapsedSeconds();
+    reportBenchmark("stats/legacy-scalar", legacySeconds, samples, "samples");
+
+    // Every available kernel, full feature set, checked against scalar
+    const auto previousKernel = AudioStats::getKernel();
+    AudioStats reference;
+    bool ok = true;
+
+    for (auto type : { StatsKernelType::Scalar, StatsKernelType::SSE2, StatsKernelType::AVX })
+    {
+        if (!isStatsKernelAvailable(type))
+        {
+            logInfo(juce::String("stats/") + getStatsKernelName(type) + ": not supported on this CPU");
+            continue;
+        }
+
+        AudioStats::setKernel(type);
+        AudioStats stats;
+
+        BenchmarkTimer timer;
+        for (int i = 0; i < iterations; ++i)
+            stats.updateBlock(block);
+        double seconds = timer.getElapsedSeconds();
+        stats.finalize();
+
+        reportBenchmark(juce::String("stats/") + getStatsKernelName(type), seconds, samples, "samples");
+        logInfo("  speedup vs legacy: " + juce::String(legacySeconds / juce::jmax(seconds, 1.0e-9), 2) + "x");
+
+        if (type == StatsKernelType::Scalar)
+        {
+            reference = stats;
+        }
+        else if (stats.peakL != reference.peakL
+                 || stats.zeroCrossingsL != reference.zeroCrossingsL
+                 || stats.clippedSamplesL != reference.clippedSamplesL
+                 || std::abs(stats.rmsL - reference.rmsL) > 1.0e-4f * reference.rmsL
+                 || std::abs(stats.truePeakL - reference.truePeakL) > 1.0e-5f)
+        {
+            logError(juce::String("  ") + getStatsKernelName(type) + " results differ from scalar");
+            ok = false;
+        }
+    }
+
+    AudioStats::setKernel(previousKernel);
+
+    // Keep the legacy loop observable so it is not optimized away
+    logInfo("  legacy peak L/R: " + juce::String(legacy.peakL, 4) + " / " + juce::String(legacy.peakR, 4));
+    return ok;
+}
+
+} // namespace serum
@@ -2,23 +2,352 @@
 
 namespace serum {
 
-std::string computeSHA256(const void* data, size_t size)
+namespace {
+
+inline uint32 rotr32(uint32 x, int n) { return (x >> n) | (x << (32 - n)); }
+inline uint64 rotl64(uint64 x, int n) { return (x << n) | (x >> (64 - n)); }
+
+const uint32 sha256RoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+const uint64 murmurC1 = 0x87c37b91114253d5ULL;
+const uint64 murmurC2 = 0x4cf5ad432745937fULL;
+
+inline uint64 murmurMix(uint64 k)
 {
-    juce::SHA256 sha256(data, size);
-    return sha256.toHexString().toStdString();
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53ULL;
+    k ^= k >> 33;
+    return k;
 }
 
-std::string computeSHA256FromFile(const juce::File& file)
+inline void murmurBlock(const uint8* block, uint64& h1, uint64& h2)
+{
+    uint64 k1 = juce::ByteOrder::littleEndianInt64(block);
+    uint64 k2 = juce::ByteOrder::littleEndianInt64(block + 8);
+
+    k1 *= murmurC1; k1 = rotl64(k1, 31); k1 *= murmurC2; h1 ^= k1;
+    h1 = rotl64(h1, 27); h1 += h2; h1 = h1 * 5 + 0x52dce729;
+
+    k2 *= murmurC2; k2 = rotl64(k2, 33); k2 *= murmurC1; h2 ^= k2;
+    h2 = rotl64(h2, 31); h2 += h1; h2 = h2 * 5 + 0x38495ab5;
+}
+
+std::string toHex(const uint8* bytes, size_t size)
+{
+    static const char digits[] = "0123456789abcdef";
+
+    std::string hex(size * 2, '0');
+    for (size_t i = 0; i < size; ++i)
+    {
+        hex[i * 2] = digits[bytes[i] >> 4];
+        hex[i * 2 + 1] = digits[bytes[i] & 0x0f];
+    }
+
+    return hex;
+}
+
+/**
+ * Feed a whole file to a hasher, memory-mapped when possible
+ * The first headerSize bytes are fed last (see computeFastHash128FromFile())
+ */
+template <typename Hasher>
+bool hashFile(const juce::File& file, Hasher& hasher, int64 headerSize = 0)
 {
     if (!file.existsAsFile())
-        return "";
-    
+        return false;
+
+    const auto fileSize = file.getSize();
+    if (headerSize < 0 || headerSize > fileSize)
+        return false;
+
+    if (fileSize == 0)
+        return true;
+
+    juce::MemoryMappedFile mapped(file, juce::MemoryMappedFile::readOnly);
+    if (mapped.getData() != nullptr)
+    {
+        auto* bytes = static_cast<const uint8*>(mapped.getData());
+        hasher.update(bytes + headerSize, mapped.getSize() - static_cast<size_t>(headerSize));
+        hasher.update(bytes, static_cast<size_t>(headerSize));
+        return true;
+    }
+
+    // Mapping can fail (e.g. address space on 32-bit hosts); stream instead
     juce::FileInputStream stream(file);
-    if (!stream.openedOk())
+    if (!stream.openedOk() || !stream.setPosition(headerSize))
+        return false;
+
+    juce::HeapBlock<char> chunk(1 << 20);
+    for (;;)
+    {
+        auto bytesRead = stream.read(chunk.get(), 1 << 20);
+        if (bytesRead <= 0)
+            break;
+
+        hasher.update(chunk.get(), static_cast<size_t>(bytesRead));
+    }
+
+    if (!stream.isExhausted())
+        return false;
+
+    // Headers are small; one read
+    juce::HeapBlock<char> header(static_cast<size_t>(juce::jmax<int64>(1, headerSize)));
+    if (!stream.setPosition(0)
+        || stream.read(header.get(), static_cast<int>(headerSize)) != static_cast<int>(headerSize))
+        return false;
+
+    hasher.update(header.get(), static_cast<size_t>(headerSize));
+    return true;
+}
+
+} // namespace
+
+SHA256Hasher::SHA256Hasher()
+{
+    reset();
+}
+
+void SHA256Hasher::reset()
+{
+    static const uint32 initialState[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+    };
+
+    std::memcpy(state, initialState, sizeof(state));
+    bufferSize = 0;
+    totalBytes = 0;
+}
+
+void SHA256Hasher::processBlock(const uint8* block)
+{
+    uint32 w[64];
+    for (int i = 0; i < 16; ++i)
+        w[i] = juce::ByteOrder::bigEndianInt(block + i * 4);
+
+    for (int i = 16; i < 64; ++i)
+    {
+        uint32 s0 = rotr32(w[i - 15], 7) ^ rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+        uint32 s1 = rotr32(w[i - 2], 17) ^ rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+        w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+    }
+
+    uint32 a = state[0], b = state[1], c = state[2], d = state[3];
+    uint32 e = state[4], f = state[5], g = state[6], h = state[7];
+
+    for (int i = 0; i < 64; ++i)
+    {
+        uint32 s1 = rotr32(e, 6) ^ rotr32(e, 11) ^ rotr32(e, 25);
+        uint32 choose = (e & f) ^ (~e & g);
+        uint32 t1 = h + s1 + choose + sha256RoundConstants[i] + w[i];
+        uint32 s0 = rotr32(a, 2) ^ rotr32(a, 13) ^ rotr32(a, 22);
+        uint32 majority = (a & b) ^ (a & c) ^ (b & c);
+        uint32 t2 = s0 + majority;
+
+        h = g; g = f; f = e; e = d + t1;
+        d = c; c = b; b = a; a = t1 + t2;
+    }
+
+    state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+    state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+}
+
+void SHA256Hasher::update(const void* data, size_t size)
+{
+    auto* bytes = static_cast<const uint8*>(data);
+    totalBytes += size;
+
+    if (bufferSize > 0)
+    {
+        size_t take = juce::jmin(size, sizeof(buffer) - bufferSize);
+        std::memcpy(buffer + bufferSize, bytes, take);
+        bufferSize += take;
+        bytes += take;
+        size -= take;
+
+        if (bufferSize < sizeof(buffer))
+            return;
+
+        processBlock(buffer);
+        bufferSize = 0;
+    }
+
+    // Whole blocks straight from the input
+    for (; size >= 64; bytes += 64, size -= 64)
+        processBlock(bytes);
+
+    std::memcpy(buffer, bytes, size);
+    bufferSize = size;
+}
+
+void SHA256Hasher::finalize(uint8* digest)
+{
+    uint64 bitLength = totalBytes * 8;
+
+    // Padding: 0x80, zeros up to 56 mod 64, then the big-endian bit length
+    static const uint8 padding[64] = { 0x80 };
+    size_t padSize = bufferSize < 56 ? 56 - bufferSize : 120 - bufferSize;
+    update(padding, padSize);
+
+    uint8 lengthBytes[8];
+    for (int i = 0; i < 8; ++i)
+        lengthBytes[i] = static_cast<uint8>(bitLength >> (56 - i * 8));
+    update(lengthBytes, sizeof(lengthBytes));
+
+    for (int i = 0; i < 8; ++i)
+        for (int j = 0; j < 4; ++j)
+            digest[i * 4 + j] = static_cast<uint8>(state[i] >> (24 - j * 8));
+
+    reset();
+}
+
+std::string SHA256Hasher::finalizeHex()
+{
+    uint8 digest[32];
+    finalize(digest);
+    return toHex(digest, sizeof(digest));
+}
+
+juce::String Hash128::toHexString() const
+{
+    uint8 bytes[16];
+    for (int i = 0; i < 8; ++i)
+    {
+        bytes[i] = static_cast<uint8>(low >> (i * 8));
+        bytes[i + 8] = static_cast<uint8>(high >> (i * 8));
+    }
+
+    return juce::String(toHex(bytes, sizeof(bytes)));
+}
+
+FastHasher128::FastHasher128(uint64 seed)
+    : seed(seed)
+{
+    reset();
+}
+
+void FastHasher128::reset()
+{
+    h1 = h2 = seed;
+    bufferSize = 0;
+    totalBytes = 0;
+}
+
+void FastHasher128::update(const void* data, size_t size)
+{
+    auto* bytes = static_cast<const uint8*>(data);
+    totalBytes += size;
+
+    if (bufferSize > 0)
+    {
+        size_t take = juce::jmin(size, sizeof(buffer) - bufferSize);
+        std::memcpy(buffer + bufferSize, bytes, take);
+        bufferSize += take;
+        bytes += take;
+        size -= take;
+
+        if (bufferSize < sizeof(buffer))
+            return;
+
+        murmurBlock(buffer, h1, h2);
+        bufferSize = 0;
+    }
+
+    for (; size >= 16; bytes += 16, size -= 16)
+        murmurBlock(bytes, h1, h2);
+
+    std::memcpy(buffer, bytes, size);
+    bufferSize = size;
+}
+
+Hash128 FastHasher128::finalize()
+{
+    uint64 k1 = 0, k2 = 0;
+
+    for (size_t i = bufferSize; i > 8; --i)
+        k2 ^= static_cast<uint64>(buffer[i - 1]) << ((i - 9) * 8);
+
+    for (size_t i = juce::jmin(bufferSize, static_cast<size_t>(8)); i > 0; --i)
+        k1 ^= static_cast<uint64>(buffer[i - 1]) << ((i - 1) * 8);
+
+    if (bufferSize > 8)
+    {
+        k2 *= murmurC2; k2 = rotl64(k2, 33); k2 *= murmurC1; h2 ^= k2;
+    }
+
+    if (bufferSize > 0)
+    {
+        k1 *= murmurC1; k1 = rotl64(k1, 31); k1 *= murmurC2; h1 ^= k1;
+    }
+
+    h1 ^= totalBytes;
+    h2 ^= totalBytes;
+    h1 += h2;
+    h2 += h1;
+    h1 = murmurMix(h1);
+    h2 = murmurMix(h2);
+    h1 += h2;
+    h2 += h1;
+
+    Hash128 result;
+    result.low = h1;
+    result.high = h2;
+
+    reset();
+    return result;
+}
+
+std::string computeSHA256(const void* data, size_t size)
+{
+    SHA256Hasher hasher;
+    hasher.update(data, size);
+    return hasher.finalizeHex();
+}
+
+std::string computeSHA256FromFile(const juce::File& file)
+{
+    SHA256Hasher hasher;
+    if (!hashFile(file, hasher))
         return "";
     
-    juce::SHA256 sha256(stream);
-    return sha256.toHexString().toStdString();
+    return hasher.finalizeHex();
+}
+
+Hash128 computeFastHash128(const void* data, size_t size)
+{
+    FastHasher128 hasher;
+    hasher.update(data, size);
+    return hasher.finalize();
+}
+
+bool computeFastHash128FromFile(const juce::File& file, Hash128& result)
+{
+    FastHasher128 hasher;
+    if (!hashFile(file, hasher))
+        return false;
+
+    result = hasher.finalize();
+    return true;
+}
+
+bool computeFastHash128FromFile(const juce::File& file, int64 headerSize, Hash128& result)
+{
+    FastHasher128 hasher;
+    if (!hashFile(file, hasher, headerSize))
+        return false;
+
+    result = hasher.finalize();
+    return true;
 }
 
 } // namespace serum
@@ -5,6 +5,85 @@
 
 namespace serum {
 
+/**
+ * Incremental SHA-256
+ * Feed data in any number of update() calls; the digest does not depend on
+ * how the input was split. Use for archival manifests and anything that must
+ * survive adversarial input; see FastHasher128 for cache keys.
+ */
+class SHA256Hasher
+{
+public:
+    SHA256Hasher();
+
+    void update(const void* data, size_t size);
+
+    /**
+     * Finish and return the 32-byte digest; the hasher is reset afterwards
+     */
+    void finalize(uint8* digest);
+
+    /**
+     * Finish and return the digest as lowercase hex
+     */
+    std::string finalizeHex();
+
+    void reset();
+
+private:
+    uint32 state[8];
+    uint8 buffer[64];
+    size_t bufferSize;
+    uint64 totalBytes;
+
+    void processBlock(const uint8* block);
+};
+
+/**
+ * 128-bit hash value
+ */
+struct Hash128
+{
+    uint64 low = 0;
+    uint64 high = 0;
+
+    bool operator==(const Hash128& other) const { return low == other.low && high == other.high; }
+    bool operator!=(const Hash128& other) const { return !(*this == other); }
+
+    /**
+     * 32 lowercase hex digits of the 16 little-endian digest bytes, low word
+     * first (the byte order of the reference MurmurHash3 output)
+     */
+    juce::String toHexString() const;
+};
+
+/**
+ * Incremental non-cryptographic 128-bit hash (MurmurHash3 x64_128)
+ * Several GB/s per core; collisions are astronomically unlikely for honest
+ * input, which is all cache keys and output verification need.
+ */
+class FastHasher128
+{
+public:
+    explicit FastHasher128(uint64 seed = 0);
+
+    void update(const void* data, size_t size);
+
+    /**
+     * Finish and return the hash; the hasher is reset afterwards
+     */
+    Hash128 finalize();
+
+    void reset();
+
+private:
+    uint64 seed;
+    uint64 h1, h2;
+    uint8 buffer[16];
+    size_t bufferSize;
+    uint64 totalBytes;
+};
+
 /**
  * Compute SHA256 hash from memory buffer
  * @param data Pointer to data
@@ -15,9 +94,30 @@ std::string computeSHA256(const void* data, size_t size);
 
 /**
  * Compute SHA256 hash from file
+ * The file is memory-mapped rather than read through a stream
  * @param file File to hash
  * @return Hex string representation of SHA256 hash, empty if file doesn't exist
  */
 std::string computeSHA256FromFile(const juce::File& file);
 
+/**
+ * Compute the fast 128-bit hash of a memory buffer
+ */
+Hash128 computeFastHash128(const void* data, size_t size);
+
+/**
+ * Compute the fast 128-bit hash of a file, memory-mapped
+ * @param result Output hash
+ * @return false if the file cannot be read
+ */
+bool computeFastHash128FromFile(const juce::File& file, Hash128& result);
+
+/**
+ * Compute the fast 128-bit hash of a file in the order a streaming writer sees
+ * it: the bytes after headerSize, then the header, which writers finalize on
+ * close (see HashingFileOutputStream). A headerSize of 0 hashes the plain file.
+ * @return false if the file cannot be read or is shorter than headerSize
+ */
+bool computeFastHash128FromFile(const juce::File& file, int64 headerSize, Hash128& result);
+
 } // namespace serum
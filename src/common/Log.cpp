@@ -1,12 +1,30 @@
 #include "common/Log.h"
-#include <iostream>
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace serum {
 
-static juce::String getLevelPrefix(LogLevel level)
+namespace detail {
+std::atomic<int> minimumLogLevel { static_cast<int>(LogLevel::Info) };
+}
+
+namespace {
+
+constexpr size_t queueCapacity = 4096;
+
+// Set once the logger has been destroyed; later messages are written directly
+std::atomic<bool> loggerShutDown { false };
+
+const char* getLevelPrefix(LogLevel level)
 {
     switch (level)
     {
+        case LogLevel::Debug:   return "[DEBUG]";
         case LogLevel::Info:    return "[INFO] ";
         case LogLevel::Warning: return "[WARN] ";
         case LogLevel::Error:   return "[ERROR]";
@@ -14,12 +32,359 @@ static juce::String getLevelPrefix(LogLevel level)
     }
 }
 
+const char* getLevelName(LogLevel level)
+{
+    switch (level)
+    {
+        case LogLevel::Debug:   return "debug";
+        case LogLevel::Info:    return "info";
+        case LogLevel::Warning: return "warning";
+        case LogLevel::Error:   return "error";
+        default:                return "unknown";
+    }
+}
+
+struct LogEntry
+{
+    uint64 sequence = 0;
+    int64 timeMs = 0;
+    LogLevel level = LogLevel::Info;
+    int threadNumber = 0;
+    juce::String message;
+};
+
+/**
+ * Single-producer ring owned by one logging thread, drained by the writer
+ * Messages are juce::Strings, so queuing one only bumps a reference count
+ */
+struct ThreadQueue
+{
+    explicit ThreadQueue(int threadNumber) : entries(queueCapacity), threadNumber(threadNumber) {}
+
+    std::vector<LogEntry> entries;
+    std::atomic<uint64> writeIndex { 0 };
+    std::atomic<uint64> readIndex { 0 };
+    std::atomic<bool> threadExited { false };
+    const int threadNumber;
+};
+
+/**
+ * Keeps the calling thread's queue alive and marks it abandoned on thread exit
+ * The writer drops abandoned queues once they are empty
+ */
+struct ThreadQueueHandle
+{
+    std::shared_ptr<ThreadQueue> queue;
+
+    ~ThreadQueueHandle()
+    {
+        if (queue != nullptr)
+            queue->threadExited = true;
+    }
+};
+
+thread_local ThreadQueueHandle threadQueueHandle;
+
+std::string formatEntry(const LogEntry& entry, bool jsonLines)
+{
+    if (jsonLines)
+    {
+        auto* object = new juce::DynamicObject();
+        juce::var line(object);
+        object->setProperty("time", juce::Time(entry.timeMs).toISO8601(true));
+        object->setProperty("level", getLevelName(entry.level));
+        object->setProperty("thread", entry.threadNumber);
+        object->setProperty("message", entry.message);
+        return juce::JSON::toString(line, true).toStdString() + "\n";
+    }
+
+    auto timestamp = juce::Time(entry.timeMs).toString(true, true, true, true);
+    return (timestamp + " " + getLevelPrefix(entry.level) + " " + entry.message).toStdString() + "\n";
+}
+
+/**
+ * Asynchronous writer behind serum::log
+ *
+ * Each thread appends to its own lock-free ring; a background thread gathers
+ * all rings, restores the global order from a sequence number and writes the
+ * batch with one flush. Logging threads never touch stdout or a lock, except
+ * once when their ring is registered.
+ */
+class AsyncLogger
+{
+public:
+    AsyncLogger()
+    {
+        thread = std::thread([this] { writerLoop(); });
+    }
+
+    ~AsyncLogger()
+    {
+        stopping = true;
+        wakeUp.signal();
+        if (thread.joinable())
+            thread.join();
+
+        drain();
+        closeOutput();
+        loggerShutDown = true;
+    }
+
+    void submit(LogLevel level, const juce::String& message)
+    {
+        auto& queue = getThreadQueue();
+        auto write = queue.writeIndex.load(std::memory_order_relaxed);
+
+        while (write - queue.readIndex.load(std::memory_order_acquire) >= queueCapacity)
+        {
+            // Ring full: drop chatter, but never warnings or errors
+            if (level < LogLevel::Warning)
+            {
+                ++droppedMessages;
+                return;
+            }
+
+            wakeUp.signal();
+            std::this_thread::yield();
+        }
+
+        auto& entry = queue.entries[static_cast<size_t>(write % queueCapacity)];
+        entry.sequence = nextSequence.fetch_add(1, std::memory_order_relaxed);
+        entry.timeMs = juce::Time::currentTimeMillis();
+        entry.level = level;
+        entry.threadNumber = queue.threadNumber;
+        entry.message = message;
+        queue.writeIndex.store(write + 1, std::memory_order_release);
+
+        // Errors go out promptly; everything else waits for the next batch
+        if (level == LogLevel::Error || write - queue.readIndex.load(std::memory_order_relaxed) >= queueCapacity / 2)
+            wakeUp.signal();
+    }
+
+    void flush()
+    {
+        drain();
+    }
+
+    bool configure(const LogOptions& options)
+    {
+        std::lock_guard<std::mutex> lock(outputLock);
+        drainLocked();
+        closeOutput();
+
+        jsonLines = options.jsonLines;
+        detail::minimumLogLevel = static_cast<int>(options.minLevel);
+
+        if (options.outputFile == juce::File())
+            return true;
+
+        options.outputFile.getParentDirectory().createDirectory();
+        output = std::fopen(options.outputFile.getFullPathName().toRawUTF8(), "ab");
+        if (output == nullptr)
+        {
+            output = stdout;
+            return false;
+        }
+
+        return true;
+    }
+
+private:
+    std::mutex queuesLock;
+    std::vector<std::shared_ptr<ThreadQueue>> queues;
+    int nextThreadNumber = 1;
+
+    std::atomic<uint64> nextSequence { 0 };
+    std::atomic<uint64> droppedMessages { 0 };
+    juce::WaitableEvent wakeUp;
+    std::atomic<bool> stopping { false };
+    std::thread thread;
+
+    // Output state, guarded by outputLock
+    std::mutex outputLock;
+    FILE* output = stdout;
+    bool jsonLines = false;
+    std::vector<LogEntry> pending;
+    std::string text;
+
+    ThreadQueue& getThreadQueue()
+    {
+        auto& handle = threadQueueHandle;
+        if (handle.queue == nullptr)
+        {
+            std::lock_guard<std::mutex> lock(queuesLock);
+            handle.queue = std::make_shared<ThreadQueue>(nextThreadNumber++);
+            queues.push_back(handle.queue);
+        }
+
+        return *handle.queue;
+    }
+
+    void writerLoop()
+    {
+        while (!stopping)
+        {
+            wakeUp.wait(20);
+            drain();
+        }
+    }
+
+    void drain()
+    {
+        std::lock_guard<std::mutex> lock(outputLock);
+        drainLocked();
+    }
+
+    void drainLocked()
+    {
+        pending.clear();
+
+        {
+            std::lock_guard<std::mutex> lock(queuesLock);
+            for (auto& queue : queues)
+                collect(*queue);
+
+            queues.erase(std::remove_if(queues.begin(), queues.end(),
+                                        [](const auto& queue) {
+                                            return queue->threadExited
+                                                && queue->readIndex.load() == queue->writeIndex.load();
+                                        }),
+                         queues.end());
+        }
+
+        auto dropped = droppedMessages.exchange(0);
+        if (pending.empty() && dropped == 0)
+            return;
+
+        std::sort(pending.begin(), pending.end(),
+                  [](const LogEntry& a, const LogEntry& b) { return a.sequence < b.sequence; });
+
+        text.clear();
+        if (dropped > 0)
+        {
+            LogEntry notice;
+            notice.timeMs = juce::Time::currentTimeMillis();
+            notice.level = LogLevel::Warning;
+            notice.message = juce::String(static_cast<juce::int64>(dropped)) + " log messages dropped, queue full";
+            text += formatEntry(notice, jsonLines);
+        }
+
+        for (const auto& entry : pending)
+            text += formatEntry(entry, jsonLines);
+
+        std::fwrite(text.data(), 1, text.size(), output);
+        std::fflush(output);
+        pending.clear();
+    }
+
+    void collect(ThreadQueue& queue)
+    {
+        auto read = queue.readIndex.load(std::memory_order_relaxed);
+        auto write = queue.writeIndex.load(std::memory_order_acquire);
+
+        for (; read != write; ++read)
+        {
+            auto& entry = queue.entries[static_cast<size_t>(read % queueCapacity)];
+            pending.push_back(entry);
+            entry.message = juce::String();  // Release the text on this thread
+        }
+
+        queue.readIndex.store(read, std::memory_order_release);
+    }
+
+    void closeOutput()
+    {
+        if (output != stdout)
+            std::fclose(output);
+        output = stdout;
+    }
+
+    JUCE_DECLARE_NON_COPYABLE(AsyncLogger)
+};
+
+AsyncLogger& getLogger()
+{
+    static AsyncLogger logger;
+    return logger;
+}
+
+} // namespace
+
 void log(LogLevel level, const juce::String& message)
 {
-    auto timestamp = juce::Time::getCurrentTime().toString(true, true, true, true);
-    auto fullMessage = timestamp + " " + getLevelPrefix(level) + " " + message;
-    
-    std::cout << fullMessage << std::endl;
+    if (!isLogLevelEnabled(level))
+        return;
+
+    if (loggerShutDown)
+    {
+        // Static destruction is under way; write synchronously
+        LogEntry entry;
+        entry.timeMs = juce::Time::currentTimeMillis();
+        entry.level = level;
+        entry.message = message;
+        auto text = formatEntry(entry, false);
+        std::fwrite(text.data(), 1, text.size(), stdout);
+        return;
+    }
+
+    getLogger().submit(level, message);
+}
+
+bool configureLogging(const LogOptions& options)
+{
+    return getLogger().configure(options);
+}
+
+bool configureLoggingFromArgs(const juce::ArgumentList& args)
+{
+    LogOptions options;
+    options.jsonLines = args.containsOption("--log-json");
+
+    auto level = args.getValueForOption("--log-level").toLowerCase();
+    if (level == "debug")
+        options.minLevel = LogLevel::Debug;
+    else if (level == "warning" || level == "warn")
+        options.minLevel = LogLevel::Warning;
+    else if (level == "error")
+        options.minLevel = LogLevel::Error;
+    else if (level.isNotEmpty() && level != "info")
+    {
+        logError("Unknown --log-level: " + level);
+        return false;
+    }
+
+    auto logFile = args.getValueForOption("--log-file");
+    if (logFile.isNotEmpty())
+        options.outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(logFile);
+
+    if (!configureLogging(options))
+    {
+        logError("Failed to open log file: " + options.outputFile.getFullPathName());
+        return false;
+    }
+
+    return true;
+}
+
+void setLogLevel(LogLevel level)
+{
+    detail::minimumLogLevel = static_cast<int>(level);
+}
+
+LogLevel getLogLevel()
+{
+    return static_cast<LogLevel>(detail::minimumLogLevel.load());
+}
+
+void flushLog()
+{
+    if (!loggerShutDown)
+        getLogger().flush();
+}
+
+void logDebug(const juce::String& message)
+{
+    log(LogLevel::Debug, message);
 }
 
 void logInfo(const juce::String& message)
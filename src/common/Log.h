@@ -1,6 +1,15 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <atomic>
+
+/**
+ * Lowest level compiled in (0 Debug, 1 Info, 2 Warning, 3 Error)
+ * SERUM_LOG_* calls below it compile to nothing
+ */
+#ifndef SERUM_LOG_COMPILE_LEVEL
+ #define SERUM_LOG_COMPILE_LEVEL 0
+#endif
 
 namespace serum {
 
@@ -9,11 +18,68 @@ namespace serum {
  */
 enum class LogLevel
 {
+    Debug,
     Info,
     Warning,
     Error
 };
 
+/**
+ * Logger configuration
+ */
+struct LogOptions
+{
+    LogLevel minLevel = LogLevel::Info;
+    bool jsonLines = false;       // One JSON object per line instead of text
+    juce::File outputFile;        // Appended to; stdout if unset
+};
+
+namespace detail {
+extern std::atomic<int> minimumLogLevel;
+}
+
+/**
+ * True if messages of this level are written
+ * Cheap enough to guard message formatting on hot paths
+ */
+inline bool isLogLevelEnabled(LogLevel level)
+{
+    return static_cast<int>(level) >= SERUM_LOG_COMPILE_LEVEL
+        && static_cast<int>(level) >= detail::minimumLogLevel.load(std::memory_order_relaxed);
+}
+
+/**
+ * Replace the logger configuration; pending messages are written first
+ * @return false if the output file could not be opened (stdout is kept)
+ */
+bool configureLogging(const LogOptions& options);
+
+/**
+ * Configure from --log-level debug|info|warning|error, --log-json and --log-file <path>
+ * @return false on an unknown level or unopenable file
+ */
+bool configureLoggingFromArgs(const juce::ArgumentList& args);
+
+/**
+ * Change only the runtime level filter
+ */
+void setLogLevel(LogLevel level);
+
+/**
+ * Current runtime level filter
+ */
+LogLevel getLogLevel();
+
+/**
+ * Block until every message logged so far has been written
+ */
+void flushLog();
+
+/**
+ * Log a message with Debug level
+ */
+void logDebug(const juce::String& message);
+
 /**
  * Log a message with Info level
  */
@@ -31,7 +97,39 @@ void logError(const juce::String& message);
 
 /**
  * Generic log function
+ * Queues the message for the background writer and returns; never flushes
  */
 void log(LogLevel level, const juce::String& message);
 
 } // namespace serum
+
+/**
+ * Level-checked logging; the message expression is only evaluated when the
+ * level is enabled, and not compiled at all below SERUM_LOG_COMPILE_LEVEL
+ */
+#define SERUM_LOG(level, message)                            \
+    do                                                       \
+    {                                                        \
+        if (serum::isLogLevelEnabled(level))                 \
+            serum::log(level, message);                      \
+    } while (false)
+
+#if SERUM_LOG_COMPILE_LEVEL <= 0
+ #define SERUM_LOG_DEBUG(message) SERUM_LOG(serum::LogLevel::Debug, message)
+#else
+ #define SERUM_LOG_DEBUG(message) do {} while (false)
+#endif
+
+#if SERUM_LOG_COMPILE_LEVEL <= 1
+ #define SERUM_LOG_INFO(message) SERUM_LOG(serum::LogLevel::Info, message)
+#else
+ #define SERUM_LOG_INFO(message) do {} while (false)
+#endif
+
+#if SERUM_LOG_COMPILE_LEVEL <= 2
+ #define SERUM_LOG_WARNING(message) SERUM_LOG(serum::LogLevel::Warning, message)
+#else
+ #define SERUM_LOG_WARNING(message) do {} while (false)
+#endif
+
+#define SERUM_LOG_ERROR(message) SERUM_LOG(serum::LogLevel::Error, message)
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace serum {
+
+/**
+ * Source of sample-accurate MIDI for a render
+ * OfflineRenderer pulls one block at a time during the main phase.
+ */
+class MidiEventSource
+{
+public:
+    virtual ~MidiEventSource() = default;
+
+    /**
+     * Fill a caller-owned buffer with the events of a block
+     * Must not allocate once dest has been reserved
+     * @param blockStartSample Start sample of the block
+     * @param blockSize Size of the block
+     * @param dest Buffer to fill (cleared first)
+     */
+    virtual void popEvents(int64 blockStartSample, int blockSize, juce::MidiBuffer& dest) = 0;
+
+    /**
+     * Rewind to the beginning
+     */
+    virtual void reset() = 0;
+};
+
+} // namespace serum
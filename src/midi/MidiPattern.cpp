@@ -0,0 +1,121 @@
+#include "midi/MidiPattern.h"
+#include "midi/SyntheticMidiGenerator.h"
+#include "common/Paths.h"
+
+namespace serum {
+
+// Ramp messages are sent at most once per millisecond
+static constexpr double rampStepSec = 0.001;
+
+juce::File MidiPattern::getMidiFile() const
+{
+    return juce::File::isAbsolutePath(midiFile) ? juce::File(midiFile)
+                                                : getMidisDir().getChildFile(midiFile);
+}
+
+bool MidiPattern::build(MidiTimeline& timeline, const juce::String& noteName, int velocity,
+                        double durationSeconds, double sampleRate, juce::String& errorMsg) const
+{
+    timeline.clear();
+
+    const int rootNote = SyntheticMidiGenerator::noteNameToMidiNumber(noteName);
+    const auto durationSamples = static_cast<int64>(durationSeconds * sampleRate);
+
+    // Everything ends on the last sample of the main render: the tail sends no
+    // MIDI, so an event on durationSamples is lost when it starts a block
+    const auto lastSample = juce::jmax<int64>(0, durationSamples - 1);
+
+    juce::Array<int> notes;
+    for (int interval : intervals)
+        notes.add(juce::jlimit(0, 127, rootNote + interval));
+    if (notes.isEmpty())
+        notes.add(rootNote);
+
+    switch (type)
+    {
+        case Type::Note:
+            timeline.addNote(1, rootNote, velocity, 0, lastSample);
+            break;
+
+        case Type::Chord:
+            timeline.addChord(1, notes, velocity, 0, lastSample);
+            break;
+
+        case Type::Arpeggio:
+            timeline.addArpeggio(1, notes, velocity, 0, lastSample,
+                                 static_cast<int64>(stepSec * sampleRate), gate, direction);
+            break;
+
+        case Type::File:
+            if (!timeline.addMidiFile(getMidiFile(), sampleRate, rootNote - 60, errorMsg))
+                return false;
+
+            // Note-offs at or past the end land on lastSample
+            timeline.truncate(durationSamples);
+            break;
+    }
+
+    const auto rampStepSamples = juce::jmax<int64>(1, static_cast<int64>(rampStepSec * sampleRate));
+    for (const auto& ramp : ramps)
+    {
+        auto startSample = juce::jlimit<int64>(0, lastSample, static_cast<int64>(ramp.startSec * sampleRate));
+        auto endSample = ramp.endSec < 0.0
+            ? lastSample
+            : juce::jlimit<int64>(startSample, lastSample, static_cast<int64>(ramp.endSec * sampleRate));
+
+        if (ramp.controller < 0)
+            timeline.addPitchBendRamp(1, ramp.from, ramp.to, startSample, endSample, rampStepSamples);
+        else
+            timeline.addControllerRamp(1, ramp.controller, juce::roundToInt(ramp.from), juce::roundToInt(ramp.to),
+                                       startSample, endSample, rampStepSamples);
+    }
+
+    timeline.compile();
+    return true;
+}
+
+juce::String MidiPattern::describe() const
+{
+    juce::String text;
+    switch (type)
+    {
+        case Type::Note:     text = "note"; break;
+        case Type::Chord:    text = "chord"; break;
+        case Type::Arpeggio: text = "arp"; break;
+        case Type::File:     text = "file"; break;
+    }
+
+    if (type == Type::Chord || type == Type::Arpeggio)
+    {
+        juce::StringArray values;
+        for (int interval : intervals)
+            values.add(juce::String(interval));
+        text << "[" << values.joinIntoString(",") << "]";
+    }
+
+    if (type == Type::Arpeggio)
+    {
+        text << " step=" << juce::String(stepSec) << " gate=" << juce::String(gate)
+             << " dir=" << (direction == MidiTimeline::ArpeggioDirection::Up     ? "up"
+                          : direction == MidiTimeline::ArpeggioDirection::Down ? "down"
+                                                                               : "updown");
+    }
+
+    if (type == Type::File)
+    {
+        auto file = getMidiFile();
+        text << " " << midiFile << ":" << juce::String(file.getSize())
+             << ":" << juce::String(file.getLastModificationTime().toMilliseconds());
+    }
+
+    for (const auto& ramp : ramps)
+    {
+        text << " ramp(" << (ramp.controller < 0 ? juce::String("bend") : "cc" + juce::String(ramp.controller))
+             << "," << juce::String(ramp.from) << "," << juce::String(ramp.to)
+             << "," << juce::String(ramp.startSec) << "," << juce::String(ramp.endSec) << ")";
+    }
+
+    return text;
+}
+
+} // namespace serum
@@ -0,0 +1,71 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "midi/MidiTimeline.h"
+#include <vector>
+
+namespace serum {
+
+/**
+ * Linear automation applied across a render
+ */
+struct MidiRamp
+{
+    int controller = -1;     // CC number, or -1 for pitch bend
+    float from = 0.0f;       // CC value 0-127, or bend -1 to 1
+    float to = 0.0f;
+    double startSec = 0.0;
+    double endSec = -1.0;    // Negative: end of the note
+};
+
+/**
+ * What a render plays, relative to the job's note and velocity
+ * The default is the single held note of SyntheticMidiGenerator.
+ */
+struct MidiPattern
+{
+    enum class Type
+    {
+        Note,
+        Chord,      // All intervals held together
+        Arpeggio,   // Intervals cycled every stepSec
+        File        // Standard MIDI File, transposed by the job note relative to C4
+    };
+
+    Type type = Type::Note;
+    juce::Array<int> intervals;   // Semitones above the job note
+    double stepSec = 0.125;
+    double gate = 0.5;
+    MidiTimeline::ArpeggioDirection direction = MidiTimeline::ArpeggioDirection::Up;
+    juce::String midiFile;        // Relative to getMidisDir() unless absolute
+    std::vector<MidiRamp> ramps;
+
+    /**
+     * Resolve midiFile against the MIDI directory
+     */
+    juce::File getMidiFile() const;
+
+    /**
+     * True if the pattern can move controllers or pitch bend (ramps, or any
+     * MIDI file), which may leave the plugin's state changed after the render
+     */
+    bool changesControllers() const { return !ramps.empty() || type == Type::File; }
+
+    /**
+     * Fill a timeline with the pattern
+     * Notes end at durationSeconds, like SyntheticMidiGenerator
+     * @param timeline Timeline to fill (cleared first, compiled on return)
+     * @param errorMsg Output error message on failure
+     * @return true on success
+     */
+    bool build(MidiTimeline& timeline, const juce::String& noteName, int velocity,
+               double durationSeconds, double sampleRate, juce::String& errorMsg) const;
+
+    /**
+     * Stable text description, used in cache keys and metadata
+     * Includes the size and modification time of a MIDI file
+     */
+    juce::String describe() const;
+};
+
+} // namespace serum
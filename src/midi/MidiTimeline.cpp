@@ -0,0 +1,273 @@
+#include "midi/MidiTimeline.h"
+#include <algorithm>
+
+namespace serum {
+
+namespace {
+
+/**
+ * Emit a linear ramp, skipping steps where the quantized value does not change
+ */
+template <typename MakeMessage>
+void addRamp(MidiTimeline& timeline, double from, double to, int64 startSample, int64 endSample,
+             int64 stepSamples, MakeMessage makeMessage)
+{
+    stepSamples = juce::jmax<int64>(1, stepSamples);
+    int lastValue = -1;
+
+    for (int64 position = startSample;; position = juce::jmin(position + stepSamples, endSample))
+    {
+        double t = endSample > startSample
+            ? static_cast<double>(position - startSample) / static_cast<double>(endSample - startSample)
+            : 1.0;
+        int value = juce::roundToInt(from + (to - from) * t);
+
+        if (value != lastValue)
+        {
+            timeline.addEvent(position, makeMessage(value));
+            lastValue = value;
+        }
+
+        if (position >= endSample)
+            break;
+    }
+}
+
+} // namespace
+
+void MidiTimeline::clear()
+{
+    events.clear();
+    reset();
+}
+
+void MidiTimeline::addEvent(int64 samplePosition, const juce::MidiMessage& message)
+{
+    events.push_back({ samplePosition, message });
+}
+
+void MidiTimeline::addNote(int channel, int noteNumber, int velocity, int64 startSample, int64 endSample)
+{
+    if (endSample <= startSample)
+        return;
+
+    addEvent(startSample, juce::MidiMessage::noteOn(channel, noteNumber, static_cast<uint8>(velocity)));
+    addEvent(endSample, juce::MidiMessage::noteOff(channel, noteNumber));
+}
+
+void MidiTimeline::addChord(int channel, const juce::Array<int>& noteNumbers, int velocity,
+                            int64 startSample, int64 endSample)
+{
+    for (int noteNumber : noteNumbers)
+        addNote(channel, noteNumber, velocity, startSample, endSample);
+}
+
+void MidiTimeline::addArpeggio(int channel, const juce::Array<int>& noteNumbers, int velocity,
+                               int64 startSample, int64 endSample, int64 stepSamples, double gate,
+                               ArpeggioDirection direction)
+{
+    if (noteNumbers.isEmpty())
+        return;
+
+    juce::Array<int> sequence;
+    if (direction == ArpeggioDirection::Down)
+    {
+        for (int i = noteNumbers.size(); --i >= 0;)
+            sequence.add(noteNumbers[i]);
+    }
+    else
+    {
+        sequence = noteNumbers;
+        if (direction == ArpeggioDirection::UpDown)
+        {
+            for (int i = noteNumbers.size() - 1; --i > 0;)
+                sequence.add(noteNumbers[i]);
+        }
+    }
+
+    stepSamples = juce::jmax<int64>(1, stepSamples);
+    auto holdSamples = juce::jmax<int64>(1, static_cast<int64>(juce::jlimit(0.0, 1.0, gate) * static_cast<double>(stepSamples)));
+
+    int index = 0;
+    for (int64 position = startSample; position < endSample; position += stepSamples, ++index)
+        addNote(channel, sequence[index % sequence.size()], velocity,
+                position, juce::jmin(position + holdSamples, endSample));
+}
+
+void MidiTimeline::addControllerRamp(int channel, int controller, int from, int to,
+                                     int64 startSample, int64 endSample, int64 stepSamples)
+{
+    addRamp(*this, juce::jlimit(0, 127, from), juce::jlimit(0, 127, to), startSample, endSample, stepSamples,
+            [channel, controller](int value)
+            {
+                return juce::MidiMessage::controllerEvent(channel, controller, value);
+            });
+}
+
+void MidiTimeline::addPitchBendRamp(int channel, float from, float to,
+                                    int64 startSample, int64 endSample, int64 stepSamples)
+{
+    // 14-bit wheel position, 8192 is centre
+    auto toWheel = [](float bend) { return 8192.0 + juce::jlimit(-1.0f, 1.0f, bend) * 8192.0; };
+
+    addRamp(*this, toWheel(from), toWheel(to), startSample, endSample, stepSamples,
+            [channel](int value)
+            {
+                return juce::MidiMessage::pitchWheel(channel, juce::jlimit(0, 16383, value));
+            });
+}
+
+bool MidiTimeline::addMidiFile(const juce::File& file, double sampleRate, int transpose, juce::String& errorMsg)
+{
+    juce::FileInputStream stream(file);
+    if (!stream.openedOk())
+    {
+        errorMsg = "Cannot open MIDI file: " + file.getFullPathName();
+        return false;
+    }
+
+    juce::MidiFile midiFile;
+    if (!midiFile.readFrom(stream))
+    {
+        errorMsg = "Not a valid MIDI file: " + file.getFullPathName();
+        return false;
+    }
+
+    // Applies the tempo map (or SMPTE timing)
+    midiFile.convertTimestampTicksToSeconds();
+
+    for (int track = 0; track < midiFile.getNumTracks(); ++track)
+    {
+        int64 noteOnSample[16][128];
+        std::fill(&noteOnSample[0][0], &noteOnSample[0][0] + 16 * 128, int64(-1));
+
+        for (const auto* holder : *midiFile.getTrack(track))
+        {
+            auto message = holder->message;
+            if (message.isMetaEvent() || message.isSysEx())
+                continue;
+
+            auto position = static_cast<int64>(message.getTimeStamp() * sampleRate + 0.5);
+
+            if (message.isNoteOnOrOff())
+            {
+                message.setNoteNumber(juce::jlimit(0, 127, message.getNoteNumber() + transpose));
+
+                // compile() puts note-offs first at equal positions, so a note
+                // shorter than a sample would release before it starts and hang
+                int64& onSample = noteOnSample[juce::jlimit(1, 16, message.getChannel()) - 1][message.getNoteNumber()];
+                if (message.isNoteOn())
+                    onSample = position;
+                else if (position <= onSample)
+                    position = onSample + 1;
+            }
+
+            addEvent(position, message);
+        }
+    }
+
+    return true;
+}
+
+void MidiTimeline::truncate(int64 lengthSamples)
+{
+    compile();
+
+    const int64 lastSample = juce::jmax<int64>(0, lengthSamples - 1);
+    int activeNotes[16][128] = {};
+
+    std::vector<ScheduledEvent> kept;
+    kept.reserve(events.size());
+
+    for (auto& event : events)
+    {
+        const auto& message = event.message;
+        int channel = juce::jlimit(1, 16, message.getChannel()) - 1;
+
+        if (message.isNoteOn())
+        {
+            // Its note-off would be clamped to the same sample and sort before it
+            if (event.samplePosition >= lastSample)
+                continue;
+
+            ++activeNotes[channel][message.getNoteNumber()];
+        }
+        else if (message.isNoteOff())
+        {
+            int& active = activeNotes[channel][message.getNoteNumber()];
+            if (active == 0)
+                continue;
+
+            --active;
+            event.samplePosition = juce::jmin(event.samplePosition, lastSample);
+        }
+        else if (event.samplePosition >= lengthSamples)
+        {
+            continue;
+        }
+
+        kept.push_back(std::move(event));
+    }
+
+    // Release whatever is still held
+    for (int channel = 0; channel < 16; ++channel)
+        for (int note = 0; note < 128; ++note)
+            for (int i = 0; i < activeNotes[channel][note]; ++i)
+                kept.push_back({ lastSample, juce::MidiMessage::noteOff(channel + 1, note) });
+
+    events = std::move(kept);
+    compile();
+}
+
+void MidiTimeline::compile()
+{
+    std::stable_sort(events.begin(), events.end(), [](const ScheduledEvent& a, const ScheduledEvent& b)
+    {
+        if (a.samplePosition != b.samplePosition)
+            return a.samplePosition < b.samplePosition;
+
+        return a.message.isNoteOff() && !b.message.isNoteOff();
+    });
+
+    reset();
+}
+
+void MidiTimeline::popEvents(int64 blockStartSample, int blockSize, juce::MidiBuffer& dest)
+{
+    dest.clear();
+
+    int64 blockEndSample = blockStartSample + blockSize;
+
+    // Seeking backwards is a binary search; the render loop only moves forwards
+    if (blockStartSample < currentPosition)
+    {
+        cursor = static_cast<size_t>(std::lower_bound(events.begin(), events.end(), blockStartSample,
+                                                      [](const ScheduledEvent& event, int64 position)
+                                                      {
+                                                          return event.samplePosition < position;
+                                                      })
+                                     - events.begin());
+    }
+
+    // Skip events before this block
+    while (cursor < events.size() && events[cursor].samplePosition < blockStartSample)
+        ++cursor;
+
+    // Emit events that fall inside this block
+    while (cursor < events.size() && events[cursor].samplePosition < blockEndSample)
+    {
+        const auto& event = events[cursor];
+        dest.addEvent(event.message, static_cast<int>(event.samplePosition - blockStartSample));
+        ++cursor;
+    }
+
+    currentPosition = blockEndSample;
+}
+
+void MidiTimeline::reset()
+{
+    currentPosition = 0;
+    cursor = 0;
+}
+
+} // namespace serum
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "midi/MidiEventSource.h"
+#include <vector>
+
+namespace serum {
+
+/**
+ * Precompiled, sample-accurate MIDI event timeline
+ *
+ * Events are added in any order, then compile() sorts them once into a flat
+ * array. Playback walks that array with a cursor, so a block costs
+ * O(events in the block); seeking backwards is a binary search.
+ */
+class MidiTimeline : public MidiEventSource
+{
+public:
+    enum class ArpeggioDirection
+    {
+        Up,
+        Down,
+        UpDown   // Ping-pong without repeating the end notes
+    };
+
+    MidiTimeline() = default;
+
+    /**
+     * Remove every event
+     */
+    void clear();
+
+    /**
+     * Add a single event
+     */
+    void addEvent(int64 samplePosition, const juce::MidiMessage& message);
+
+    /**
+     * Add a note from startSample to endSample
+     */
+    void addNote(int channel, int noteNumber, int velocity, int64 startSample, int64 endSample);
+
+    /**
+     * Add notes that start and end together
+     */
+    void addChord(int channel, const juce::Array<int>& noteNumbers, int velocity,
+                  int64 startSample, int64 endSample);
+
+    /**
+     * Cycle through notes, one every stepSamples, until endSample
+     * @param gate Fraction of a step each note is held (0-1]
+     */
+    void addArpeggio(int channel, const juce::Array<int>& noteNumbers, int velocity,
+                     int64 startSample, int64 endSample, int64 stepSamples, double gate,
+                     ArpeggioDirection direction);
+
+    /**
+     * Linear controller ramp, one message per stepSamples where the value changes
+     * @param controller Controller number (0-127)
+     * @param from Start value (0-127)
+     * @param to End value (0-127)
+     */
+    void addControllerRamp(int channel, int controller, int from, int to,
+                           int64 startSample, int64 endSample, int64 stepSamples);
+
+    /**
+     * Linear pitch-bend ramp, one message per stepSamples where the value changes
+     * @param from Start bend (-1 to 1, full range down/up)
+     * @param to End bend (-1 to 1)
+     */
+    void addPitchBendRamp(int channel, float from, float to,
+                          int64 startSample, int64 endSample, int64 stepSamples);
+
+    /**
+     * Add every channel event of a Standard MIDI File
+     * Meta events are skipped; tempo changes are honoured; notes last at least one sample
+     * @param transpose Semitones added to every note
+     * @param errorMsg Output error message on failure
+     * @return true if the file was read
+     */
+    bool addMidiFile(const juce::File& file, double sampleRate, int transpose, juce::String& errorMsg);
+
+    /**
+     * End everything at lengthSamples: later events and notes starting on the
+     * last sample are dropped, later and missing note-offs are placed on the last sample
+     */
+    void truncate(int64 lengthSamples);
+
+    /**
+     * Sort the events; call after adding and before playback
+     * At equal positions note-offs come first, so retriggered notes restart
+     */
+    void compile();
+
+    int getNumEvents() const { return static_cast<int>(events.size()); }
+
+    void popEvents(int64 blockStartSample, int blockSize, juce::MidiBuffer& dest) override;
+    void reset() override;
+
+private:
+    struct ScheduledEvent
+    {
+        int64 samplePosition;
+        juce::MidiMessage message;
+    };
+
+    std::vector<ScheduledEvent> events;  // Sorted by samplePosition after compile()
+    size_t cursor = 0;
+    int64 currentPosition = 0;
+};
+
+} // namespace serum
@@ -15,7 +15,6 @@ SyntheticMidiGenerator::SyntheticMidiGenerator(
     , midiNoteNumber(60)  // Middle C default
     , noteOnSample(0)
     , noteOffSample(0)
-    , currentPosition(0)
 {
     midiNoteNumber = noteNameToMidiNumber(noteName);
 }
@@ -25,46 +24,30 @@ void SyntheticMidiGenerator::generate()
     // Note starts at sample 0
     noteOnSample = 0;
     
-    // Note ends after duration
-    noteOffSample = static_cast<int64>(durationSeconds * sampleRate);
+    // Note ends on the last sample of the duration; the tail sends no MIDI, so
+    // a note-off one sample later is lost when the duration fills whole blocks
+    noteOffSample = juce::jmax<int64>(1, static_cast<int64>(durationSeconds * sampleRate) - 1);
     
-    logInfo("Generated synthetic MIDI: " + noteName + 
+    // Precompute the event timeline once
+    timeline.clear();
+    timeline.addEvent(noteOnSample, juce::MidiMessage::noteOn(1, midiNoteNumber, static_cast<uint8>(velocity)));
+    timeline.addEvent(noteOffSample, juce::MidiMessage::noteOff(1, midiNoteNumber));
+    timeline.compile();
+    
+    SERUM_LOG_DEBUG("Generated synthetic MIDI: " + noteName + 
             " (MIDI " + juce::String(midiNoteNumber) + 
             ") vel=" + juce::String(velocity) + 
             " duration=" + juce::String(durationSeconds) + "s");
-    
-    reset();
 }
 
-juce::MidiBuffer SyntheticMidiGenerator::popEvents(int64 blockStartSample, int blockSize)
+void SyntheticMidiGenerator::popEvents(int64 blockStartSample, int blockSize, juce::MidiBuffer& dest)
 {
-    juce::MidiBuffer buffer;
-    
-    int64 blockEndSample = blockStartSample + blockSize;
-    
-    // Check if note-on falls in this block
-    if (noteOnSample >= blockStartSample && noteOnSample < blockEndSample)
-    {
-        int offsetInBlock = static_cast<int>(noteOnSample - blockStartSample);
-        buffer.addEvent(juce::MidiMessage::noteOn(1, midiNoteNumber, static_cast<uint8>(velocity)), 
-                       offsetInBlock);
-    }
-    
-    // Check if note-off falls in this block
-    if (noteOffSample >= blockStartSample && noteOffSample < blockEndSample)
-    {
-        int offsetInBlock = static_cast<int>(noteOffSample - blockStartSample);
-        buffer.addEvent(juce::MidiMessage::noteOff(1, midiNoteNumber), 
-                       offsetInBlock);
-    }
-    
-    currentPosition = blockEndSample;
-    return buffer;
+    timeline.popEvents(blockStartSample, blockSize, dest);
 }
 
 void SyntheticMidiGenerator::reset()
 {
-    currentPosition = 0;
+    timeline.reset();
 }
 
 int SyntheticMidiGenerator::noteNameToMidiNumber(const juce::String& name)
@@ -122,4 +105,27 @@ int SyntheticMidiGenerator::noteNameToMidiNumber(const juce::String& name)
     return juce::jlimit(0, 127, midiNote);
 }
 
+bool SyntheticMidiGenerator::isValidNoteName(const juce::String& name)
+{
+    if (name.isEmpty() || !juce::String("CDEFGABcdefgab").containsChar(name[0]))
+        return false;
+    
+    int octaveStartIndex = (name[1] == '#' || name[1] == 'b') ? 2 : 1;
+    auto octave = name.substring(octaveStartIndex);
+    
+    if (octave.isNotEmpty())
+    {
+        // Optional minus sign, then digits only ("C-1" is note 0)
+        auto digits = octave.startsWithChar('-') ? octave.substring(1) : octave;
+        if (digits.isEmpty() || digits.length() > 2 || !digits.containsOnly("0123456789"))
+            return false;
+    }
+    
+    // Same arithmetic as noteNameToMidiNumber(), before it clamps
+    int noteIndex = juce::String("C D EF G A B").indexOfChar(juce::CharacterFunctions::toUpperCase(name[0]));
+    int accidental = name[1] == '#' ? 1 : (name[1] == 'b' ? -1 : 0);
+    int midiNote = ((octave.isEmpty() ? 4 : octave.getIntValue()) + 1) * 12 + noteIndex + accidental;
+    return midiNote >= 0 && midiNote <= 127;
+}
+
 } // namespace serum
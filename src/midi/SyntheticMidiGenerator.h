@@ -1,6 +1,7 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "midi/MidiTimeline.h"
 
 namespace serum {
 
@@ -8,7 +9,7 @@ namespace serum {
  * Generates synthetic single-note MIDI sequences
  * Used for multi-view rendering (note × velocity combinations)
  */
-class SyntheticMidiGenerator
+class SyntheticMidiGenerator : public MidiEventSource
 {
 public:
     /**
@@ -31,17 +32,28 @@ public:
     void generate();
     
     /**
-     * Get MIDI events for a specific block
-     * @param blockStartSample Start sample of the block
-     * @param blockSize Size of the block
-     * @return MIDI buffer for this block
+     * Fill a caller-owned buffer with the MIDI events of a block
+     * Events come from a precompiled MidiTimeline, so sequential calls never
+     * allocate once dest has been reserved
      */
-    juce::MidiBuffer popEvents(int64 blockStartSample, int blockSize);
+    void popEvents(int64 blockStartSample, int blockSize, juce::MidiBuffer& dest) override;
     
     /**
      * Reset to beginning
      */
-    void reset();
+    void reset() override;
+    
+    /**
+     * Convert a note name (e.g. "C4", "A#3", "Db5") to a MIDI note number
+     * @return the note number, 60 if the name cannot be parsed
+     */
+    static int noteNameToMidiNumber(const juce::String& name);
+    
+    /**
+     * True if name is a letter A-G, an optional '#' or 'b' and an optional
+     * octave (default 4) that together give a note number from 0 to 127
+     */
+    static bool isValidNoteName(const juce::String& name);
     
 private:
     juce::String noteName;
@@ -52,9 +64,8 @@ private:
     int midiNoteNumber;
     int64 noteOnSample;
     int64 noteOffSample;
-    int64 currentPosition;
     
-    int noteNameToMidiNumber(const juce::String& name);
+    MidiTimeline timeline;
 };
 
 } // namespace serum
@@ -0,0 +1,208 @@
+#include "render/AsyncWavWriter.h"
+#include "common/Log.h"
+
+namespace serum {
+
+AsyncWavWriter::AsyncWavWriter(int maxChannels, int maxBlockSize, int numSlots, int coalesceSamples)
+    : maxChannels(maxChannels)
+    , maxBlockSize(maxBlockSize)
+    , slots(static_cast<size_t>(juce::jmax(2, numSlots)))
+    , coalesceBuffer(maxChannels, juce::jmax(coalesceSamples, maxBlockSize))
+{
+    // All audio memory is allocated here, never on the render path
+    for (auto& slot : slots)
+        slot.buffer.setSize(maxChannels, maxBlockSize);
+
+    thread = std::thread([this] { writerLoop(); });
+}
+
+AsyncWavWriter::~AsyncWavWriter()
+{
+    waitUntilIdle();
+
+    stopping = true;
+    dataReady.signal();
+    if (thread.joinable())
+        thread.join();
+
+    writer.close();
+}
+
+AsyncWavWriter::Slot& AsyncWavWriter::acquireSlot()
+{
+    // Backpressure: wait while the writer thread is a full ring behind
+    auto write = writeIndex.load(std::memory_order_relaxed);
+    while (write - readIndex.load(std::memory_order_acquire) >= slots.size())
+        spaceAvailable.wait(1);
+
+    return slots[static_cast<size_t>(write % slots.size())];
+}
+
+void AsyncWavWriter::publishSlot()
+{
+    writeIndex.store(writeIndex.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    dataReady.signal();
+}
+
+bool AsyncWavWriter::open(const juce::File& outputFile, double sampleRate, int numChannels,
+                          SampleFormat format)
+{
+    auto& slot = acquireSlot();
+    slot.type = SlotType::Open;
+    slot.file = outputFile;
+    slot.sampleRate = sampleRate;
+    slot.numChannels = numChannels;
+    slot.format = format;
+    publishSlot();
+    return true;
+}
+
+bool AsyncWavWriter::writeBlock(const juce::AudioBuffer<float>& block)
+{
+    if (stopping)
+        return false;
+
+    int numChannels = juce::jmin(block.getNumChannels(), maxChannels);
+
+    // Blocks larger than a slot are split across several
+    for (int start = 0; start < block.getNumSamples(); start += maxBlockSize)
+    {
+        int numSamples = juce::jmin(maxBlockSize, block.getNumSamples() - start);
+
+        auto& slot = acquireSlot();
+        slot.type = SlotType::Block;
+        slot.numSamples = numSamples;
+        slot.numChannels = numChannels;
+        for (int ch = 0; ch < numChannels; ++ch)
+            slot.buffer.copyFrom(ch, 0, block, ch, start, numSamples);
+        publishSlot();
+    }
+
+    return true;
+}
+
+void AsyncWavWriter::close()
+{
+    auto& slot = acquireSlot();
+    slot.type = SlotType::Close;
+    publishSlot();
+}
+
+int AsyncWavWriter::waitUntilIdle(juce::Array<juce::File>* failed, juce::Array<WrittenFile>* written)
+{
+    while (readIndex.load(std::memory_order_acquire) != writeIndex.load(std::memory_order_relaxed))
+        spaceAvailable.wait(5);
+
+    std::lock_guard<std::mutex> lock(settledMutex);
+    const int numFailed = failedFiles.size();
+    if (failed != nullptr)
+        failed->swapWith(failedFiles);
+    if (written != nullptr)
+        written->swapWith(writtenFiles);
+
+    failedFiles.clearQuick();
+    writtenFiles.clearQuick();
+    return numFailed;
+}
+
+void AsyncWavWriter::recordFailure()
+{
+    fileFailed = true;
+
+    std::lock_guard<std::mutex> lock(settledMutex);
+    failedFiles.add(currentFile);
+}
+
+void AsyncWavWriter::writerLoop()
+{
+    for (;;)
+    {
+        auto read = readIndex.load(std::memory_order_relaxed);
+        if (read == writeIndex.load(std::memory_order_acquire))
+        {
+            if (stopping)
+                break;
+
+            dataReady.wait(50);
+            continue;
+        }
+
+        handleSlot(slots[static_cast<size_t>(read % slots.size())]);
+
+        readIndex.store(read + 1, std::memory_order_release);
+        spaceAvailable.signal();
+    }
+}
+
+void AsyncWavWriter::handleSlot(Slot& slot)
+{
+    switch (slot.type)
+    {
+        case SlotType::Open:
+            sourceChannels = 0;
+            coalescedSamples = 0;
+            currentFile = slot.file;
+            fileFailed = false;
+            if (!writer.open(slot.file, slot.sampleRate, slot.numChannels,
+                             slot.format, coalesceBuffer.getNumSamples()))
+                recordFailure();
+            break;
+
+        case SlotType::Block:
+            if (fileFailed || !writer.isOpen())
+                break;
+
+            if (coalescedSamples + slot.numSamples > coalesceBuffer.getNumSamples()
+                || slot.numChannels != sourceChannels)
+                flushCoalesced();
+
+            // Coalesce in source layout; WavWriter maps channels on flush
+            sourceChannels = slot.numChannels;
+            for (int ch = 0; ch < sourceChannels; ++ch)
+                coalesceBuffer.copyFrom(ch, coalescedSamples, slot.buffer, ch, 0, slot.numSamples);
+            coalescedSamples += slot.numSamples;
+            break;
+
+        case SlotType::Close:
+            flushCoalesced();
+
+            // A file that failed before is already recorded
+            if (!writer.close())
+            {
+                if (!fileFailed)
+                    recordFailure();
+            }
+            else if (!fileFailed)
+            {
+                WrittenFile written;
+                written.file = currentFile;
+                if (writer.getFileHash(written.hash, written.headerSize))
+                {
+                    std::lock_guard<std::mutex> lock(settledMutex);
+                    writtenFiles.add(written);
+                }
+            }
+            break;
+    }
+}
+
+void AsyncWavWriter::flushCoalesced()
+{
+    if (coalescedSamples == 0 || fileFailed || !writer.isOpen())
+    {
+        coalescedSamples = 0;
+        return;
+    }
+
+    // View onto the coalescing buffer, no copy or allocation
+    juce::AudioBuffer<float> chunk(coalesceBuffer.getArrayOfWritePointers(), sourceChannels, coalescedSamples);
+    if (!writer.writeBlock(chunk))
+    {
+        logError("Async writer failed to write audio");
+        recordFailure();
+    }
+
+    coalescedSamples = 0;
+}
+
+} // namespace serum
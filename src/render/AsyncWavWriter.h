@@ -0,0 +1,135 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "render/WavWriter.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace serum {
+
+/**
+ * Background WAV writer fed through a lock-free single-producer ring
+ *
+ * The render thread copies blocks into preallocated ring slots and moves on;
+ * a writer thread does the sample conversion and writes in large coalesced
+ * chunks. Opening and closing files also go through the ring, so the render
+ * thread never waits on storage unless the ring is full (backpressure).
+ * Memory is bounded by numSlots × maxBlockSize plus one coalescing chunk.
+ *
+ * One producer thread only; the writer outlives many files.
+ */
+class AsyncWavWriter
+{
+public:
+    /**
+     * Constructor, starts the writer thread
+     * @param maxChannels Maximum channels of the rendered blocks
+     * @param maxBlockSize Samples per ring slot; larger blocks are split
+     * @param numSlots Ring capacity in slots
+     * @param coalesceSamples Samples gathered before each disk write
+     */
+    AsyncWavWriter(int maxChannels = 2, int maxBlockSize = 8192,
+                   int numSlots = 32, int coalesceSamples = 65536);
+
+    /**
+     * Drains pending writes and stops the writer thread
+     */
+    ~AsyncWavWriter();
+
+    /**
+     * Queue opening a new file (closes nothing; call close() first)
+     * @param numChannels Channels in the file; blocks are mapped by WavWriter
+     * @param format Sample encoding
+     * @return always true, failures surface through waitUntilIdle()
+     */
+    bool open(const juce::File& outputFile, double sampleRate, int numChannels,
+              SampleFormat format = SampleFormat::Pcm24);
+
+    /**
+     * Queue a block; blocks only while the ring is full
+     * @return false if the writer has stopped
+     */
+    bool writeBlock(const juce::AudioBuffer<float>& block);
+
+    /**
+     * Queue closing the current file; returns immediately
+     * A failure to finalize the file surfaces through waitUntilIdle()
+     */
+    void close();
+
+    /**
+     * A file closed successfully, with its hash computed while writing
+     */
+    struct WrittenFile
+    {
+        juce::File file;
+        Hash128 hash;
+        int64 headerSize = 0;   // See WavWriter::getFileHash()
+    };
+
+    /**
+     * Wait until every queued operation has reached the disk
+     * @param failed If set, receives the files that failed since the last call
+     * @param written If set, receives the files closed since the last call whose hash is known
+     * @return number of files that failed since the last call
+     */
+    int waitUntilIdle(juce::Array<juce::File>* failed = nullptr, juce::Array<WrittenFile>* written = nullptr);
+
+private:
+    enum class SlotType
+    {
+        Open,
+        Block,
+        Close
+    };
+
+    struct Slot
+    {
+        SlotType type = SlotType::Block;
+        juce::AudioBuffer<float> buffer;
+        int numSamples = 0;
+
+        juce::File file;
+        double sampleRate = 0.0;
+        int numChannels = 0;
+        SampleFormat format = SampleFormat::Pcm24;
+    };
+
+    const int maxChannels;
+    const int maxBlockSize;
+
+    std::vector<Slot> slots;
+    std::atomic<uint64> writeIndex { 0 };  // Next slot the producer fills
+    std::atomic<uint64> readIndex { 0 };   // Next slot the writer thread consumes
+    juce::WaitableEvent dataReady;
+    juce::WaitableEvent spaceAvailable;
+    std::atomic<bool> stopping { false };
+    std::thread thread;
+
+    // Writer thread state
+    WavWriter writer;
+    juce::AudioBuffer<float> coalesceBuffer;
+    int coalescedSamples = 0;
+    int sourceChannels = 0;
+    juce::File currentFile;
+    bool fileFailed = false;
+
+    std::mutex settledMutex;
+    juce::Array<juce::File> failedFiles;
+    juce::Array<WrittenFile> writtenFiles;
+
+    void recordFailure();
+
+    Slot& acquireSlot();
+    void publishSlot();
+
+    void writerLoop();
+    void handleSlot(Slot& slot);
+    void flushCoalesced();
+
+    JUCE_DECLARE_NON_COPYABLE(AsyncWavWriter)
+};
+
+} // namespace serum
@@ -0,0 +1,239 @@
+#include "render/AudioBlockSink.h"
+#include "common/Log.h"
+
+namespace serum {
+
+WavFileSink::WavFileSink(const juce::File& outputFile, ChannelLayout layout, SampleFormat format)
+    : outputFile(outputFile)
+    , layout(layout)
+    , format(format)
+{
+}
+
+bool WavFileSink::begin(double sampleRate, int numChannels, int64)
+{
+    return wavWriter.open(outputFile, sampleRate, getLayoutChannels(layout, numChannels), format);
+}
+
+bool WavFileSink::writeBlock(const juce::AudioBuffer<float>& block)
+{
+    return wavWriter.writeBlock(block);
+}
+
+bool WavFileSink::end()
+{
+    return wavWriter.close();
+}
+
+AsyncWavFileSink::AsyncWavFileSink(AsyncWavWriter& writer, const juce::File& outputFile,
+                                   ChannelLayout layout, SampleFormat format)
+    : writer(writer)
+    , outputFile(outputFile)
+    , layout(layout)
+    , format(format)
+{
+}
+
+bool AsyncWavFileSink::begin(double sampleRate, int numChannels, int64)
+{
+    return writer.open(outputFile, sampleRate, getLayoutChannels(layout, numChannels), format);
+}
+
+bool AsyncWavFileSink::writeBlock(const juce::AudioBuffer<float>& block)
+{
+    return writer.writeBlock(block);
+}
+
+bool AsyncWavFileSink::end()
+{
+    // Finalized on the writer thread; failures surface through waitUntilIdle()
+    writer.close();
+    return true;
+}
+
+ShardSink::ShardSink(ShardWriter& writer, const ShardKey& key, ChannelLayout layout)
+    : writer(writer)
+    , key(key)
+    , layout(layout)
+{
+}
+
+bool ShardSink::begin(double sampleRate, int numChannels, int64)
+{
+    return writer.beginRecord(key, sampleRate, getLayoutChannels(layout, numChannels));
+}
+
+bool ShardSink::writeBlock(const juce::AudioBuffer<float>& block)
+{
+    return writer.writeBlock(block);
+}
+
+bool ShardSink::end()
+{
+    return writer.endRecord();
+}
+
+ShmSink::ShmSink(ShmAudioRing& ring, uint64 renderId, const ShardKey& key, ChannelLayout layout)
+    : ring(ring)
+    , renderId(renderId)
+    , key(key)
+    , layout(layout)
+{
+}
+
+bool ShmSink::begin(double sampleRate, int numChannels, int64 expectedSamples)
+{
+    return ring.writeBegin(renderId, key, sampleRate, numChannels,
+                           getLayoutChannels(layout, numChannels), expectedSamples);
+}
+
+bool ShmSink::writeBlock(const juce::AudioBuffer<float>& block)
+{
+    return ring.writeBlock(renderId, block);
+}
+
+bool ShmSink::end()
+{
+    return ring.writeEnd(renderId);
+}
+
+HashingSink::HashingSink(AudioBlockSink& destination)
+    : destination(destination)
+{
+}
+
+bool HashingSink::begin(double sampleRate, int numSourceChannels, int64 expectedSamples)
+{
+    numChannels = juce::jmin(numSourceChannels, maxChannels);
+    for (auto& hasher : channelHashers)
+        hasher.reset();
+
+    audioHash = Hash128();
+    return destination.begin(sampleRate, numSourceChannels, expectedSamples);
+}
+
+bool HashingSink::writeBlock(const juce::AudioBuffer<float>& block)
+{
+    auto bytes = static_cast<size_t>(block.getNumSamples()) * sizeof(float);
+    for (int ch = 0; ch < juce::jmin(numChannels, block.getNumChannels()); ++ch)
+        channelHashers[ch].update(block.getReadPointer(ch), bytes);
+
+    return destination.writeBlock(block);
+}
+
+bool HashingSink::end()
+{
+    // Hash of the per-channel hashes, in channel order
+    FastHasher128 combined;
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto channelHash = channelHashers[ch].finalize();
+        combined.update(&channelHash, sizeof(channelHash));
+    }
+
+    audioHash = combined.finalize();
+    return destination.end();
+}
+
+ComparingSink::ComparingSink(AudioBlockSink& destination, const juce::AudioBuffer<float>& reference,
+                             int64 referenceSamples)
+    : destination(destination)
+    , reference(reference)
+    , referenceSamples(referenceSamples)
+{
+}
+
+bool ComparingSink::begin(double sampleRate, int numChannels, int64 expectedSamples)
+{
+    numSamplesCompared = 0;
+    maxDifference = 0.0f;
+    return destination.begin(sampleRate, numChannels, expectedSamples);
+}
+
+bool ComparingSink::writeBlock(const juce::AudioBuffer<float>& block)
+{
+    int numSamples = block.getNumSamples();
+    auto overlap = static_cast<int>(juce::jlimit<int64>(0, numSamples, referenceSamples - numSamplesCompared));
+    int numChannels = overlap > 0 ? juce::jmin(block.getNumChannels(), reference.getNumChannels()) : 0;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* rendered = block.getReadPointer(ch);
+        const float* expected = reference.getReadPointer(ch, static_cast<int>(numSamplesCompared));
+
+        for (int i = 0; i < overlap; ++i)
+            maxDifference = juce::jmax(maxDifference, std::abs(rendered[i] - expected[i]));
+    }
+
+    // Samples past the reference make matches() fail on length
+    numSamplesCompared += numSamples;
+    return destination.writeBlock(block);
+}
+
+bool ComparingSink::end()
+{
+    return destination.end();
+}
+
+MemorySink::MemorySink(float* const* destChannels, int numDestChannels, int64 capacity)
+    : numChannels(juce::jmin(numDestChannels, maxChannels))
+    , capacitySamples(capacity)
+{
+    jassert(numDestChannels <= maxChannels);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+        channels[ch] = destChannels[ch];
+}
+
+MemorySink::MemorySink(juce::AudioBuffer<float>& destination)
+    : MemorySink(destination.getArrayOfWritePointers(),
+                 destination.getNumChannels(),
+                 destination.getNumSamples())
+{
+}
+
+bool MemorySink::begin(double, int, int64 expectedSamples)
+{
+    numSamplesWritten = 0;
+    overflowed = false;
+
+    if (expectedSamples > capacitySamples)
+        logWarning("Memory sink capacity (" + juce::String(capacitySamples)
+                   + " samples) is smaller than the render (" + juce::String(expectedSamples) + ")");
+
+    return numChannels > 0;
+}
+
+bool MemorySink::writeBlock(const juce::AudioBuffer<float>& block)
+{
+    int blockChannels = block.getNumChannels();
+    int64 available = capacitySamples - numSamplesWritten;
+    int numSamples = static_cast<int>(juce::jmin(static_cast<int64>(block.getNumSamples()), available));
+
+    if (blockChannels > 0 && numSamples > 0)
+    {
+        // Extra destination channels repeat the last source channel (mono → stereo)
+        for (int ch = 0; ch < numChannels; ++ch)
+        {
+            const float* src = block.getReadPointer(juce::jmin(ch, blockChannels - 1));
+            juce::FloatVectorOperations::copy(channels[ch] + numSamplesWritten, src, numSamples);
+        }
+
+        numSamplesWritten += numSamples;
+    }
+
+    if (numSamples < block.getNumSamples())
+    {
+        overflowed = true;
+        return false;
+    }
+
+    return true;
+}
+
+bool MemorySink::end()
+{
+    return !overflowed;
+}
+
+} // namespace serum
@@ -0,0 +1,291 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "render/WavWriter.h"
+#include "render/AsyncWavWriter.h"
+#include "render/ShardWriter.h"
+#include "render/ShmAudioRing.h"
+#include "common/Hash.h"
+
+namespace serum {
+
+/**
+ * Destination for rendered audio blocks
+ * OfflineRenderer calls begin() once, writeBlock() for every block of the
+ * main and tail phases, then end()
+ */
+class AudioBlockSink
+{
+public:
+    virtual ~AudioBlockSink() = default;
+
+    /**
+     * Prepare for a render
+     * @param sampleRate Sample rate
+     * @param numChannels Number of channels in the blocks that follow
+     * @param expectedSamples Upper bound on the number of samples to be written
+     * @return true if ready to accept blocks
+     */
+    virtual bool begin(double sampleRate, int numChannels, int64 expectedSamples) = 0;
+
+    /**
+     * Consume one rendered block
+     * @param block Audio data, only valid for the duration of the call
+     * @return true if written successfully
+     */
+    virtual bool writeBlock(const juce::AudioBuffer<float>& block) = 0;
+
+    /**
+     * Finish the render (flush / close)
+     * @return true if finalized successfully
+     */
+    virtual bool end() = 0;
+};
+
+/**
+ * Streams blocks to a WAV, raw float32 or .npy file through WavWriter
+ */
+class WavFileSink : public AudioBlockSink
+{
+public:
+    /**
+     * Constructor
+     * @param outputFile Output file
+     * @param layout File channel layout relative to the rendered blocks
+     * @param format Sample encoding
+     */
+    explicit WavFileSink(const juce::File& outputFile, ChannelLayout layout = ChannelLayout::Stereo,
+                         SampleFormat format = SampleFormat::Pcm24);
+
+    bool begin(double sampleRate, int numChannels, int64 expectedSamples) override;
+    bool writeBlock(const juce::AudioBuffer<float>& block) override;
+    bool end() override;
+
+    /**
+     * Hash of the file computed while writing, valid after end() (see WavWriter::getFileHash())
+     */
+    bool getFileHash(Hash128& hash, int64& headerSize) const { return wavWriter.getFileHash(hash, headerSize); }
+
+private:
+    juce::File outputFile;
+    ChannelLayout layout;
+    SampleFormat format;
+    WavWriter wavWriter;
+};
+
+/**
+ * Hands blocks to a background AsyncWavWriter; end() does not wait for the disk
+ */
+class AsyncWavFileSink : public AudioBlockSink
+{
+public:
+    /**
+     * Constructor
+     * @param writer Shared background writer, outlives the sink
+     * @param outputFile Output file
+     * @param layout File channel layout relative to the rendered blocks
+     * @param format Sample encoding
+     */
+    AsyncWavFileSink(AsyncWavWriter& writer, const juce::File& outputFile,
+                     ChannelLayout layout = ChannelLayout::Stereo,
+                     SampleFormat format = SampleFormat::Pcm24);
+
+    bool begin(double sampleRate, int numChannels, int64 expectedSamples) override;
+    bool writeBlock(const juce::AudioBuffer<float>& block) override;
+    bool end() override;
+
+private:
+    AsyncWavWriter& writer;
+    juce::File outputFile;
+    ChannelLayout layout;
+    SampleFormat format;
+};
+
+/**
+ * Appends the render as one record of a packed shard (always float32)
+ */
+class ShardSink : public AudioBlockSink
+{
+public:
+    /**
+     * Constructor
+     * @param writer Shard writer, outlives the sink
+     * @param key Index key of the record
+     * @param layout Record channel layout relative to the rendered blocks
+     */
+    ShardSink(ShardWriter& writer, const ShardKey& key, ChannelLayout layout = ChannelLayout::Stereo);
+
+    bool begin(double sampleRate, int numChannels, int64 expectedSamples) override;
+    bool writeBlock(const juce::AudioBuffer<float>& block) override;
+    bool end() override;
+
+private:
+    ShardWriter& writer;
+    ShardKey key;
+    ChannelLayout layout;
+};
+
+/**
+ * Streams the render through a shared-memory ring to a consumer process
+ * The consumer stores the record (e.g. in a shard); metadata follows through
+ * ShmAudioRing::writeMetadata() once the render is complete
+ */
+class ShmSink : public AudioBlockSink
+{
+public:
+    /**
+     * Constructor
+     * @param ring Producer side of the ring, outlives the sink
+     * @param renderId Tags every message of this render
+     * @param key Index key of the record
+     * @param layout Record channel layout relative to the rendered blocks
+     */
+    ShmSink(ShmAudioRing& ring, uint64 renderId, const ShardKey& key,
+            ChannelLayout layout = ChannelLayout::Stereo);
+
+    bool begin(double sampleRate, int numChannels, int64 expectedSamples) override;
+    bool writeBlock(const juce::AudioBuffer<float>& block) override;
+    bool end() override;
+
+private:
+    ShmAudioRing& ring;
+    uint64 renderId;
+    ShardKey key;
+    ChannelLayout layout;
+};
+
+/**
+ * Copies blocks into caller-owned, preallocated float storage
+ * Never allocates; writes past the capacity are dropped and fail the render
+ */
+class MemorySink : public AudioBlockSink
+{
+public:
+    /**
+     * Constructor
+     * @param channels Caller-owned channel pointers
+     * @param numChannels Number of channel pointers
+     * @param capacitySamples Capacity of each channel in samples
+     */
+    MemorySink(float* const* channels, int numChannels, int64 capacitySamples);
+
+    /**
+     * Constructor writing into a caller-owned buffer, sized by the caller
+     */
+    explicit MemorySink(juce::AudioBuffer<float>& destination);
+
+    bool begin(double sampleRate, int numChannels, int64 expectedSamples) override;
+    bool writeBlock(const juce::AudioBuffer<float>& block) override;
+    bool end() override;
+
+    /**
+     * Number of samples written per channel
+     */
+    int64 getNumSamplesWritten() const { return numSamplesWritten; }
+
+    /**
+     * True if a render produced more samples than the storage holds
+     */
+    bool hasOverflowed() const { return overflowed; }
+
+private:
+    static constexpr int maxChannels = 8;
+
+    float* channels[maxChannels] = {};
+    int numChannels = 0;
+    int64 capacitySamples = 0;
+    int64 numSamplesWritten = 0;
+    bool overflowed = false;
+};
+
+/**
+ * Forwards blocks to another sink while hashing the rendered audio
+ * Every channel is hashed as it streams past, so there is no second pass over
+ * the output, and the hash does not depend on the block size. It covers the
+ * float samples as rendered, before any channel mapping or encoding.
+ */
+class HashingSink : public AudioBlockSink
+{
+public:
+    explicit HashingSink(AudioBlockSink& destination);
+
+    bool begin(double sampleRate, int numChannels, int64 expectedSamples) override;
+    bool writeBlock(const juce::AudioBuffer<float>& block) override;
+    bool end() override;
+
+    /**
+     * Hash of all channels, valid after end()
+     */
+    Hash128 getAudioHash() const { return audioHash; }
+
+private:
+    static constexpr int maxChannels = 8;
+
+    AudioBlockSink& destination;
+    FastHasher128 channelHashers[maxChannels];
+    int numChannels = 0;
+    Hash128 audioHash;
+};
+
+/**
+ * Forwards blocks to another sink while comparing them with a reference render
+ * Used to check that an optimized render path matches the straightforward one
+ */
+class ComparingSink : public AudioBlockSink
+{
+public:
+    /**
+     * Constructor
+     * @param destination Sink receiving the blocks
+     * @param reference Reference render, channel by channel
+     * @param referenceSamples Valid samples in reference
+     */
+    ComparingSink(AudioBlockSink& destination, const juce::AudioBuffer<float>& reference,
+                  int64 referenceSamples);
+
+    bool begin(double sampleRate, int numChannels, int64 expectedSamples) override;
+    bool writeBlock(const juce::AudioBuffer<float>& block) override;
+    bool end() override;
+
+    /**
+     * Largest absolute sample difference seen so far
+     */
+    float getMaxDifference() const { return maxDifference; }
+
+    /**
+     * True if the render had the reference's length and stayed within tolerance
+     */
+    bool matches(float tolerance) const
+    {
+        return numSamplesCompared == referenceSamples && maxDifference <= tolerance;
+    }
+
+private:
+    AudioBlockSink& destination;
+    const juce::AudioBuffer<float>& reference;
+    int64 referenceSamples;
+    int64 numSamplesCompared = 0;
+    float maxDifference = 0.0f;
+};
+
+/**
+ * Discards all audio; for benchmarking the render path without I/O
+ */
+class NullSink : public AudioBlockSink
+{
+public:
+    bool begin(double, int, int64) override { numSamplesWritten = 0; return true; }
+    bool writeBlock(const juce::AudioBuffer<float>& block) override
+    {
+        numSamplesWritten += block.getNumSamples();
+        return true;
+    }
+    bool end() override { return true; }
+
+    int64 getNumSamplesWritten() const { return numSamplesWritten; }
+
+private:
+    int64 numSamplesWritten = 0;
+};
+
+} // namespace serum
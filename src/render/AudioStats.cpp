@@ -1,8 +1,23 @@
 #include "render/AudioStats.h"
+#include <atomic>
 #include <cmath>
 
 namespace serum {
 
+static std::atomic<StatsKernelType> activeKernelType { getBestStatsKernel() };
+static std::atomic<ChannelStatsKernel> activeKernel { getStatsKernel(activeKernelType.load()) };
+
+void AudioStats::setKernel(StatsKernelType type)
+{
+    activeKernelType = isStatsKernelAvailable(type) ? type : StatsKernelType::Scalar;
+    activeKernel = getStatsKernel(activeKernelType.load());
+}
+
+StatsKernelType AudioStats::getKernel()
+{
+    return activeKernelType.load();
+}
+
 void AudioStats::updateBlock(const juce::AudioBuffer<float>& block)
 {
     int numChannels = block.getNumChannels();
@@ -11,31 +26,34 @@ void AudioStats::updateBlock(const juce::AudioBuffer<float>& block)
     if (numChannels == 0 || numSamples == 0)
         return;
     
+    auto kernel = activeKernel.load(std::memory_order_relaxed);
+    
     // Update left channel (or mono)
-    const float* leftData = block.getReadPointer(0);
-    for (int i = 0; i < numSamples; ++i)
-    {
-        float sample = std::abs(leftData[i]);
-        peakL = std::max(peakL, sample);
-        sumSquaresL += sample * sample;
-    }
+    ChannelBlockStats left;
+    kernel(block.getReadPointer(0), numSamples, historyL, left);
     
-    // Update right channel if stereo
-    if (numChannels >= 2)
-    {
-        const float* rightData = block.getReadPointer(1);
-        for (int i = 0; i < numSamples; ++i)
-        {
-            float sample = std::abs(rightData[i]);
-            peakR = std::max(peakR, sample);
-            sumSquaresR += sample * sample;
-        }
-    }
-    else
+    peakL = std::max(peakL, left.peak);
+    truePeakL = std::max(truePeakL, left.truePeak);
+    sumL += left.sum;
+    sumSquaresL += left.sumSquares;
+    zeroCrossingsL += left.zeroCrossings;
+    clippedSamplesL += left.clippedSamples;
+    blockPeak = left.peak;
+    
+    // Update right channel if stereo; mono is mirrored once in finalize()
+    isMono = numChannels < 2;
+    if (!isMono)
     {
-        // Mono - use same values for right
-        peakR = peakL;
-        sumSquaresR = sumSquaresL;
+        ChannelBlockStats right;
+        kernel(block.getReadPointer(1), numSamples, historyR, right);
+        
+        peakR = std::max(peakR, right.peak);
+        truePeakR = std::max(truePeakR, right.truePeak);
+        sumR += right.sum;
+        sumSquaresR += right.sumSquares;
+        zeroCrossingsR += right.zeroCrossings;
+        clippedSamplesR += right.clippedSamples;
+        blockPeak = std::max(blockPeak, right.peak);
     }
     
     totalSamples += numSamples;
@@ -43,19 +61,28 @@ void AudioStats::updateBlock(const juce::AudioBuffer<float>& block)
 
 void AudioStats::finalize()
 {
+    if (isMono)
+    {
+        peakR = peakL;
+        truePeakR = truePeakL;
+        sumR = sumL;
+        sumSquaresR = sumSquaresL;
+        zeroCrossingsR = zeroCrossingsL;
+        clippedSamplesR = clippedSamplesL;
+    }
+    
     if (totalSamples > 0)
     {
         rmsL = static_cast<float>(std::sqrt(sumSquaresL / totalSamples));
         rmsR = static_cast<float>(std::sqrt(sumSquaresR / totalSamples));
+        dcOffsetL = static_cast<float>(sumL / totalSamples);
+        dcOffsetR = static_cast<float>(sumR / totalSamples);
     }
 }
 
 void AudioStats::reset()
 {
-    peakL = peakR = 0.0f;
-    rmsL = rmsR = 0.0f;
-    sumSquaresL = sumSquaresR = 0.0;
-    totalSamples = 0;
+    *this = AudioStats();
 }
 
 } // namespace serum
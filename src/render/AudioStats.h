@@ -1,11 +1,14 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "render/AudioStatsKernels.h"
 
 namespace serum {
 
 /**
  * Online audio statistics computed during streaming
+ * Each channel is scanned once per block by a vectorized kernel chosen at
+ * runtime (AVX / SSE2 / scalar)
  */
 struct AudioStats
 {
@@ -15,9 +18,26 @@ struct AudioStats
     float rmsR = 0.0f;
     int64 totalSamples = 0;
     
+    float truePeakL = 0.0f;      // Includes interpolated inter-sample peaks
+    float truePeakR = 0.0f;
+    float dcOffsetL = 0.0f;      // Mean sample value
+    float dcOffsetR = 0.0f;
+    int64 zeroCrossingsL = 0;
+    int64 zeroCrossingsR = 0;
+    int64 clippedSamplesL = 0;   // Samples at or above full scale
+    int64 clippedSamplesR = 0;
+    
+    float blockPeak = 0.0f;  // Peak over all channels of the most recent block
+    
+    double sumL = 0.0;
+    double sumR = 0.0;
     double sumSquaresL = 0.0;
     double sumSquaresR = 0.0;
     
+    bool isMono = false;     // Right channel statistics mirror the left
+    ChannelHistory historyL;
+    ChannelHistory historyR;
+    
     /**
      * Update statistics with a new block
      */
@@ -32,6 +52,16 @@ struct AudioStats
      * Reset statistics
      */
     void reset();
+    
+    /**
+     * Override the kernel used by every AudioStats (benchmarking / verification)
+     */
+    static void setKernel(StatsKernelType type);
+    
+    /**
+     * Kernel currently in use
+     */
+    static StatsKernelType getKernel();
 };
 
 } // namespace serum
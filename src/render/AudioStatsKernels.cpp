@@ -0,0 +1,311 @@
+#include "render/AudioStatsKernels.h"
+#include <cmath>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+ #define SERUM_STATS_X86 1
+ #include <immintrin.h>
+#else
+ #define SERUM_STATS_X86 0
+#endif
+
+// GCC and Clang need the ISA enabled per function for the AVX kernel to
+// compile without -mavx; MSVC accepts the intrinsics unconditionally
+#if SERUM_STATS_X86 && (defined(__GNUC__) || defined(__clang__))
+ #define SERUM_TARGET_SSE2 __attribute__((target("sse2")))
+ #define SERUM_TARGET_AVX  __attribute__((target("avx")))
+#else
+ #define SERUM_TARGET_SSE2
+ #define SERUM_TARGET_AVX
+#endif
+
+namespace serum {
+
+// Catmull-Rom weights for x[i-1], x[i], x[i+1], x[i+2] at t = 0.25, 0.5, 0.75
+// between x[i] and x[i+1]; used to estimate inter-sample peaks
+static constexpr float interpWeights[3][4] = {
+    { -0.0703125f, 0.8671875f, 0.2265625f, -0.0234375f },
+    { -0.0625f,    0.5625f,    0.5625f,    -0.0625f    },
+    { -0.0234375f, 0.2265625f, 0.8671875f, -0.0703125f },
+};
+
+// Samples accumulated in float lanes before the sums are flushed to double
+static constexpr int simdChunkSize = 4096;
+
+static inline float sampleAt(const float* data, const ChannelHistory& history, int index)
+{
+    return index >= 0 ? data[index] : history.samples[3 + index];
+}
+
+static inline float interpolatedPeak(float a, float b, float c, float d)
+{
+    float peak = 0.0f;
+    for (const auto& w : interpWeights)
+        peak = std::max(peak, std::abs(w[0] * a + w[1] * b + w[2] * c + w[3] * d));
+    return peak;
+}
+
+// Sample j closes the interpolation segment between j-2 and j-1 (needs j-3..j),
+// and the zero crossing between j-1 and j. Indices below zero read the history.
+static void scalarRange(const float* data, const ChannelHistory& history,
+                        int begin, int end, ChannelBlockStats& out)
+{
+    for (int j = begin; j < end; ++j)
+    {
+        float x = data[j];
+        float magnitude = std::abs(x);
+
+        out.peak = std::max(out.peak, magnitude);
+        out.sum += x;
+        out.sumSquares += static_cast<double>(x) * x;
+
+        if (magnitude >= clipThreshold)
+            ++out.clippedSamples;
+
+        if (j > 0 || history.primed)
+        {
+            float previous = sampleAt(data, history, j - 1);
+            if ((previous < 0.0f) != (x < 0.0f))
+                ++out.zeroCrossings;
+        }
+
+        if (j >= 3 || history.primed)
+        {
+            out.truePeak = std::max(out.truePeak, interpolatedPeak(
+                sampleAt(data, history, j - 3),
+                sampleAt(data, history, j - 2),
+                sampleAt(data, history, j - 1),
+                x));
+        }
+    }
+}
+
+static void finishBlock(const float* data, int numSamples, ChannelHistory& history, ChannelBlockStats& out)
+{
+    out.truePeak = std::max(out.truePeak, out.peak);
+
+    for (int i = juce::jmax(0, numSamples - 3); i < numSamples; ++i)
+    {
+        history.samples[0] = history.samples[1];
+        history.samples[1] = history.samples[2];
+        history.samples[2] = data[i];
+    }
+
+    if (numSamples > 0)
+        history.primed = true;
+}
+
+static void scalarKernel(const float* data, int numSamples, ChannelHistory& history, ChannelBlockStats& out)
+{
+    out = ChannelBlockStats();
+    scalarRange(data, history, 0, numSamples, out);
+    finishBlock(data, numSamples, history, out);
+}
+
+#if SERUM_STATS_X86
+
+SERUM_TARGET_SSE2 static inline float horizontalSum(__m128 v)
+{
+    __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 sums = _mm_add_ps(v, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, sums);
+    return _mm_cvtss_f32(_mm_add_ss(sums, shuffled));
+}
+
+SERUM_TARGET_SSE2 static inline float horizontalMax(__m128 v)
+{
+    __m128 shuffled = _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1));
+    __m128 maxes = _mm_max_ps(v, shuffled);
+    shuffled = _mm_movehl_ps(shuffled, maxes);
+    return _mm_cvtss_f32(_mm_max_ss(maxes, shuffled));
+}
+
+SERUM_TARGET_SSE2 static void sse2Kernel(const float* data, int numSamples,
+                                         ChannelHistory& history, ChannelBlockStats& out)
+{
+    out = ChannelBlockStats();
+
+    // The first three samples look back into the previous block
+    int j = juce::jmin(3, numSamples);
+    scalarRange(data, history, 0, j, out);
+
+    const __m128 signMask = _mm_set1_ps(-0.0f);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 clip = _mm_set1_ps(clipThreshold);
+
+    __m128 w[3][4];
+    for (int p = 0; p < 3; ++p)
+        for (int k = 0; k < 4; ++k)
+            w[p][k] = _mm_set1_ps(interpWeights[p][k]);
+
+    __m128 peak = zero;
+    __m128 truePeak = zero;
+
+    while (j + 4 <= numSamples)
+    {
+        int chunkEnd = juce::jmin(numSamples, j + simdChunkSize);
+        __m128 sum = zero;
+        __m128 sumSquares = zero;
+
+        for (; j + 4 <= chunkEnd; j += 4)
+        {
+            __m128 x = _mm_loadu_ps(data + j);
+            __m128 x1 = _mm_loadu_ps(data + j - 1);
+            __m128 x2 = _mm_loadu_ps(data + j - 2);
+            __m128 x3 = _mm_loadu_ps(data + j - 3);
+            __m128 magnitude = _mm_andnot_ps(signMask, x);
+
+            peak = _mm_max_ps(peak, magnitude);
+            sum = _mm_add_ps(sum, x);
+            sumSquares = _mm_add_ps(sumSquares, _mm_mul_ps(x, x));
+
+            out.clippedSamples += juce::countNumberOfBits(
+                static_cast<uint32>(_mm_movemask_ps(_mm_cmpge_ps(magnitude, clip))));
+            out.zeroCrossings += juce::countNumberOfBits(
+                static_cast<uint32>(_mm_movemask_ps(_mm_xor_ps(_mm_cmplt_ps(x, zero),
+                                                               _mm_cmplt_ps(x1, zero)))));
+
+            for (int p = 0; p < 3; ++p)
+            {
+                __m128 y = _mm_add_ps(_mm_add_ps(_mm_mul_ps(x3, w[p][0]), _mm_mul_ps(x2, w[p][1])),
+                                      _mm_add_ps(_mm_mul_ps(x1, w[p][2]), _mm_mul_ps(x, w[p][3])));
+                truePeak = _mm_max_ps(truePeak, _mm_andnot_ps(signMask, y));
+            }
+        }
+
+        out.sum += horizontalSum(sum);
+        out.sumSquares += horizontalSum(sumSquares);
+    }
+
+    scalarRange(data, history, j, numSamples, out);
+
+    out.peak = std::max(out.peak, horizontalMax(peak));
+    out.truePeak = std::max(out.truePeak, horizontalMax(truePeak));
+    finishBlock(data, numSamples, history, out);
+}
+
+SERUM_TARGET_AVX static inline __m128 lowerPlusUpper(__m256 v)
+{
+    return _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+}
+
+SERUM_TARGET_AVX static inline __m128 lowerMaxUpper(__m256 v)
+{
+    return _mm_max_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+}
+
+SERUM_TARGET_AVX static void avxKernel(const float* data, int numSamples,
+                                       ChannelHistory& history, ChannelBlockStats& out)
+{
+    out = ChannelBlockStats();
+
+    int j = juce::jmin(3, numSamples);
+    scalarRange(data, history, 0, j, out);
+
+    const __m256 signMask = _mm256_set1_ps(-0.0f);
+    const __m256 zero = _mm256_setzero_ps();
+    const __m256 clip = _mm256_set1_ps(clipThreshold);
+
+    __m256 w[3][4];
+    for (int p = 0; p < 3; ++p)
+        for (int k = 0; k < 4; ++k)
+            w[p][k] = _mm256_set1_ps(interpWeights[p][k]);
+
+    __m256 peak = zero;
+    __m256 truePeak = zero;
+
+    while (j + 8 <= numSamples)
+    {
+        int chunkEnd = juce::jmin(numSamples, j + simdChunkSize);
+        __m256 sum = zero;
+        __m256 sumSquares = zero;
+
+        for (; j + 8 <= chunkEnd; j += 8)
+        {
+            __m256 x = _mm256_loadu_ps(data + j);
+            __m256 x1 = _mm256_loadu_ps(data + j - 1);
+            __m256 x2 = _mm256_loadu_ps(data + j - 2);
+            __m256 x3 = _mm256_loadu_ps(data + j - 3);
+            __m256 magnitude = _mm256_andnot_ps(signMask, x);
+
+            peak = _mm256_max_ps(peak, magnitude);
+            sum = _mm256_add_ps(sum, x);
+            sumSquares = _mm256_add_ps(sumSquares, _mm256_mul_ps(x, x));
+
+            out.clippedSamples += juce::countNumberOfBits(
+                static_cast<uint32>(_mm256_movemask_ps(_mm256_cmp_ps(magnitude, clip, _CMP_GE_OQ))));
+            out.zeroCrossings += juce::countNumberOfBits(
+                static_cast<uint32>(_mm256_movemask_ps(_mm256_xor_ps(_mm256_cmp_ps(x, zero, _CMP_LT_OQ),
+                                                                     _mm256_cmp_ps(x1, zero, _CMP_LT_OQ)))));
+
+            for (int p = 0; p < 3; ++p)
+            {
+                __m256 y = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(x3, w[p][0]), _mm256_mul_ps(x2, w[p][1])),
+                                         _mm256_add_ps(_mm256_mul_ps(x1, w[p][2]), _mm256_mul_ps(x, w[p][3])));
+                truePeak = _mm256_max_ps(truePeak, _mm256_andnot_ps(signMask, y));
+            }
+        }
+
+        out.sum += horizontalSum(lowerPlusUpper(sum));
+        out.sumSquares += horizontalSum(lowerPlusUpper(sumSquares));
+    }
+
+    scalarRange(data, history, j, numSamples, out);
+
+    out.peak = std::max(out.peak, horizontalMax(lowerMaxUpper(peak)));
+    out.truePeak = std::max(out.truePeak, horizontalMax(lowerMaxUpper(truePeak)));
+    finishBlock(data, numSamples, history, out);
+}
+
+#endif // SERUM_STATS_X86
+
+bool isStatsKernelAvailable(StatsKernelType type)
+{
+    switch (type)
+    {
+        case StatsKernelType::Scalar: return true;
+#if SERUM_STATS_X86
+        case StatsKernelType::SSE2:   return juce::SystemStats::hasSSE2();
+        case StatsKernelType::AVX:    return juce::SystemStats::hasAVX();
+#endif
+        default:                      return false;
+    }
+}
+
+StatsKernelType getBestStatsKernel()
+{
+    if (isStatsKernelAvailable(StatsKernelType::AVX))
+        return StatsKernelType::AVX;
+
+    if (isStatsKernelAvailable(StatsKernelType::SSE2))
+        return StatsKernelType::SSE2;
+
+    return StatsKernelType::Scalar;
+}
+
+ChannelStatsKernel getStatsKernel(StatsKernelType type)
+{
+    if (!isStatsKernelAvailable(type))
+        return scalarKernel;
+
+    switch (type)
+    {
+#if SERUM_STATS_X86
+        case StatsKernelType::SSE2: return sse2Kernel;
+        case StatsKernelType::AVX:  return avxKernel;
+#endif
+        default:                    return scalarKernel;
+    }
+}
+
+const char* getStatsKernelName(StatsKernelType type)
+{
+    switch (type)
+    {
+        case StatsKernelType::Scalar: return "scalar";
+        case StatsKernelType::SSE2:   return "sse2";
+        case StatsKernelType::AVX:    return "avx";
+        default:                      return "unknown";
+    }
+}
+
+} // namespace serum
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace serum {
+
+/**
+ * Samples at or above this magnitude count as clipped
+ */
+constexpr float clipThreshold = 1.0f;
+
+/**
+ * Per-channel state carried from one block to the next
+ * Zero crossings and inter-sample (true) peaks look back across block boundaries
+ */
+struct ChannelHistory
+{
+    float samples[3] = { 0.0f, 0.0f, 0.0f };  // Last three samples, oldest first
+    bool primed = false;                      // False until the first block was seen
+};
+
+/**
+ * Statistics of one channel over one block
+ */
+struct ChannelBlockStats
+{
+    float peak = 0.0f;
+    float truePeak = 0.0f;        // Peak including 4x interpolated inter-sample values
+    double sum = 0.0;
+    double sumSquares = 0.0;
+    int64 zeroCrossings = 0;
+    int64 clippedSamples = 0;
+};
+
+/**
+ * Single-pass statistics kernel over one channel of one block
+ * @param data Channel samples
+ * @param numSamples Number of samples
+ * @param history Cross-block state, updated in place
+ * @param out Output statistics for this block
+ */
+using ChannelStatsKernel = void (*)(const float* data, int numSamples,
+                                    ChannelHistory& history, ChannelBlockStats& out);
+
+/**
+ * Available kernel implementations
+ */
+enum class StatsKernelType
+{
+    Scalar,
+    SSE2,
+    AVX
+};
+
+/**
+ * True if the CPU supports the kernel
+ */
+bool isStatsKernelAvailable(StatsKernelType type);
+
+/**
+ * Fastest kernel supported by this CPU
+ */
+StatsKernelType getBestStatsKernel();
+
+/**
+ * Kernel function for a type; falls back to scalar if unavailable
+ */
+ChannelStatsKernel getStatsKernel(StatsKernelType type);
+
+/**
+ * Human-readable kernel name
+ */
+const char* getStatsKernelName(StatsKernelType type);
+
+} // namespace serum
@@ -0,0 +1,110 @@
+#include "render/BlockSizeTuner.h"
+#include "render/OfflineRenderer.h"
+#include "midi/MidiPattern.h"
+#include "common/Log.h"
+#include "common/Paths.h"
+
+namespace serum {
+
+BlockSizeTuner::BlockSizeTuner(juce::AudioPluginInstance& plugin)
+    : plugin(plugin)
+{
+}
+
+int BlockSizeTuner::tune(double sampleRate)
+{
+    measurements.clear();
+
+    // Sixteenth notes at 120 BPM, so a split render has events to split at
+    MidiPattern pattern;
+    pattern.type = MidiPattern::Type::Arpeggio;
+    pattern.intervals = { 0, 4, 7, 12 };
+    pattern.stepSec = 0.125;
+
+    MidiTimeline timeline;
+    juce::String errorMsg;
+    pattern.build(timeline, "C4", 100, renderSeconds, sampleRate, errorMsg);
+
+    RenderSession session(plugin);
+    Measurement best;
+
+    for (int blockSize : candidates)
+    {
+        if (blockSize <= 0)
+            continue;
+
+        OfflineRenderer renderer(session, timeline, sampleRate, blockSize, renderSeconds, 0.0, 0.0);
+        renderer.setSplitAtEvents(splitAtEvents);
+
+        // The first render pays for prepareToPlay and cold caches
+        NullSink sink;
+        AudioStats stats;
+        if (!renderer.render(sink, stats))
+        {
+            logWarning("Block size " + juce::String(blockSize) + " failed to render");
+            continue;
+        }
+
+        auto startTicks = juce::Time::getHighResolutionTicks();
+        bool rendered = renderer.render(sink, stats);
+        double seconds = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - startTicks);
+        if (!rendered)
+            continue;
+
+        Measurement measurement;
+        measurement.blockSize = blockSize;
+        measurement.samplesPerSecond = seconds > 0.0 ? static_cast<double>(sink.getNumSamplesWritten()) / seconds : 0.0;
+        measurements.push_back(measurement);
+
+        if (measurement.samplesPerSecond > best.samplesPerSecond)
+            best = measurement;
+    }
+
+    session.release();
+
+    if (best.blockSize > 0)
+        logInfo("Fastest block size: " + juce::String(best.blockSize) + " ("
+                + juce::String(best.samplesPerSecond / 1.0e6, 2) + " Msamples/s)");
+
+    return best.blockSize;
+}
+
+juce::File BlockSizeTuner::getDefaultCacheFile()
+{
+    return getOutputMetaDir().getChildFile("block_size.json");
+}
+
+juce::String BlockSizeTuner::getCacheEntryName(const juce::String& pluginId, double sampleRate)
+{
+    return pluginId + "@" + juce::String(juce::roundToInt(sampleRate));
+}
+
+int BlockSizeTuner::loadTunedBlockSize(const juce::File& cacheFile, const juce::String& pluginId, double sampleRate)
+{
+    if (!cacheFile.existsAsFile())
+        return 0;
+
+    auto cached = juce::JSON::parse(cacheFile);
+    return static_cast<int>(cached.getProperty(getCacheEntryName(pluginId, sampleRate), 0));
+}
+
+bool BlockSizeTuner::saveTunedBlockSize(const juce::File& cacheFile, const juce::String& pluginId,
+                                        double sampleRate, int blockSize)
+{
+    auto cached = cacheFile.existsAsFile() ? juce::JSON::parse(cacheFile) : juce::var();
+    if (!cached.isObject())
+        cached = juce::var(new juce::DynamicObject());
+
+    cached.getDynamicObject()->setProperty(getCacheEntryName(pluginId, sampleRate), blockSize);
+
+    ensureDirectoryExists(cacheFile.getParentDirectory());
+    if (!cacheFile.replaceWithText(juce::JSON::toString(cached)))
+    {
+        logError("Failed to write block size cache: " + cacheFile.getFullPathName());
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace serum
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <vector>
+
+namespace serum {
+
+/**
+ * Picks the render block size with the best measured throughput for a plugin
+ *
+ * Renders a short arpeggio at every candidate size into a NullSink and keeps
+ * the fastest. The choice can be remembered per plugin and sample rate in a
+ * JSON file, so later runs skip the measurement.
+ */
+class BlockSizeTuner
+{
+public:
+    struct Measurement
+    {
+        int blockSize = 0;
+        double samplesPerSecond = 0.0;
+    };
+
+    /**
+     * Constructor
+     * @param plugin Plugin to measure; prepared and released by tune()
+     */
+    explicit BlockSizeTuner(juce::AudioPluginInstance& plugin);
+
+    /**
+     * Block sizes to try (default 64 to 8192, powers of two)
+     */
+    void setCandidates(const juce::Array<int>& blockSizes) { candidates = blockSizes; }
+
+    /**
+     * Length of each timed render
+     */
+    void setRenderSeconds(double seconds) { renderSeconds = seconds; }
+
+    /**
+     * Measure with blocks split at MIDI events
+     */
+    void setSplitAtEvents(bool shouldSplit) { splitAtEvents = shouldSplit; }
+
+    /**
+     * Measure every candidate
+     * @return the fastest block size, 0 if every render failed
+     */
+    int tune(double sampleRate);
+
+    /**
+     * Results of the last tune(), in candidate order
+     */
+    const std::vector<Measurement>& getMeasurements() const { return measurements; }
+
+    /**
+     * Default file for remembered choices (data/outmeta/block_size.json)
+     */
+    static juce::File getDefaultCacheFile();
+
+    /**
+     * Look up a remembered block size
+     * @param pluginId Plugin identity (PluginDescription::createIdentifierString())
+     * @return the block size, 0 if none is stored
+     */
+    static int loadTunedBlockSize(const juce::File& cacheFile, const juce::String& pluginId, double sampleRate);
+
+    /**
+     * Remember a block size, keeping other plugins' entries
+     */
+    static bool saveTunedBlockSize(const juce::File& cacheFile, const juce::String& pluginId,
+                                   double sampleRate, int blockSize);
+
+private:
+    juce::AudioPluginInstance& plugin;
+    juce::Array<int> candidates { 64, 128, 256, 512, 1024, 2048, 4096, 8192 };
+    double renderSeconds = 4.0;
+    bool splitAtEvents = false;
+    std::vector<Measurement> measurements;
+
+    static juce::String getCacheEntryName(const juce::String& pluginId, double sampleRate);
+};
+
+} // namespace serum
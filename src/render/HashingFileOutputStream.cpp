@@ -0,0 +1,57 @@
+#include "render/HashingFileOutputStream.h"
+
+namespace serum {
+
+HashingFileOutputStream::HashingFileOutputStream(const juce::File& file)
+    : stream(file)
+{
+}
+
+void HashingFileOutputStream::markDataStart()
+{
+    dataStart = dataEnd = stream.getPosition();
+    header.setSize(static_cast<size_t>(dataStart), true);
+}
+
+bool HashingFileOutputStream::getFileHash(Hash128& result, int64& headerSize) const
+{
+    if (!sequential || dataStart < 0)
+        return false;
+
+    // The header goes last, as it is only final once the writer closes
+    auto hasher = dataHasher;
+    hasher.update(header.getData(), header.getSize());
+    result = hasher.finalize();
+    headerSize = dataStart;
+    return true;
+}
+
+bool HashingFileOutputStream::write(const void* data, size_t numBytes)
+{
+    const auto position = stream.getPosition();
+    const auto end = position + static_cast<int64>(numBytes);
+
+    if (dataStart < 0)
+    {
+        header.ensureSize(static_cast<size_t>(end), true);
+        header.copyFrom(data, static_cast<int>(position), numBytes);
+    }
+    else if (end <= dataStart)
+    {
+        // Header rewrite; its size is fixed once data follows
+        header.copyFrom(data, static_cast<int>(position), numBytes);
+    }
+    else if (position == dataEnd)
+    {
+        dataHasher.update(data, numBytes);
+        dataEnd = end;
+    }
+    else
+    {
+        sequential = false;
+    }
+
+    return stream.write(data, numBytes);
+}
+
+} // namespace serum
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "common/Hash.h"
+
+namespace serum {
+
+/**
+ * File output stream that hashes what it writes, so a finished file never has
+ * to be read back to be verified or cached
+ *
+ * Everything written before markDataStart() is the header, which writers
+ * rewrite on close; it is kept in memory and hashed last. Bytes after it are
+ * hashed as they stream out. The result equals
+ * computeFastHash128FromFile(file, headerSize) as long as the data is written
+ * front to back and the header keeps its size.
+ */
+class HashingFileOutputStream : public juce::OutputStream
+{
+public:
+    explicit HashingFileOutputStream(const juce::File& file);
+
+    bool openedOk() const { return stream.openedOk(); }
+    juce::Result getStatus() const { return stream.getStatus(); }
+
+    /**
+     * Treat the bytes written so far as the header
+     */
+    void markDataStart();
+
+    /**
+     * Hash of the file as written so far
+     * @param headerSize Receives the header size to verify the hash with
+     * @return false if the data was not written front to back or the header
+     *         grew, in which case the file has to be hashed from disk
+     */
+    bool getFileHash(Hash128& result, int64& headerSize) const;
+
+    // OutputStream
+    void flush() override { stream.flush(); }
+    bool setPosition(int64 newPosition) override { return stream.setPosition(newPosition); }
+    int64 getPosition() override { return stream.getPosition(); }
+    bool write(const void* data, size_t numBytes) override;
+
+private:
+    juce::FileOutputStream stream;
+    juce::MemoryBlock header;
+    FastHasher128 dataHasher;
+    int64 dataStart = -1;   // Until markDataStart(), everything is header
+    int64 dataEnd = 0;      // Next byte the data hash expects
+    bool sequential = true;
+
+    JUCE_DECLARE_NON_COPYABLE(HashingFileOutputStream)
+};
+
+} // namespace serum
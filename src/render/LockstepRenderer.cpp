@@ -0,0 +1,193 @@
+#include "render/LockstepRenderer.h"
+#include "render/RenderTimings.h"
+#include "common/Log.h"
+
+namespace serum {
+
+static int64 secondsToBlocks(double seconds, double sampleRate, int blockSize)
+{
+    auto samples = static_cast<int64>(seconds * sampleRate);
+    return (samples + blockSize - 1) / blockSize;
+}
+
+LockstepRenderer::LockstepRenderer(double sampleRate, int blockSize, double renderLengthSec,
+                                   double tailSec, double warmupSec)
+    : sampleRate(sampleRate)
+    , blockSize(blockSize)
+    , renderLengthSec(renderLengthSec)
+    , tailSec(tailSec)
+    , warmupSec(warmupSec)
+{
+}
+
+void LockstepRenderer::setAdaptiveTail(float threshold, int blocksToStop)
+{
+    adaptiveTail = blocksToStop > 0;
+    silenceThreshold = threshold;
+    silentBlocksToStop = blocksToStop;
+}
+
+int LockstepRenderer::addLane(RenderSession& session, MidiEventSource& midiSource, AudioBlockSink& sink)
+{
+    Lane lane;
+    lane.session = &session;
+    lane.midiSource = &midiSource;
+    lane.sink = &sink;
+    lanes.push_back(lane);
+    return getNumLanes() - 1;
+}
+
+int64 LockstepRenderer::getTotalSamples() const
+{
+    return (secondsToBlocks(renderLengthSec, sampleRate, blockSize)
+            + secondsToBlocks(tailSec, sampleRate, blockSize)) * blockSize;
+}
+
+bool LockstepRenderer::writeBlock(Lane& lane, juce::AudioBuffer<float>& buffer)
+{
+    bool written;
+    {
+        ScopedPhaseTimer timer(RenderPhase::Write);
+        written = lane.sink->writeBlock(buffer);
+    }
+
+    if (!written)
+    {
+        logError("Lockstep lane failed to write audio block");
+        lane.sink->end();
+        lane.failed = true;
+        return false;
+    }
+
+    ScopedPhaseTimer timer(RenderPhase::Stats);
+    lane.stats.updateBlock(buffer);
+    return true;
+}
+
+bool LockstepRenderer::render()
+{
+    SERUM_LOG_DEBUG("Starting lockstep render of " + juce::String(getNumLanes()) + " views");
+
+    for (auto& lane : lanes)
+    {
+        lane.stats.reset();
+        lane.failed = lane.tailDone = lane.succeeded = lane.tailCutShort = false;
+        lane.silentBlocks = 0;
+        lane.renderedTailSamples = 0;
+
+        if (lane.session->prepare(sampleRate, blockSize))
+            lane.session->resetForNextRender();
+
+        ScopedPhaseTimer timer(RenderPhase::Write);
+        if (!lane.sink->begin(sampleRate, lane.session->getNumChannels(), getTotalSamples()))
+        {
+            logError("Failed to open output sink");
+            lane.failed = true;
+        }
+    }
+
+    // Phase 1: Warmup, one block per lane in turn
+    int64 warmupBlocks = secondsToBlocks(warmupSec, sampleRate, blockSize);
+    for (int64 i = 0; i < warmupBlocks; ++i)
+    {
+        ScopedPhaseTimer timer(RenderPhase::Warmup);
+        for (auto& lane : lanes)
+        {
+            if (lane.failed)
+                continue;
+
+            auto& buffer = lane.session->getBuffer();
+            auto& midi = lane.session->getMidiBuffer();
+            buffer.clear();
+            midi.clear();
+            lane.session->getPlugin().processBlock(buffer, midi);
+        }
+    }
+
+    for (auto& lane : lanes)
+        lane.midiSource->reset();
+
+    // Phase 2: Main render on the shared block clock
+    int64 renderBlocks = secondsToBlocks(renderLengthSec, sampleRate, blockSize);
+    int64 currentSample = 0;
+    for (int64 i = 0; i < renderBlocks; ++i)
+    {
+        for (auto& lane : lanes)
+        {
+            if (lane.failed)
+                continue;
+
+            auto& buffer = lane.session->getBuffer();
+            auto& midi = lane.session->getMidiBuffer();
+            {
+                ScopedPhaseTimer timer(RenderPhase::MainRender);
+                buffer.clear();
+                lane.midiSource->popEvents(currentSample, blockSize, midi);
+                if (splitAtEvents && !midi.isEmpty())
+                    lane.session->processSplitAtEvents(buffer, midi);
+                else
+                    lane.session->getPlugin().processBlock(buffer, midi);
+            }
+            writeBlock(lane, buffer);
+        }
+
+        currentSample += blockSize;
+    }
+
+    // Phase 3: Tail, until every lane has finished or reached tailSec
+    int64 tailBlocks = secondsToBlocks(tailSec, sampleRate, blockSize);
+    for (int64 i = 0; i < tailBlocks; ++i)
+    {
+        bool anyActive = false;
+        for (auto& lane : lanes)
+        {
+            if (lane.failed || lane.tailDone)
+                continue;
+
+            auto& buffer = lane.session->getBuffer();
+            auto& midi = lane.session->getMidiBuffer();
+            {
+                ScopedPhaseTimer timer(RenderPhase::Tail);
+                buffer.clear();
+                midi.clear();
+                lane.session->getPlugin().processBlock(buffer, midi);
+            }
+
+            if (!writeBlock(lane, buffer))
+                continue;
+
+            lane.renderedTailSamples += blockSize;
+            anyActive = true;
+
+            if (adaptiveTail)
+            {
+                lane.silentBlocks = lane.stats.blockPeak < silenceThreshold ? lane.silentBlocks + 1 : 0;
+                if (lane.silentBlocks >= silentBlocksToStop && i + 1 < tailBlocks)
+                    lane.tailDone = lane.tailCutShort = true;
+            }
+        }
+
+        if (!anyActive)
+            break;
+    }
+
+    bool allSucceeded = true;
+    for (auto& lane : lanes)
+    {
+        if (!lane.failed)
+        {
+            lane.stats.finalize();
+
+            ScopedPhaseTimer timer(RenderPhase::Close);
+            lane.succeeded = lane.sink->end();
+            if (!lane.succeeded)
+                logError("Failed to finalize output sink");
+        }
+
+        allSucceeded = allSucceeded && lane.succeeded;
+    }
+
+    return allSucceeded;
+}
+
+} // namespace serum
@@ -0,0 +1,111 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "midi/MidiEventSource.h"
+#include "render/AudioBlockSink.h"
+#include "render/AudioStats.h"
+#include "render/RenderSession.h"
+#include <vector>
+
+namespace serum {
+
+/**
+ * Renders several views at once on separate plugin instances (experimental)
+ *
+ * Every lane has its own session, MIDI source and sink; all lanes share one
+ * block clock. Each block is processed for every lane in turn on the calling
+ * thread, so lanes that run the same plugin and preset keep its code and
+ * tables hot in cache. Instances never share state, so views stay isolated.
+ *
+ * Phases and timing match OfflineRenderer with the same settings; the
+ * adaptive tail is decided per lane.
+ */
+class LockstepRenderer
+{
+public:
+    /**
+     * Constructor
+     * @param sampleRate Sample rate
+     * @param blockSize Block size
+     * @param renderLengthSec Main render length in seconds
+     * @param tailSec Tail length in seconds
+     * @param warmupSec Warmup length in seconds
+     */
+    LockstepRenderer(double sampleRate, int blockSize, double renderLengthSec, double tailSec, double warmupSec);
+
+    /**
+     * Stop a lane's tail early once it has decayed to silence
+     * @param silenceThreshold Linear peak below which a block counts as silent
+     * @param silentBlocksToStop Consecutive silent blocks that end the tail
+     */
+    void setAdaptiveTail(float silenceThreshold, int silentBlocksToStop);
+
+    /**
+     * Split main-phase blocks at MIDI events (see RenderSession::processSplitAtEvents)
+     */
+    void setSplitAtEvents(bool shouldSplit) { splitAtEvents = shouldSplit; }
+
+    /**
+     * Add a view; the session's plugin must not be used by another lane
+     * All references must outlive render()
+     * @return lane index
+     */
+    int addLane(RenderSession& session, MidiEventSource& midiSource, AudioBlockSink& sink);
+
+    /**
+     * Remove every lane
+     */
+    void clearLanes() { lanes.clear(); }
+
+    int getNumLanes() const { return static_cast<int>(lanes.size()); }
+
+    /**
+     * Render every lane
+     * A failing lane is dropped, the others carry on
+     * @return true if every lane succeeded
+     */
+    bool render();
+
+    bool didLaneSucceed(int lane) const { return lanes[static_cast<size_t>(lane)].succeeded; }
+    const AudioStats& getStats(int lane) const { return lanes[static_cast<size_t>(lane)].stats; }
+    bool wasTailCutShort(int lane) const { return lanes[static_cast<size_t>(lane)].tailCutShort; }
+
+    double getRenderedTailSec(int lane) const
+    {
+        return static_cast<double>(lanes[static_cast<size_t>(lane)].renderedTailSamples) / sampleRate;
+    }
+
+private:
+    struct Lane
+    {
+        RenderSession* session = nullptr;
+        MidiEventSource* midiSource = nullptr;
+        AudioBlockSink* sink = nullptr;
+        AudioStats stats;
+
+        bool failed = false;
+        bool tailDone = false;
+        bool succeeded = false;
+        bool tailCutShort = false;
+        int silentBlocks = 0;
+        int64 renderedTailSamples = 0;
+    };
+
+    double sampleRate;
+    int blockSize;
+    double renderLengthSec;
+    double tailSec;
+    double warmupSec;
+
+    bool adaptiveTail = false;
+    float silenceThreshold = 0.0f;
+    int silentBlocksToStop = 0;
+    bool splitAtEvents = false;
+
+    std::vector<Lane> lanes;
+
+    int64 getTotalSamples() const;
+    bool writeBlock(Lane& lane, juce::AudioBuffer<float>& buffer);
+};
+
+} // namespace serum
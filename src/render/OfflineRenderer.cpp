@@ -1,18 +1,21 @@
 #include "render/OfflineRenderer.h"
+#include "render/RenderTimings.h"
 #include "common/Log.h"
 
 namespace serum {
 
 OfflineRenderer::OfflineRenderer(
     juce::AudioPluginInstance& plugin,
-    SyntheticMidiGenerator& midiGenerator,
+    MidiEventSource& midiSource,
     double sampleRate,
     int blockSize,
     double renderLengthSec,
     double tailSec,
     double warmupSec)
-    : plugin(plugin)
-    , midiGenerator(midiGenerator)
+    : ownedSession(std::make_unique<RenderSession>(plugin))
+    , session(*ownedSession)
+    , plugin(plugin)
+    , midiSource(midiSource)
     , sampleRate(sampleRate)
     , blockSize(blockSize)
     , renderLengthSec(renderLengthSec)
@@ -21,89 +24,172 @@ OfflineRenderer::OfflineRenderer(
 {
 }
 
+OfflineRenderer::OfflineRenderer(
+    RenderSession& session,
+    MidiEventSource& midiSource,
+    double sampleRate,
+    int blockSize,
+    double renderLengthSec,
+    double tailSec,
+    double warmupSec)
+    : session(session)
+    , plugin(session.getPlugin())
+    , midiSource(midiSource)
+    , sampleRate(sampleRate)
+    , blockSize(blockSize)
+    , renderLengthSec(renderLengthSec)
+    , tailSec(tailSec)
+    , warmupSec(warmupSec)
+{
+}
+
+OfflineRenderer::~OfflineRenderer()
+{
+}
+
 bool OfflineRenderer::renderToFile(const juce::File& outputFile, AudioStats& outStats)
 {
-    logInfo("Starting offline render");
-    logInfo("Sample rate: " + juce::String(sampleRate) + " Hz");
-    logInfo("Block size: " + juce::String(blockSize));
-    logInfo("Warmup: " + juce::String(warmupSec) + "s");
-    logInfo("Render: " + juce::String(renderLengthSec) + "s");
-    logInfo("Tail: " + juce::String(tailSec) + "s");
+    WavFileSink sink(outputFile);
+    return render(sink, outStats);
+}
+
+void OfflineRenderer::setAdaptiveTail(float threshold, int blocksToStop)
+{
+    adaptiveTail = blocksToStop > 0;
+    silenceThreshold = threshold;
+    silentBlocksToStop = blocksToStop;
+}
+
+void OfflineRenderer::setWarmupSnapshot(const Hash128& stateKey)
+{
+    useWarmupSnapshot = true;
+    snapshotKey = stateKey;
+}
+
+int64 OfflineRenderer::getTotalSamples() const
+{
+    int64 renderSamples = static_cast<int64>(renderLengthSec * sampleRate);
+    int64 tailSamples = static_cast<int64>(tailSec * sampleRate);
+    int64 renderBlocks = (renderSamples + blockSize - 1) / blockSize;
+    int64 tailBlocks = (tailSamples + blockSize - 1) / blockSize;
+    return (renderBlocks + tailBlocks) * blockSize;
+}
+
+bool OfflineRenderer::render(AudioBlockSink& sink, AudioStats& outStats)
+{
+    SERUM_LOG_DEBUG("Starting offline render");
+    SERUM_LOG_DEBUG("Sample rate: " + juce::String(sampleRate) + " Hz");
+    SERUM_LOG_DEBUG("Block size: " + juce::String(blockSize));
+    SERUM_LOG_DEBUG("Warmup: " + juce::String(warmupSec) + "s");
+    SERUM_LOG_DEBUG("Render: " + juce::String(renderLengthSec) + "s");
+    SERUM_LOG_DEBUG("Tail: " + juce::String(tailSec) + "s");
+    if (splitAtEvents)
+        SERUM_LOG_DEBUG("Splitting blocks at MIDI events");
     
     // Reset statistics
     outStats.reset();
     
-    // Prepare plugin
-    logInfo("Preparing plugin for playback");
-    plugin.prepareToPlay(sampleRate, blockSize);
-    plugin.setNonRealtime(true);
+    // Prepare plugin once; a reused session only needs its voices reset
+    if (session.prepare(sampleRate, blockSize))
+        session.resetForNextRender();
+    
+    // Open output sink
+    int numChannels = session.getNumChannels();
+    bool sinkOpened;
+    {
+        ScopedPhaseTimer timer(RenderPhase::Write);
+        sinkOpened = sink.begin(sampleRate, numChannels, getTotalSamples());
+    }
     
-    // Open WAV writer
-    WavWriter wavWriter;
-    int numChannels = std::max(2, plugin.getTotalNumOutputChannels());
-    if (!wavWriter.open(outputFile, sampleRate, numChannels))
+    if (!sinkOpened)
     {
-        logError("Failed to open WAV writer");
+        logError("Failed to open output sink");
         return false;
     }
     
-    // Allocate single block buffer (constant memory usage)
-    juce::AudioBuffer<float> buffer(numChannels, blockSize);
-    juce::MidiBuffer emptyMidi;
+    // Single block buffer owned by the session (constant memory usage)
+    auto& buffer = session.getBuffer();
+    auto& midi = session.getMidiBuffer();
     
     int64 currentSample = 0;
     
-    // Phase 1: Warmup (discard output)
+    // Phase 1: Warmup (discard output), or restore the state an earlier
+    // warmup of the same preset state reached
     int64 warmupSamples = static_cast<int64>(warmupSec * sampleRate);
     int64 warmupBlocks = (warmupSamples + blockSize - 1) / blockSize;
+    auto warmupStartTicks = juce::Time::getHighResolutionTicks();
     
-    if (warmupBlocks > 0)
+    warmupRestored = useWarmupSnapshot && warmupBlocks > 0
+                  && session.restoreWarmupSnapshot(snapshotKey, warmupSamples);
+    
+    if (warmupRestored)
+    {
+        SERUM_LOG_DEBUG("Warmup restored from snapshot");
+    }
+    else if (warmupBlocks > 0)
     {
-        logInfo("Warmup phase: " + juce::String(warmupBlocks) + " blocks");
+        SERUM_LOG_DEBUG("Warmup phase: " + juce::String(warmupBlocks) + " blocks");
         for (int64 i = 0; i < warmupBlocks; ++i)
         {
             buffer.clear();
-            processBlock(buffer, emptyMidi);
+            midi.clear();
+            processBlock(buffer, midi);
             // Discard output during warmup
         }
+        
+        if (useWarmupSnapshot)
+            session.captureWarmupSnapshot(snapshotKey, warmupSamples);
     }
     
+    warmupSeconds = juce::Time::highResolutionTicksToSeconds(
+        juce::Time::getHighResolutionTicks() - warmupStartTicks);
+    getThreadPhaseTimings().addTime(RenderPhase::Warmup, warmupSeconds);
+    
     // Reset MIDI generator
-    midiGenerator.reset();
+    midiSource.reset();
     currentSample = 0;
     
     // Phase 2: Main render with MIDI
     int64 renderSamples = static_cast<int64>(renderLengthSec * sampleRate);
     int64 renderBlocks = (renderSamples + blockSize - 1) / blockSize;
     
-    logInfo("Main render phase: " + juce::String(renderBlocks) + " blocks");
+    SERUM_LOG_DEBUG("Main render phase: " + juce::String(renderBlocks) + " blocks");
     for (int64 i = 0; i < renderBlocks; ++i)
     {
-        buffer.clear();
-        
-        // Get MIDI events for this block
-        auto midi = midiGenerator.popEvents(currentSample, blockSize);
-        
-        // Process block
-        processBlock(buffer, midi);
+        {
+            ScopedPhaseTimer timer(RenderPhase::MainRender);
+            buffer.clear();
+            
+            // Get MIDI events for this block (no allocation, buffer is pre-reserved)
+            midiSource.popEvents(currentSample, blockSize, midi);
+            
+            // Process block, in sub-blocks starting at each event if requested
+            if (splitAtEvents && !midi.isEmpty())
+                session.processSplitAtEvents(buffer, midi);
+            else
+                processBlock(buffer, midi);
+        }
         
-        // Stream to file
-        if (!wavWriter.writeBlock(buffer))
+        // Stream to sink
+        if (!writeBlock(sink, buffer))
         {
             logError("Failed to write audio block");
-            wavWriter.close();
+            sink.end();
             return false;
         }
         
         // Update statistics online
-        outStats.updateBlock(buffer);
+        {
+            ScopedPhaseTimer timer(RenderPhase::Stats);
+            outStats.updateBlock(buffer);
+        }
         
         currentSample += blockSize;
         
         // Progress logging
         if (i % 100 == 0 && i > 0)
         {
-            logInfo("Rendered " + juce::String(i) + " / " + juce::String(renderBlocks) + " blocks");
+            SERUM_LOG_DEBUG("Rendered " + juce::String(i) + " / " + juce::String(renderBlocks) + " blocks");
         }
     }
     
@@ -111,37 +197,75 @@ bool OfflineRenderer::renderToFile(const juce::File& outputFile, AudioStats& out
     int64 tailSamples = static_cast<int64>(tailSec * sampleRate);
     int64 tailBlocks = (tailSamples + blockSize - 1) / blockSize;
     
+    renderedTailSamples = 0;
+    tailCutShort = false;
+    
     if (tailBlocks > 0)
     {
-        logInfo("Tail phase: " + juce::String(tailBlocks) + " blocks");
+        SERUM_LOG_DEBUG("Tail phase: " + juce::String(tailBlocks) + " blocks");
+        int silentBlocks = 0;
         for (int64 i = 0; i < tailBlocks; ++i)
         {
-            buffer.clear();
-            processBlock(buffer, emptyMidi);
+            {
+                ScopedPhaseTimer timer(RenderPhase::Tail);
+                buffer.clear();
+                midi.clear();
+                processBlock(buffer, midi);
+            }
             
-            if (!wavWriter.writeBlock(buffer))
+            if (!writeBlock(sink, buffer))
             {
                 logError("Failed to write tail block");
-                wavWriter.close();
+                sink.end();
                 return false;
             }
             
-            outStats.updateBlock(buffer);
+            {
+                ScopedPhaseTimer timer(RenderPhase::Stats);
+                outStats.updateBlock(buffer);
+            }
+            renderedTailSamples += blockSize;
+            
+            // Adaptive tail: stop after enough consecutive blocks below threshold
+            if (adaptiveTail)
+            {
+                silentBlocks = outStats.blockPeak < silenceThreshold ? silentBlocks + 1 : 0;
+                if (silentBlocks >= silentBlocksToStop && i + 1 < tailBlocks)
+                {
+                    tailCutShort = true;
+                    SERUM_LOG_DEBUG("Tail silent after " + juce::String(getRenderedTailSec(), 3) + "s, stopping early");
+                    break;
+                }
+            }
         }
     }
     
     // Finalize statistics
-    outStats.finalize();
+    {
+        ScopedPhaseTimer timer(RenderPhase::Stats);
+        outStats.finalize();
+    }
     
-    // Close WAV file
-    wavWriter.close();
+    // Close output
+    bool sinkClosed;
+    {
+        ScopedPhaseTimer timer(RenderPhase::Close);
+        sinkClosed = sink.end();
+    }
     
-    logInfo("Render complete!");
-    logInfo("Peak L/R: " + juce::String(outStats.peakL, 3) + " / " + juce::String(outStats.peakR, 3));
-    logInfo("RMS L/R: " + juce::String(outStats.rmsL, 3) + " / " + juce::String(outStats.rmsR, 3));
+    if (!sinkClosed)
+    {
+        logError("Failed to finalize output sink");
+        return false;
+    }
     
-    // Release plugin
-    plugin.releaseResources();
+    SERUM_LOG_DEBUG("Render complete!");
+    SERUM_LOG_DEBUG("Peak L/R: " + juce::String(outStats.peakL, 3) + " / " + juce::String(outStats.peakR, 3));
+    SERUM_LOG_DEBUG("RMS L/R: " + juce::String(outStats.rmsL, 3) + " / " + juce::String(outStats.rmsR, 3));
+    
+    // Release plugin unless the session outlives this render
+    if (ownedSession != nullptr)
+        ownedSession->release();
     
     return true;
 }
@@ -151,4 +275,10 @@ void OfflineRenderer::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiB
     plugin.processBlock(buffer, midi);
 }
 
+bool OfflineRenderer::writeBlock(AudioBlockSink& sink, const juce::AudioBuffer<float>& buffer)
+{
+    ScopedPhaseTimer timer(RenderPhase::Write);
+    return sink.writeBlock(buffer);
+}
+
 } // namespace serum
@@ -1,15 +1,20 @@
 #pragma once
 
 #include <JuceHeader.h>
-#include "midi/SyntheticMidiGenerator.h"
-#include "render/WavWriter.h"
+#include "midi/MidiEventSource.h"
+#include "render/AudioBlockSink.h"
 #include "render/AudioStats.h"
+#include "render/RenderSession.h"
+#include <memory>
 
 namespace serum {
 
 /**
  * Streaming offline renderer
- * Renders audio block-by-block directly to disk with constant memory usage
+ * Renders audio block-by-block into a sink (disk, memory) with constant memory usage
+ *
+ * Constructed from a plugin, every render prepares and releases it. Constructed
+ * from a RenderSession, the plugin stays prepared and is only reset between renders.
  */
 class OfflineRenderer
 {
@@ -17,7 +22,7 @@ public:
     /**
      * Constructor
      * @param plugin Plugin instance to render
-     * @param midiGenerator MIDI source (SyntheticMidiGenerator)
+     * @param midiSource MIDI source (SyntheticMidiGenerator, MidiTimeline)
      * @param sampleRate Sample rate
      * @param blockSize Block size
      * @param renderLengthSec Main render length in seconds
@@ -26,7 +31,7 @@ public:
      */
     OfflineRenderer(
         juce::AudioPluginInstance& plugin,
-        SyntheticMidiGenerator& midiGenerator,
+        MidiEventSource& midiSource,
         double sampleRate,
         int blockSize,
         double renderLengthSec,
@@ -34,6 +39,28 @@ public:
         double warmupSec
     );
     
+    /**
+     * Constructor reusing a persistent session
+     * @param session Render session, prepared on first use and kept prepared
+     * @param midiSource MIDI source (SyntheticMidiGenerator, MidiTimeline)
+     * @param sampleRate Sample rate
+     * @param blockSize Block size
+     * @param renderLengthSec Main render length in seconds
+     * @param tailSec Tail length in seconds (for reverb/delay)
+     * @param warmupSec Warmup length in seconds (to stabilize synth)
+     */
+    OfflineRenderer(
+        RenderSession& session,
+        MidiEventSource& midiSource,
+        double sampleRate,
+        int blockSize,
+        double renderLengthSec,
+        double tailSec,
+        double warmupSec
+    );
+    
+    ~OfflineRenderer();
+    
     /**
      * Render to file with streaming
      * @param outputFile Output WAV file
@@ -42,16 +69,88 @@ public:
      */
     bool renderToFile(const juce::File& outputFile, AudioStats& outStats);
     
+    /**
+     * Render into an arbitrary sink (file, memory, null)
+     * @param sink Destination for the main and tail blocks
+     * @param outStats Output statistics
+     * @return true if successful
+     */
+    bool render(AudioBlockSink& sink, AudioStats& outStats);
+    
+    /**
+     * Number of samples per channel render() will write (main + tail, block aligned)
+     * Use to size storage for a MemorySink
+     */
+    int64 getTotalSamples() const;
+    
+    /**
+     * Stop the tail phase early once the patch has decayed to silence
+     * tailSec stays the upper bound
+     * @param silenceThreshold Linear peak below which a block counts as silent
+     * @param silentBlocksToStop Consecutive silent blocks that end the tail
+     */
+    void setAdaptiveTail(float silenceThreshold, int silentBlocksToStop);
+    
+    /**
+     * Split main-phase blocks at MIDI events (see RenderSession::processSplitAtEvents)
+     * Lets plugins that quantize events to block starts use large blocks
+     */
+    void setSplitAtEvents(bool shouldSplit) { splitAtEvents = shouldSplit; }
+    
+    /**
+     * Reuse the state reached after warmup across renders of one preset state
+     * The first render with a key warms up and captures a snapshot in the
+     * session; later renders with the same key restore it instead. Needs the
+     * session constructor, a per-render session is released after each render.
+     * @param stateKey Identifies the preset state applied before the render
+     */
+    void setWarmupSnapshot(const Hash128& stateKey);
+    
+    /**
+     * True if the last render restored a snapshot instead of warming up
+     */
+    bool wasWarmupRestored() const { return warmupRestored; }
+    
+    /**
+     * Time the last render spent warming up or restoring the snapshot
+     */
+    double getWarmupSeconds() const { return warmupSeconds; }
+    
+    /**
+     * Tail length actually rendered by the last render, in seconds
+     */
+    double getRenderedTailSec() const { return static_cast<double>(renderedTailSamples) / sampleRate; }
+    
+    /**
+     * True if the last render's tail was cut short by the silence detector
+     */
+    bool wasTailCutShort() const { return tailCutShort; }
+    
 private:
+    std::unique_ptr<RenderSession> ownedSession;  // Only set for the per-render constructor
+    RenderSession& session;
     juce::AudioPluginInstance& plugin;
-    SyntheticMidiGenerator& midiGenerator;
+    MidiEventSource& midiSource;
     double sampleRate;
     int blockSize;
     double renderLengthSec;
     double tailSec;
     double warmupSec;
     
+    bool adaptiveTail = false;
+    float silenceThreshold = 0.0f;
+    int silentBlocksToStop = 0;
+    int64 renderedTailSamples = 0;
+    bool tailCutShort = false;
+    bool splitAtEvents = false;
+    
+    bool useWarmupSnapshot = false;
+    Hash128 snapshotKey;
+    bool warmupRestored = false;
+    double warmupSeconds = 0.0;
+    
     void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi);
+    bool writeBlock(AudioBlockSink& sink, const juce::AudioBuffer<float>& buffer);
 };
 
 } // namespace serum
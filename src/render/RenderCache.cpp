@@ -0,0 +1,169 @@
+#include "render/RenderCache.h"
+#include "render/RenderMetadata.h"
+#include "common/Hash.h"
+#include "common/Log.h"
+#include "common/Paths.h"
+
+namespace serum {
+
+RenderCache::RenderCache(const juce::File& directory, const juce::PluginDescription& plugin)
+    : directory(directory)
+{
+    pluginIdentity = plugin.pluginFormatName + "|" + plugin.fileOrIdentifier + "|"
+                   + plugin.manufacturerName + "|" + plugin.name + "|" + plugin.version + "|"
+                   + juce::String::toHexString(plugin.uniqueId);
+}
+
+juce::File RenderCache::getDefaultDirectory()
+{
+    return getOutputMetaDir().getChildFile("cache");
+}
+
+juce::String RenderCache::getPresetHash(const juce::File& presetStateFile)
+{
+    auto modificationTime = presetStateFile.getLastModificationTime();
+    auto size = presetStateFile.getSize();
+    auto path = presetStateFile.getFullPathName();
+
+    {
+        std::lock_guard<std::mutex> lock(presetHashMutex);
+        auto it = presetHashes.find(path);
+        if (it != presetHashes.end() && it->second.modificationTime == modificationTime
+            && it->second.size == size)
+            return it->second.hash;
+    }
+
+    // Hash outside the lock; a duplicate computation is harmless
+    Hash128 stateHash;
+    if (!computeFastHash128FromFile(presetStateFile, stateHash))
+        return {};
+
+    PresetHash hash;
+    hash.modificationTime = modificationTime;
+    hash.size = size;
+    hash.hash = stateHash.toHexString();
+
+    std::lock_guard<std::mutex> lock(presetHashMutex);
+    presetHashes[path] = hash;
+    return hash.hash;
+}
+
+juce::String RenderCache::computeKey(const RenderJob& job, const juce::String& pluginStateHash)
+{
+    // A default-state job renders with whatever state is on the plugin
+    auto presetHash = job.presetStateFile == juce::File() ? pluginStateHash
+                                                          : getPresetHash(job.presetStateFile);
+    if (presetHash.isEmpty())
+        return {};
+
+    const auto& settings = job.settings;
+
+    // Every field that changes the rendered file, in a fixed order
+    juce::String description;
+    description << "serum-render-cache-v4\n"
+                << pluginIdentity << "\n"
+                << presetHash << "\n"
+                << job.noteName << "|" << job.velocity << "\n"
+                << settings.sampleRate << "|" << settings.blockSize << "|" << (settings.splitAtEvents ? 1 : 0) << "\n"
+                << settings.warmupSec << "|" << static_cast<int>(settings.warmupMode) << "|"
+                << settings.renderSec << "|" << settings.tailSec << "\n"
+                << (settings.adaptiveTail ? 1 : 0) << "|" << settings.silenceThresholdDb
+                << "|" << settings.silentBlocks << "\n"
+                << static_cast<int>(settings.channelLayout) << "|"
+                << getSampleFormatName(settings.sampleFormat) << "\n"
+                << settings.midiPattern.describe();
+
+    auto utf8 = description.toUTF8();
+    return computeFastHash128(utf8.getAddress(), utf8.sizeInBytes() - 1).toHexString();
+}
+
+juce::File RenderCache::getEntryFile(const juce::String& key) const
+{
+    return directory.getChildFile(key.substring(0, 2)).getChildFile(key + ".json");
+}
+
+bool RenderCache::lookup(const juce::String& key, const juce::File& outputFile)
+{
+    auto entryFile = getEntryFile(key);
+    if (!entryFile.existsAsFile())
+        return false;
+
+    auto entry = juce::JSON::parse(entryFile);
+    juce::File cachedFile(entry["output"].toString());
+    auto expectedSize = static_cast<int64>(entry["bytes"]);
+    auto expectedHash = entry["hash"].toString();
+    auto headerSize = static_cast<int64>(entry["headerBytes"]);
+
+    Hash128 outputHash;
+    if (!juce::File::isAbsolutePath(cachedFile.getFullPathName()) || !cachedFile.existsAsFile()
+        || cachedFile.getSize() != expectedSize
+        || !computeFastHash128FromFile(cachedFile, headerSize, outputHash)
+        || outputHash.toHexString() != expectedHash)
+        return false;
+
+    if (cachedFile == outputFile)
+        return true;
+
+    // Same render under another name: copy rather than render again
+    ensureDirectoryExists(outputFile.getParentDirectory());
+    if (!cachedFile.copyFileTo(outputFile))
+    {
+        logError("Failed to copy cached render to " + outputFile.getFullPathName());
+        return false;
+    }
+
+    // The metadata travels with it, pointing at the new output
+    auto metadata = juce::JSON::parse(RenderMetadata::getFileFor(cachedFile));
+    if (auto* object = metadata.getDynamicObject())
+    {
+        object->setProperty("output", outputFile.getFullPathName());
+
+        auto outputMeta = RenderMetadata::getFileFor(outputFile);
+        ensureDirectoryExists(outputMeta.getParentDirectory());
+        outputMeta.replaceWithText(juce::JSON::toString(metadata));
+    }
+
+    return true;
+}
+
+bool RenderCache::store(const juce::String& key, const juce::File& outputFile,
+                        const Hash128* writtenHash, int64 headerSize)
+{
+    // Hashing the output again is the fallback; writers hash as they stream
+    Hash128 outputHash;
+    if (writtenHash != nullptr)
+    {
+        outputHash = *writtenHash;
+    }
+    else
+    {
+        headerSize = 0;
+        if (!computeFastHash128FromFile(outputFile, outputHash))
+        {
+            logError("Cannot cache missing output: " + outputFile.getFullPathName());
+            return false;
+        }
+    }
+
+    auto* object = new juce::DynamicObject();
+    juce::var entry(object);
+    object->setProperty("output", outputFile.getFullPathName());
+    object->setProperty("bytes", outputFile.getSize());
+    object->setProperty("hash", outputHash.toHexString());
+    object->setProperty("headerBytes", headerSize);
+
+    auto entryFile = getEntryFile(key);
+    ensureDirectoryExists(entryFile.getParentDirectory());
+
+    // replaceWithText() writes a temporary file and renames it, so readers
+    // never see a partial entry
+    if (!entryFile.replaceWithText(juce::JSON::toString(entry)))
+    {
+        logError("Failed to write cache entry: " + entryFile.getFullPathName());
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace serum
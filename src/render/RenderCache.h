@@ -0,0 +1,86 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "common/Hash.h"
+#include "render/RenderJob.h"
+#include <map>
+#include <mutex>
+
+namespace serum {
+
+/**
+ * Content-addressed cache of finished renders
+ *
+ * A render's key is a 128-bit hash (FastHasher128) of everything that
+ * determines its audio: the preset state bytes, the plugin identity and
+ * version, note, velocity and the render settings, including the warmup
+ * mode. The output path is not part of the key, so the same render
+ * requested under another name is copied instead of rendered again.
+ *
+ * Entries live in <directory>/<first two key digits>/<key>.json and record
+ * the output path, size and hash. The hash is the one computed while the
+ * output was written, so storing never reads the file back. A hit is only
+ * reported once the output on disk matches both; files are hashed
+ * memory-mapped. Safe to share between worker threads.
+ */
+class RenderCache
+{
+public:
+    /**
+     * Constructor
+     * @param directory Cache directory (see getDefaultDirectory())
+     * @param plugin Plugin the renders come from
+     */
+    RenderCache(const juce::File& directory, const juce::PluginDescription& plugin);
+
+    /**
+     * Compute the cache key of a job
+     * @param pluginStateHash For a job without a preset state file: hash of the
+     *                        state the plugin will render with (required)
+     * @return 32 hex digits, empty if the preset state cannot be read or is unknown
+     */
+    juce::String computeKey(const RenderJob& job, const juce::String& pluginStateHash = {});
+
+    /**
+     * Check for a verified render of key and make it available at outputFile
+     * A render cached under another path is copied, with its metadata
+     * @return true if outputFile now holds the cached render
+     */
+    bool lookup(const juce::String& key, const juce::File& outputFile);
+
+    /**
+     * Record a finished render
+     * @param key Key from computeKey()
+     * @param outputFile Complete output file on disk
+     * @param writtenHash Hash computed while the file was written (see
+     *                    WavWriter::getFileHash()); without it the file is hashed
+     * @param headerSize Header size that goes with writtenHash
+     * @return true if the entry was written
+     */
+    bool store(const juce::String& key, const juce::File& outputFile,
+               const Hash128* writtenHash = nullptr, int64 headerSize = 0);
+
+    /**
+     * data/outmeta/cache/
+     */
+    static juce::File getDefaultDirectory();
+
+private:
+    struct PresetHash
+    {
+        juce::Time modificationTime;
+        int64 size = 0;
+        juce::String hash;
+    };
+
+    juce::File directory;
+    juce::String pluginIdentity;
+
+    std::mutex presetHashMutex;
+    std::map<juce::String, PresetHash> presetHashes;  // By full path
+
+    juce::String getPresetHash(const juce::File& presetStateFile);
+    juce::File getEntryFile(const juce::String& key) const;
+};
+
+} // namespace serum
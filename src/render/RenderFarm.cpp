@@ -0,0 +1,851 @@
+#include "render/RenderFarm.h"
+#include "render/OfflineRenderer.h"
+#include "render/LockstepRenderer.h"
+#include "render/RenderMetadata.h"
+#include "midi/SyntheticMidiGenerator.h"
+#include "vst/PluginInstancePool.h"
+#include "vst/PresetStateIO.h"
+#include "common/Log.h"
+#include "common/Paths.h"
+
+namespace serum {
+
+// Async renders awaiting their write before the worker drains its writer
+static constexpr size_t maxPendingWrites = 256;
+
+static void configureRenderer(OfflineRenderer& renderer, const RenderSettings& settings)
+{
+    renderer.setSplitAtEvents(settings.splitAtEvents);
+    if (settings.adaptiveTail)
+        renderer.setAdaptiveTail(juce::Decibels::decibelsToGain(settings.silenceThresholdDb),
+                                 settings.silentBlocks);
+}
+
+/**
+ * Cache key of a job; a job without a preset state renders with whatever
+ * state the instance holds, so that state's hash stands in for the preset
+ */
+static juce::String computeCacheKey(RenderCache& cache, const RenderJob& job,
+                                    juce::AudioPluginInstance& plugin, const PresetStateBlob* appliedState)
+{
+    if (job.presetStateFile != juce::File())
+        return cache.computeKey(job);
+
+    if (appliedState != nullptr)
+        return cache.computeKey(job, appliedState->hash.toHexString());
+
+    // Nothing applied yet: the plugin's initial state
+    juce::MemoryBlock state;
+    plugin.getStateInformation(state);
+    return cache.computeKey(job, computeFastHash128(state.getData(), state.getSize()).toHexString());
+}
+
+RenderFarm::RenderFarm(
+    PluginFactory& factory,
+    const juce::PluginDescription& desc,
+    const RenderFarmOptions& options)
+    : factory(factory)
+    , desc(desc)
+    , options(options)
+{
+    if (options.cacheDirectory != juce::File())
+        cache = std::make_unique<RenderCache>(options.cacheDirectory, desc);
+}
+
+RenderFarm::~RenderFarm()
+{
+    for (auto& worker : workers)
+    {
+        if (worker->thread.joinable())
+            worker->thread.join();
+    }
+}
+
+bool RenderFarm::createWorkers(juce::String& errorMsg, const RenderSettings& settings)
+{
+    int numWorkers = juce::jmax(1, options.numWorkers);
+    const int instancesPerWorker = juce::jmax(1, options.lockstepViews);
+    logInfo("Creating " + juce::String(numWorkers * instancesPerWorker) + " worker plugin instances");
+
+    // Jobs override their block size the same way in pullFromSource()
+    PluginInstancePool pool(factory, desc, settings.sampleRate,
+                            options.blockSize > 0 ? options.blockSize : settings.blockSize);
+
+    std::vector<std::unique_ptr<juce::AudioPluginInstance>> instances;
+    if (!pool.createInstances(numWorkers * instancesPerWorker - 1, instances, errorMsg))
+        return false;
+
+    instances.push_back(pool.takeResidentInstance());
+
+    auto adopt = [&pool](std::unique_ptr<juce::AudioPluginInstance>& plugin)
+    {
+        auto session = std::make_unique<RenderSession>(*plugin);
+        session->adoptPrepared(pool.getSampleRate(), pool.getBlockSize());
+        return session;
+    };
+
+    workers.clear();
+    size_t nextInstance = 0;
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto worker = std::make_unique<Worker>();
+        worker->plugin = std::move(instances[nextInstance++]);
+        worker->session = adopt(worker->plugin);
+
+        for (int lane = 1; lane < instancesPerWorker; ++lane)
+        {
+            auto extra = std::make_unique<LockstepLane>();
+            extra->plugin = std::move(instances[nextInstance++]);
+            extra->session = adopt(extra->plugin);
+            worker->lockstepLanes.push_back(std::move(extra));
+        }
+
+        if (options.shmRingName.isNotEmpty())
+        {
+            worker->shmRing = ShmAudioRing::open(options.shmRingName, errorMsg);
+            if (worker->shmRing == nullptr)
+            {
+                errorMsg = "Worker " + juce::String(i) + ": " + errorMsg;
+                logError(errorMsg);
+                workers.clear();
+                return false;
+            }
+        }
+
+        if (options.shardDirectory != juce::File())
+            worker->shardWriter = std::make_unique<ShardWriter>(
+                options.shardDirectory, "w" + juce::String(i).paddedLeft('0', 2), options.maxShardBytes);
+
+        workers.push_back(std::move(worker));
+    }
+
+    return true;
+}
+
+bool RenderFarm::run(RenderJobSource& jobSource, RenderFarmSummary& outSummary)
+{
+    outSummary = RenderFarmSummary();
+
+    if (workers.empty())
+    {
+        logError("Render farm has no workers");
+        return false;
+    }
+
+    source = &jobSource;
+    sourceExhausted = false;
+    hasLookahead = false;
+    jobsFinished = 0;
+    activeWorkers = getNumWorkers();
+
+    logInfo("Starting render farm with " + juce::String(getNumWorkers()) + " workers");
+    auto startTicks = juce::Time::getHighResolutionTicks();
+
+    for (int i = 0; i < getNumWorkers(); ++i)
+    {
+        auto& worker = *workers[static_cast<size_t>(i)];
+        worker.completed = worker.failed = worker.stolen = worker.cached = worker.stateLoads = 0;
+        worker.warmupsRun = worker.warmupsRestored = worker.snapshotMismatches = 0;
+        worker.warmupSeconds = worker.restoreSeconds = 0.0;
+        worker.lockstepGroups = worker.lockstepViews = 0;
+        worker.timings.reset();
+        worker.thread = std::thread([this, i] { workerLoop(i); });
+    }
+
+    // Keep the message thread responsive while waiting: some plugins marshal
+    // state changes onto it from the worker threads
+    int64 lastReported = 0;
+    auto lastReportTicks = startTicks;
+    while (activeWorkers.load() > 0)
+    {
+#if JUCE_MODAL_LOOPS_PERMITTED
+        juce::MessageManager::getInstance()->runDispatchLoopUntil(20);
+#else
+        juce::Thread::sleep(20);
+#endif
+        auto now = juce::Time::getHighResolutionTicks();
+        if (juce::Time::highResolutionTicksToSeconds(now - lastReportTicks) >= 5.0)
+        {
+            int64 finished = jobsFinished.load();
+            if (finished != lastReported)
+                logInfo("Render farm progress: " + juce::String(finished) + " jobs finished");
+
+            lastReported = finished;
+            lastReportTicks = now;
+        }
+    }
+
+    for (auto& worker : workers)
+    {
+        if (worker->thread.joinable())
+            worker->thread.join();
+
+        outSummary.jobsCompleted += worker->completed;
+        outSummary.jobsFailed += worker->failed;
+        outSummary.jobsStolen += worker->stolen;
+        outSummary.jobsCached += worker->cached;
+        outSummary.stateLoads += worker->stateLoads;
+        outSummary.warmupsRun += worker->warmupsRun;
+        outSummary.warmupsRestored += worker->warmupsRestored;
+        outSummary.warmupSeconds += worker->warmupSeconds;
+        outSummary.restoreSeconds += worker->restoreSeconds;
+        outSummary.snapshotMismatches += worker->snapshotMismatches;
+        outSummary.lockstepGroups += worker->lockstepGroups;
+        outSummary.lockstepViews += worker->lockstepViews;
+        outSummary.timings.merge(worker->timings);
+    }
+
+    outSummary.wallSeconds = juce::Time::highResolutionTicksToSeconds(
+        juce::Time::getHighResolutionTicks() - startTicks);
+    source = nullptr;
+
+    double rendersPerSec = outSummary.wallSeconds > 0.0
+        ? static_cast<double>(outSummary.jobsCompleted) / outSummary.wallSeconds
+        : 0.0;
+
+    logInfo("Render farm finished: " + juce::String(outSummary.jobsCompleted) + " completed, "
+            + juce::String(outSummary.jobsFailed) + " failed, "
+            + juce::String(outSummary.jobsStolen) + " stolen, "
+            + juce::String(outSummary.jobsCached) + " from cache, "
+            + juce::String(outSummary.stateLoads) + " preset state loads");
+    logInfo("Wall time: " + juce::String(outSummary.wallSeconds, 2) + "s ("
+            + juce::String(rendersPerSec, 2) + " renders/s)");
+
+    if (outSummary.warmupsRestored > 0)
+    {
+        // Savings estimated from the average cost of the full warmups
+        double averageWarmup = outSummary.warmupsRun > 0
+            ? outSummary.warmupSeconds / static_cast<double>(outSummary.warmupsRun)
+            : 0.0;
+        double saved = averageWarmup * static_cast<double>(outSummary.warmupsRestored) - outSummary.restoreSeconds;
+
+        logInfo("Warmup: " + juce::String(outSummary.warmupsRun) + " run ("
+                + juce::String(outSummary.warmupSeconds, 2) + "s), "
+                + juce::String(outSummary.warmupsRestored) + " restored from snapshot ("
+                + juce::String(outSummary.restoreSeconds, 2) + "s), ~"
+                + juce::String(saved, 2) + "s worker time saved");
+    }
+
+    outSummary.timings.logSummary();
+    if (options.timingReportFile != juce::File() && outSummary.timings.getNumRenders() > 0)
+        outSummary.timings.writeToFile(options.timingReportFile);
+
+    if (outSummary.lockstepGroups > 0)
+    {
+        logInfo("Lockstep: " + juce::String(outSummary.lockstepViews) + " views in "
+                + juce::String(outSummary.lockstepGroups) + " passes ("
+                + juce::String(static_cast<double>(outSummary.lockstepViews)
+                               / static_cast<double>(outSummary.lockstepGroups), 2) + " views/pass)");
+    }
+
+    if (outSummary.snapshotMismatches > 0)
+        logError(juce::String(outSummary.snapshotMismatches) + " snapshot renders differ from a fresh warmup");
+
+    return outSummary.jobsFailed == 0;
+}
+
+void RenderFarm::workerLoop(int index)
+{
+    auto& worker = *workers[static_cast<size_t>(index)];
+
+    if (options.pinThreads)
+        juce::Thread::setCurrentThreadAffinityMask(1u << (index % 32));
+
+    RenderJob job;
+    std::vector<RenderJob> group;
+    group.reserve(worker.lockstepLanes.size() + 1);
+
+    while (takeJob(index, job))
+    {
+        if (canRenderLockstep(worker, job))
+        {
+            group.clear();
+            group.push_back(std::move(job));
+            takeLockstepGroup(worker, group);
+
+            if (group.size() > 1)
+            {
+                renderLockstep(worker, group);
+                continue;
+            }
+
+            job = std::move(group.front());
+        }
+
+        const bool ok = renderJob(worker, job);
+        if (ok && worker.jobAwaitingWrite)
+            worker.jobAwaitingWrite = false;
+        else
+            finishJob(worker, job, ok);
+    }
+
+    if (worker.asyncWriter != nullptr)
+        flushAsyncWrites(worker);
+
+    if (worker.shardWriter != nullptr)
+        worker.shardWriter->close();
+
+    // Release on the thread that rendered
+    worker.session->release();
+    for (auto& lane : worker.lockstepLanes)
+        lane->session->release();
+    --activeWorkers;
+}
+
+void RenderFarm::finishJob(Worker& worker, const RenderJob& job, bool ok)
+{
+    if (ok)
+        ++worker.completed;
+    else
+        ++worker.failed;
+
+    ++jobsFinished;
+
+    if (options.onJobFinished)
+        options.onJobFinished(job, ok);
+}
+
+void RenderFarm::recordWarmup(Worker& worker, const OfflineRenderer& renderer, const RenderSettings& settings)
+{
+    if (renderer.wasWarmupRestored())
+    {
+        ++worker.warmupsRestored;
+        worker.restoreSeconds += renderer.getWarmupSeconds();
+    }
+    else if (settings.warmupSec > 0.0)
+    {
+        ++worker.warmupsRun;
+        worker.warmupSeconds += renderer.getWarmupSeconds();
+    }
+}
+
+bool RenderFarm::renderSnapshotReference(Worker& worker, const RenderJob& job, MidiEventSource& midiSource)
+{
+    const auto& settings = job.settings;
+    auto& plugin = worker.session->getPlugin();
+
+    OfflineRenderer renderer(
+        *worker.session,
+        midiSource,
+        settings.sampleRate,
+        settings.blockSize,
+        settings.renderSec,
+        settings.tailSec,
+        settings.warmupSec
+    );
+
+    configureRenderer(renderer, settings);
+    renderer.setWarmupSnapshot(worker.appliedState != nullptr ? worker.appliedState->hash : Hash128());
+
+    // Reused across verify jobs, only grows
+    worker.verifyBuffer.setSize(juce::jmax(1, plugin.getTotalNumInputChannels(), plugin.getTotalNumOutputChannels()),
+                                static_cast<int>(renderer.getTotalSamples()), false, false, true);
+
+    MemorySink sink(worker.verifyBuffer);
+    AudioStats stats;
+    if (!renderer.render(sink, stats))
+    {
+        logError("Snapshot reference render failed: " + job.outputFile.getFullPathName());
+        return false;
+    }
+
+    worker.verifySamples = sink.getNumSamplesWritten();
+
+    recordWarmup(worker, renderer, settings);
+
+    // The fresh render starts from the preset state, not from the snapshot
+    if (worker.appliedState != nullptr
+        && !PresetStateIO::applyState(plugin, worker.appliedState->data, worker.appliedState->size))
+        return false;
+
+    return true;
+}
+
+void RenderFarm::flushAsyncWrites(Worker& worker)
+{
+    // Async jobs only count as completed or failed once their file has settled
+    juce::Array<juce::File> failedFiles;
+    juce::Array<AsyncWavWriter::WrittenFile> writtenFiles;
+    worker.asyncWriter->waitUntilIdle(&failedFiles, &writtenFiles);
+
+    for (const auto& [job, cacheKey] : worker.pendingWrites)
+    {
+        const bool ok = !failedFiles.contains(job.outputFile);
+        if (!ok)
+        {
+            logError("Failed to write " + job.outputFile.getFullPathName());
+            RenderMetadata::getFileFor(job.outputFile).deleteFile();
+        }
+        else if (cache != nullptr && cacheKey.isNotEmpty())
+        {
+            const AsyncWavWriter::WrittenFile* written = nullptr;
+            for (const auto& candidate : writtenFiles)
+                if (candidate.file == job.outputFile)
+                    written = &candidate;
+
+            cache->store(cacheKey, job.outputFile, written != nullptr ? &written->hash : nullptr,
+                         written != nullptr ? written->headerSize : 0);
+        }
+
+        finishJob(worker, job, ok);
+    }
+
+    worker.pendingWrites.clear();
+}
+
+bool RenderFarm::takeJob(int index, RenderJob& job)
+{
+    auto& worker = *workers[static_cast<size_t>(index)];
+
+    // 1. Own queue first
+    {
+        std::lock_guard<std::mutex> lock(worker.queueMutex);
+        if (!worker.queue.empty())
+        {
+            job = std::move(worker.queue.front());
+            worker.queue.pop_front();
+            return true;
+        }
+    }
+
+    // 2. Pull a fresh batch from the source so neighbouring jobs stay together
+    if (refillFromSource(worker, job))
+        return true;
+
+    // 3. Source is dry, steal from the other workers
+    return stealJob(index, job);
+}
+
+bool RenderFarm::pullFromSource(RenderJob& job)
+{
+    if (hasLookahead)
+    {
+        job = std::move(lookahead);
+        hasLookahead = false;
+        return true;
+    }
+
+    if (sourceExhausted || !source->next(job))
+    {
+        sourceExhausted = true;
+        return false;
+    }
+
+    // Before the job is keyed, grouped or cached
+    if (options.blockSize > 0)
+        job.settings.blockSize = options.blockSize;
+
+    return true;
+}
+
+bool RenderFarm::refillFromSource(Worker& worker, RenderJob& job)
+{
+    std::lock_guard<std::mutex> sourceLock(sourceMutex);
+
+    if (!pullFromSource(job))
+        return false;
+
+    // Queue the rest of the batch while still holding the source lock, so a
+    // worker that sees the source exhausted can always steal these jobs.
+    // Past the batch size, keep going while the jobs share the last preset,
+    // so its state is applied once for all of its views.
+    std::lock_guard<std::mutex> queueLock(worker.queueMutex);
+    auto preset = job.presetStateFile;
+    int maxBatch = juce::jmax(options.refillBatchSize, options.maxPresetBatch);
+
+    for (int i = 1; i < maxBatch; ++i)
+    {
+        RenderJob extra;
+        if (!pullFromSource(extra))
+            break;
+
+        if (i >= options.refillBatchSize && extra.presetStateFile != preset)
+        {
+            lookahead = std::move(extra);
+            hasLookahead = true;
+            break;
+        }
+
+        preset = extra.presetStateFile;
+        worker.queue.push_back(std::move(extra));
+    }
+
+    return true;
+}
+
+bool RenderFarm::stealJob(int thiefIndex, RenderJob& job)
+{
+    int numWorkers = getNumWorkers();
+
+    for (int k = 1; k < numWorkers; ++k)
+    {
+        auto& victim = *workers[static_cast<size_t>((thiefIndex + k) % numWorkers)];
+
+        std::lock_guard<std::mutex> lock(victim.queueMutex);
+        if (!victim.queue.empty())
+        {
+            // Steal from the back, the victim keeps working from the front
+            job = std::move(victim.queue.back());
+            victim.queue.pop_back();
+            ++workers[static_cast<size_t>(thiefIndex)]->stolen;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool RenderFarm::renderJob(Worker& worker, const RenderJob& job)
+{
+    auto& plugin = worker.session->getPlugin();
+    const auto& settings = job.settings;
+
+    // Everything timed on this thread from here on belongs to this job
+    auto& timings = getThreadPhaseTimings();
+    timings.reset();
+
+    juce::String cacheKey;
+    if (cache != nullptr && worker.shardWriter == nullptr && worker.shmRing == nullptr)
+    {
+        cacheKey = computeCacheKey(*cache, job, plugin, worker.appliedState);
+        if (cacheKey.isNotEmpty() && cache->lookup(cacheKey, job.outputFile))
+        {
+            ++worker.cached;
+            return true;
+        }
+    }
+
+    if (!applyPresetState(worker, plugin, worker.appliedState, worker.stateDirty, job.presetStateFile,
+                          settings.midiPattern))
+        return false;
+
+    juce::String midiError;
+    if (!settings.midiPattern.build(worker.midiTimeline, job.noteName, job.velocity,
+                                    settings.renderSec, settings.sampleRate, midiError))
+    {
+        logError("Failed to build MIDI for " + job.outputFile.getFullPathName() + ": " + midiError);
+        return false;
+    }
+
+    OfflineRenderer renderer(
+        *worker.session,
+        worker.midiTimeline,
+        settings.sampleRate,
+        settings.blockSize,
+        settings.renderSec,
+        settings.tailSec,
+        settings.warmupSec
+    );
+
+    configureRenderer(renderer, settings);
+
+    // The state actually on the plugin (a default-state job keeps the last one)
+    auto stateHash = worker.appliedState != nullptr ? worker.appliedState->hash : Hash128();
+
+    const bool verifySnapshot = settings.warmupMode == WarmupMode::Verify;
+    if (settings.warmupMode == WarmupMode::Snapshot)
+        renderer.setWarmupSnapshot(stateHash);
+    else if (verifySnapshot && !renderSnapshotReference(worker, job, worker.midiTimeline))
+        return false;
+
+    std::unique_ptr<AudioBlockSink> sink;
+    const WavFileSink* fileSink = nullptr;  // Set when writing synchronously to a file
+    if (worker.shardWriter != nullptr || worker.shmRing != nullptr)
+    {
+        // Same byte order as Hash128::toHexString()
+        for (int i = 0; i < 8; ++i)
+        {
+            worker.shardKey.presetHash[i] = static_cast<uint8>(stateHash.low >> (i * 8));
+            worker.shardKey.presetHash[i + 8] = static_cast<uint8>(stateHash.high >> (i * 8));
+        }
+
+        worker.shardKey.note = SyntheticMidiGenerator::noteNameToMidiNumber(job.noteName);
+        worker.shardKey.velocity = job.velocity;
+        if (worker.shmRing != nullptr)
+            sink = std::make_unique<ShmSink>(*worker.shmRing, ++worker.shmRenderId, worker.shardKey,
+                                             settings.channelLayout);
+        else
+            sink = std::make_unique<ShardSink>(*worker.shardWriter, worker.shardKey, settings.channelLayout);
+    }
+    else if (settings.asyncWrite)
+    {
+        ensureDirectoryExists(job.outputFile.getParentDirectory());
+
+        if (worker.asyncWriter == nullptr)
+            worker.asyncWriter = std::make_unique<AsyncWavWriter>(
+                juce::jmax(2, plugin.getTotalNumInputChannels(), plugin.getTotalNumOutputChannels()));
+
+        sink = std::make_unique<AsyncWavFileSink>(*worker.asyncWriter, job.outputFile,
+                                                  settings.channelLayout, settings.sampleFormat);
+    }
+    else
+    {
+        ensureDirectoryExists(job.outputFile.getParentDirectory());
+        auto wavSink = std::make_unique<WavFileSink>(job.outputFile, settings.channelLayout,
+                                                     settings.sampleFormat);
+        fileSink = wavSink.get();
+        sink = std::move(wavSink);
+    }
+
+    // In verify mode this is the fresh-warmup render, checked block by block
+    // against the snapshot render
+    ComparingSink comparingSink(*sink, worker.verifyBuffer, worker.verifySamples);
+
+    // Hash while writing, the output is never read back
+    HashingSink hashingSink(verifySnapshot ? comparingSink : *sink);
+
+    RenderMetadata metadata;
+    if (!renderer.render(hashingSink, metadata.stats))
+    {
+        logError("Render failed: " + job.outputFile.getFullPathName());
+        return false;
+    }
+
+    recordWarmup(worker, renderer, settings);
+
+    if (verifySnapshot)
+    {
+        metadata.snapshotMaxDifference = comparingSink.getMaxDifference();
+        if (!comparingSink.matches(settings.verifyTolerance))
+        {
+            logError("Snapshot render differs from fresh warmup by "
+                     + juce::String(comparingSink.getMaxDifference(), 6) + ": "
+                     + job.outputFile.getFullPathName());
+            ++worker.snapshotMismatches;
+            return false;
+        }
+    }
+
+    metadata.job = job;
+    metadata.renderedTailSec = renderer.getRenderedTailSec();
+    metadata.tailCutShort = renderer.wasTailCutShort();
+    metadata.cacheKey = cacheKey;
+    metadata.audioHash = hashingSink.getAudioHash();
+    metadata.warmupRestored = renderer.wasWarmupRestored();
+    metadata.timings = timings;
+    worker.timings.addRender(timings);
+
+    return publishResult(worker, job, metadata, fileSink);
+}
+
+bool RenderFarm::applyPresetState(Worker& worker, juce::AudioPluginInstance& plugin,
+                                  const PresetStateBlob*& appliedState, bool& stateDirty,
+                                  const juce::File& presetFile, const MidiPattern& pattern)
+{
+    ScopedPhaseTimer timer(RenderPhase::StateLoad);
+
+    // A default-state job keeps the state on the plugin, restored first if the
+    // last render moved controllers
+    auto* state = appliedState;
+    if (presetFile != juce::File())
+    {
+        state = stateStore.getState(presetFile);
+        if (state == nullptr)
+        {
+            logError("Failed to load preset state: " + presetFile.getFullPathName());
+            return false;
+        }
+    }
+
+    // Rendering notes does not change the plugin's state, so an identical
+    // state (same file or a duplicate) is only applied once per run of views.
+    // Controller and pitch bend automation can persist in the plugin's
+    // parameters, so the state is applied again after such a render.
+    if (state != nullptr && (state != appliedState || stateDirty))
+    {
+        appliedState = nullptr;
+        if (!PresetStateIO::applyState(plugin, state->data, state->size))
+        {
+            logError("Failed to apply preset state: " + presetFile.getFullPathName());
+            return false;
+        }
+
+        appliedState = state;
+        ++worker.stateLoads;
+    }
+
+    stateDirty = pattern.changesControllers();
+    return true;
+}
+
+bool RenderFarm::publishResult(Worker& worker, const RenderJob& job, const RenderMetadata& metadata,
+                               const WavFileSink* fileSink)
+{
+    // Shard metadata goes into the shard's JSONL sidecar, not one file per render
+    if (worker.shardWriter != nullptr)
+        return worker.shardWriter->appendMetadata(metadata.toVar());
+
+    // The consumer commits the record once its metadata arrives
+    if (worker.shmRing != nullptr)
+        return worker.shmRing->writeMetadata(worker.shmRenderId, juce::JSON::toString(metadata.toVar(), true));
+
+    if (!metadata.writeToFile(RenderMetadata::getFileFor(job.outputFile)))
+        return false;
+
+    if (job.settings.asyncWrite)
+    {
+        // Finished, and cached, once the background writer has settled the file
+        worker.pendingWrites.emplace_back(job, metadata.cacheKey);
+        worker.jobAwaitingWrite = true;
+        if (worker.pendingWrites.size() >= maxPendingWrites)
+            flushAsyncWrites(worker);
+    }
+    else if (metadata.cacheKey.isNotEmpty())
+    {
+        // The file was hashed as it was written, so it is not read back
+        Hash128 fileHash;
+        int64 headerSize = 0;
+        const bool hashed = fileSink != nullptr && fileSink->getFileHash(fileHash, headerSize);
+        cache->store(metadata.cacheKey, job.outputFile, hashed ? &fileHash : nullptr, headerSize);
+    }
+
+    return true;
+}
+
+bool RenderFarm::canRenderLockstep(const Worker& worker, const RenderJob& job) const
+{
+    return !worker.lockstepLanes.empty()
+        && worker.shardWriter == nullptr
+        && worker.shmRing == nullptr
+        && !job.settings.asyncWrite
+        && job.settings.warmupMode == WarmupMode::Full;
+}
+
+void RenderFarm::takeLockstepGroup(Worker& worker, std::vector<RenderJob>& group)
+{
+    const auto& first = group.front();
+    const auto& settings = first.settings;
+
+    // Views of one preset with the same block clock and tail rules
+    auto fits = [&](const RenderJob& job)
+    {
+        return canRenderLockstep(worker, job)
+            && job.presetStateFile == first.presetStateFile
+            && job.settings.sampleRate == settings.sampleRate
+            && job.settings.blockSize == settings.blockSize
+            && job.settings.splitAtEvents == settings.splitAtEvents
+            && job.settings.warmupSec == settings.warmupSec
+            && job.settings.renderSec == settings.renderSec
+            && job.settings.tailSec == settings.tailSec
+            && job.settings.adaptiveTail == settings.adaptiveTail
+            && job.settings.silenceThresholdDb == settings.silenceThresholdDb
+            && job.settings.silentBlocks == settings.silentBlocks;
+    };
+
+    std::lock_guard<std::mutex> lock(worker.queueMutex);
+    while (group.size() <= worker.lockstepLanes.size() && !worker.queue.empty() && fits(worker.queue.front()))
+    {
+        group.push_back(std::move(worker.queue.front()));
+        worker.queue.pop_front();
+    }
+}
+
+void RenderFarm::renderLockstep(Worker& worker, const std::vector<RenderJob>& group)
+{
+    const auto& settings = group.front().settings;
+
+    LockstepRenderer renderer(settings.sampleRate, settings.blockSize,
+                              settings.renderSec, settings.tailSec, settings.warmupSec);
+    if (settings.adaptiveTail)
+        renderer.setAdaptiveTail(juce::Decibels::decibelsToGain(settings.silenceThresholdDb),
+                                 settings.silentBlocks);
+    renderer.setSplitAtEvents(settings.splitAtEvents);
+
+    struct View
+    {
+        const RenderJob* job = nullptr;
+        juce::String cacheKey;
+        std::unique_ptr<WavFileSink> fileSink;
+        std::unique_ptr<HashingSink> hashingSink;
+        int lane = -1;
+    };
+
+    std::vector<View> views;
+    views.reserve(group.size());
+
+    auto& timings = getThreadPhaseTimings();
+    timings.reset();
+
+    for (const auto& job : group)
+    {
+        View view;
+        view.job = &job;
+
+        // The worker's own instance first, then its extra instances
+        size_t instance = views.size();
+        auto& session = instance == 0 ? *worker.session : *worker.lockstepLanes[instance - 1]->session;
+        auto& appliedState = instance == 0 ? worker.appliedState : worker.lockstepLanes[instance - 1]->appliedState;
+        auto& stateDirty = instance == 0 ? worker.stateDirty : worker.lockstepLanes[instance - 1]->stateDirty;
+        auto& timeline = instance == 0 ? worker.midiTimeline : worker.lockstepLanes[instance - 1]->midiTimeline;
+
+        if (cache != nullptr)
+        {
+            view.cacheKey = computeCacheKey(*cache, job, session.getPlugin(), appliedState);
+            if (view.cacheKey.isNotEmpty() && cache->lookup(view.cacheKey, job.outputFile))
+            {
+                ++worker.cached;
+                finishJob(worker, job, true);
+                continue;
+            }
+        }
+
+        if (!applyPresetState(worker, session.getPlugin(), appliedState, stateDirty, job.presetStateFile,
+                              job.settings.midiPattern))
+        {
+            finishJob(worker, job, false);
+            continue;
+        }
+
+        juce::String midiError;
+        if (!job.settings.midiPattern.build(timeline, job.noteName, job.velocity,
+                                        job.settings.renderSec, job.settings.sampleRate, midiError))
+        {
+            logError("Failed to build MIDI for " + job.outputFile.getFullPathName() + ": " + midiError);
+            finishJob(worker, job, false);
+            continue;
+        }
+
+        ensureDirectoryExists(job.outputFile.getParentDirectory());
+        view.fileSink = std::make_unique<WavFileSink>(job.outputFile, job.settings.channelLayout,
+                                                      job.settings.sampleFormat);
+        view.hashingSink = std::make_unique<HashingSink>(*view.fileSink);
+        view.lane = renderer.addLane(session, timeline, *view.hashingSink);
+        views.push_back(std::move(view));
+    }
+
+    if (views.empty())
+        return;
+
+    renderer.render();
+    ++worker.lockstepGroups;
+    worker.lockstepViews += static_cast<int64>(views.size());
+
+    // The pass is shared, so each view is charged an equal part of it
+    auto viewTimings = timings;
+    viewTimings.scale(1.0 / static_cast<double>(views.size()));
+
+    for (const auto& view : views)
+    {
+        const auto& job = *view.job;
+        if (!renderer.didLaneSucceed(view.lane))
+        {
+            logError("Render failed: " + job.outputFile.getFullPathName());
+            finishJob(worker, job, false);
+            continue;
+        }
+
+        RenderMetadata metadata;
+        metadata.job = job;
+        metadata.stats = renderer.getStats(view.lane);
+        metadata.renderedTailSec = renderer.getRenderedTailSec(view.lane);
+        metadata.tailCutShort = renderer.wasTailCutShort(view.lane);
+        metadata.cacheKey = view.cacheKey;
+        metadata.audioHash = view.hashingSink->getAudioHash();
+        metadata.timings = viewTimings;
+        worker.timings.addRender(viewTimings);
+
+        finishJob(worker, job, publishResult(worker, job, metadata, view.fileSink.get()));
+    }
+}
+
+} // namespace serum
@@ -0,0 +1,218 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "render/AudioBlockSink.h"
+#include "render/RenderJob.h"
+#include "render/RenderSession.h"
+#include "render/AsyncWavWriter.h"
+#include "render/ShardWriter.h"
+#include "render/ShmAudioRing.h"
+#include "render/RenderCache.h"
+#include "render/RenderTimings.h"
+#include "vst/PluginFactory.h"
+#include "vst/PresetStateStore.h"
+#include "midi/MidiTimeline.h"
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace serum {
+
+/**
+ * Options for the render farm
+ */
+struct RenderFarmOptions
+{
+    int numWorkers = 1;
+    bool pinThreads = false;   // Pin worker i to CPU core i
+    int refillBatchSize = 8;   // Jobs pulled from the source per refill
+    int maxPresetBatch = 512;  // A refill keeps pulling while jobs share a preset, up to this
+    int blockSize = 0;         // Overrides every job's blockSize when positive (see BlockSizeTuner)
+
+    // When set, every worker appends its renders to its own shards here
+    // instead of writing one file per job
+    juce::File shardDirectory;
+    int64 maxShardBytes = 1024 * 1024 * 1024;
+
+    // When set, every render is streamed into this shared-memory ring
+    // (ShmAudioRing) for a consumer process instead of being written here
+    juce::String shmRingName;
+
+    // When set, jobs with a verified cached render are skipped (not for shards or rings)
+    juce::File cacheDirectory;
+
+    // When set, the batch's per-phase timing histograms are written here as JSON
+    juce::File timingReportFile;
+
+    // Experimental: render up to this many views of one preset together on
+    // extra plugin instances per worker (LockstepRenderer). Only jobs with a
+    // full warmup written synchronously to files take part.
+    int lockstepViews = 1;
+
+    // Called on the worker thread as each job finishes (rendered, cached or failed)
+    std::function<void(const RenderJob& job, bool ok)> onJobFinished;
+};
+
+/**
+ * Totals reported after a farm run
+ */
+struct RenderFarmSummary
+{
+    int64 jobsCompleted = 0;
+    int64 jobsFailed = 0;
+    int64 jobsStolen = 0;
+    int64 jobsCached = 0;   // Included in jobsCompleted
+    int64 stateLoads = 0;   // Preset states applied to a plugin
+
+    // Warmup phases run in full and restored from a snapshot, with their cost
+    int64 warmupsRun = 0;
+    int64 warmupsRestored = 0;
+    double warmupSeconds = 0.0;
+    double restoreSeconds = 0.0;
+    int64 snapshotMismatches = 0;   // Verify mode renders beyond tolerance
+    int64 lockstepGroups = 0;       // LockstepRenderer passes
+    int64 lockstepViews = 0;        // Jobs rendered in those passes
+    RenderTimingReport timings;     // Per-phase histograms of the rendered (not cached) jobs
+    double wallSeconds = 0.0;
+};
+
+/**
+ * Multi-core batch renderer
+ * Owns one pre-created plugin instance per worker thread. Each worker pulls
+ * batches of jobs lazily from a RenderJobSource into its own deque and steals
+ * from other workers' deques once the source runs dry.
+ */
+class OfflineRenderer;
+struct RenderMetadata;
+
+class RenderFarm
+{
+public:
+    /**
+     * Constructor
+     * @param factory Factory used to create the worker plugin instances
+     * @param desc Plugin to instantiate for every worker
+     * @param options Farm options
+     */
+    RenderFarm(
+        PluginFactory& factory,
+        const juce::PluginDescription& desc,
+        const RenderFarmOptions& options
+    );
+    ~RenderFarm();
+
+    /**
+     * Create one plugin instance per worker
+     * Must be called on the message thread before run()
+     * @param errorMsg Output error message if creation fails
+     * @param settings Instances are prepared for this sample rate and block size
+     *                 (--block-size wins); pass the first job's so it skips prepareToPlay
+     * @return true if all instances were created
+     */
+    bool createWorkers(juce::String& errorMsg, const RenderSettings& settings = RenderSettings());
+
+    /**
+     * Render every job from the source, blocking until done
+     * @param source Job source (pulled lazily, never fully materialized)
+     * @param outSummary Output totals
+     * @return true if every job rendered successfully
+     */
+    bool run(RenderJobSource& source, RenderFarmSummary& outSummary);
+
+    int getNumWorkers() const { return static_cast<int>(workers.size()); }
+
+    /**
+     * Preset states shared by all workers; scan() it up front to load every
+     * state once before rendering
+     */
+    PresetStateStore& getStateStore() { return stateStore; }
+
+private:
+    /**
+     * Extra plugin instance of a worker for lockstep rendering
+     */
+    struct LockstepLane
+    {
+        std::unique_ptr<juce::AudioPluginInstance> plugin;
+        std::unique_ptr<RenderSession> session;
+        const PresetStateBlob* appliedState = nullptr;
+        bool stateDirty = false;
+        MidiTimeline midiTimeline;
+    };
+
+    struct Worker
+    {
+        std::unique_ptr<juce::AudioPluginInstance> plugin;
+        std::unique_ptr<RenderSession> session;  // Keeps the plugin prepared across jobs
+        std::unique_ptr<AsyncWavWriter> asyncWriter;  // Created on first asyncWrite job
+        std::unique_ptr<ShardWriter> shardWriter;     // Set when rendering into shards
+        ShardKey shardKey;
+        std::unique_ptr<ShmAudioRing> shmRing;       // Set when streaming to a consumer process
+        uint64 shmRenderId = 0;
+        std::vector<std::pair<RenderJob, juce::String>> pendingWrites;  // Job and cache key, awaiting async write
+        bool jobAwaitingWrite = false;  // The last rendered job is finished by flushAsyncWrites()
+        const PresetStateBlob* appliedState = nullptr;  // Last state set on the plugin
+        bool stateDirty = false;                        // A render since then moved controllers
+        juce::AudioBuffer<float> verifyBuffer;           // Snapshot render in verify mode
+        int64 verifySamples = 0;
+        MidiTimeline midiTimeline;  // Rebuilt per job, keeps its capacity
+        std::vector<std::unique_ptr<LockstepLane>> lockstepLanes;
+        std::deque<RenderJob> queue;
+        std::mutex queueMutex;
+        std::thread thread;
+        int64 completed = 0;
+        int64 failed = 0;
+        int64 stolen = 0;
+        int64 cached = 0;
+        int64 stateLoads = 0;
+        int64 warmupsRun = 0;
+        int64 warmupsRestored = 0;
+        double warmupSeconds = 0.0;
+        double restoreSeconds = 0.0;
+        int64 snapshotMismatches = 0;
+        int64 lockstepGroups = 0;
+        int64 lockstepViews = 0;
+        RenderTimingReport timings;
+    };
+
+    PluginFactory& factory;
+    juce::PluginDescription desc;
+    RenderFarmOptions options;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::unique_ptr<RenderCache> cache;
+    PresetStateStore stateStore;
+
+    RenderJobSource* source = nullptr;
+    std::mutex sourceMutex;
+    bool sourceExhausted = false;
+    RenderJob lookahead;           // Pulled from the source but not yet queued
+    bool hasLookahead = false;
+    std::atomic<int> activeWorkers { 0 };
+    std::atomic<int64> jobsFinished { 0 };
+
+    void workerLoop(int index);
+    bool takeJob(int index, RenderJob& job);
+    bool refillFromSource(Worker& worker, RenderJob& job);
+    bool pullFromSource(RenderJob& job);
+    bool stealJob(int thiefIndex, RenderJob& job);
+    void finishJob(Worker& worker, const RenderJob& job, bool ok);
+    bool renderJob(Worker& worker, const RenderJob& job);
+    bool applyPresetState(Worker& worker, juce::AudioPluginInstance& plugin,
+                          const PresetStateBlob*& appliedState, bool& stateDirty,
+                          const juce::File& presetFile, const MidiPattern& pattern);
+    bool publishResult(Worker& worker, const RenderJob& job, const RenderMetadata& metadata,
+                       const WavFileSink* fileSink = nullptr);
+    bool canRenderLockstep(const Worker& worker, const RenderJob& job) const;
+    void takeLockstepGroup(Worker& worker, std::vector<RenderJob>& group);
+    void renderLockstep(Worker& worker, const std::vector<RenderJob>& group);
+    bool renderSnapshotReference(Worker& worker, const RenderJob& job, MidiEventSource& midiSource);
+    void recordWarmup(Worker& worker, const OfflineRenderer& renderer, const RenderSettings& settings);
+    void flushAsyncWrites(Worker& worker);
+};
+
+} // namespace serum
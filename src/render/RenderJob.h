@@ -0,0 +1,110 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "midi/MidiPattern.h"
+#include "render/WavWriter.h"
+#include <vector>
+
+namespace serum {
+
+/**
+ * How the warmup phase is run
+ */
+enum class WarmupMode
+{
+    Full,       // Run the warmup before every render
+    Snapshot,   // Warm up once per preset state, then restore the captured state
+    Verify      // Snapshot, and check each render against a fresh warmup
+};
+
+/**
+ * Timing configuration shared by the renders of a job
+ */
+struct RenderSettings
+{
+    double sampleRate = 44100.0;
+    int blockSize = 512;
+    double warmupSec = 0.2;
+    double renderSec = 2.0;
+    double tailSec = 1.0;
+
+    // Adaptive tail: stop once silentBlocks consecutive blocks peak below
+    // silenceThresholdDb; tailSec stays the upper bound
+    bool adaptiveTail = false;
+    float silenceThresholdDb = -90.0f;
+    int silentBlocks = 8;
+
+    // Split blocks at MIDI events, for plugins that apply events at block
+    // starts; blockSize then only bounds the sub-blocks
+    bool splitAtEvents = false;
+
+    // Write through a background thread instead of on the render thread
+    bool asyncWrite = false;
+
+    // File channels relative to the plugin output
+    ChannelLayout channelLayout = ChannelLayout::Stereo;
+
+    // Sample encoding; also selects the file extension
+    SampleFormat sampleFormat = SampleFormat::Pcm24;
+
+    // Warmup reuse; Verify fails renders differing by more than verifyTolerance
+    WarmupMode warmupMode = WarmupMode::Full;
+    float verifyTolerance = 1.0e-4f;
+
+    // Notes and automation played during renderSec, relative to the job note
+    MidiPattern midiPattern;
+};
+
+/**
+ * A single (preset state × note × velocity) view to render
+ */
+struct RenderJob
+{
+    juce::File presetStateFile;  // Empty to render the plugin's current state
+    juce::String noteName = "C4";
+    int velocity = 100;
+    RenderSettings settings;
+    juce::File outputFile;
+};
+
+/**
+ * Source of render jobs, pulled lazily by the renderer
+ * Implementations are only ever called from one thread at a time
+ */
+class RenderJobSource
+{
+public:
+    virtual ~RenderJobSource() = default;
+
+    /**
+     * Fetch the next job
+     * @param job Output job
+     * @return false when the source is exhausted
+     */
+    virtual bool next(RenderJob& job) = 0;
+};
+
+/**
+ * Job source backed by an in-memory list
+ */
+class RenderJobList : public RenderJobSource
+{
+public:
+    void add(const RenderJob& job) { jobs.push_back(job); }
+    size_t size() const { return jobs.size(); }
+
+    bool next(RenderJob& job) override
+    {
+        if (position >= jobs.size())
+            return false;
+
+        job = jobs[position++];
+        return true;
+    }
+
+private:
+    std::vector<RenderJob> jobs;
+    size_t position = 0;
+};
+
+} // namespace serum
@@ -0,0 +1,517 @@
+#include "render/RenderManifest.h"
+#include "common/Log.h"
+#include "common/Paths.h"
+#include "midi/SyntheticMidiGenerator.h"
+
+namespace serum {
+
+RenderManifest::RenderManifest()
+{
+    defaultNaming.directory = getOutputWavDir();
+}
+
+RenderManifest::~RenderManifest()
+{
+}
+
+bool RenderManifest::open(const juce::File& file, juce::String& errorMsg)
+{
+    manifestFile = file;
+    lineNumber = 0;
+    numInvalidLines = 0;
+    hasGrid = false;
+
+    stream.reset();
+    auto fileStream = std::make_unique<juce::FileInputStream>(file);
+    if (!fileStream->openedOk())
+    {
+        errorMsg = "Failed to open manifest: " + file.getFullPathName();
+        logError(errorMsg);
+        return false;
+    }
+
+    // readNextLine() reads a byte at a time; buffered, that is one syscall per 64 KB
+    stream = std::make_unique<juce::BufferedInputStream>(fileStream.release(), readBufferSize, true);
+
+    logInfo("Streaming render manifest: " + file.getFullPathName());
+    return true;
+}
+
+bool RenderManifest::readFirstJobSettings(const juce::File& manifestFile, RenderSettings& settings)
+{
+    RenderManifest manifest;
+    RenderJob job;
+    juce::String errorMsg;
+    if (!manifest.open(manifestFile, errorMsg) || !manifest.next(job))
+        return false;
+
+    settings = job.settings;
+    return true;
+}
+
+bool RenderManifest::next(RenderJob& job)
+{
+    while (!hasGrid || grid.isDone())
+    {
+        if (!readNextGrid())
+            return false;
+    }
+
+    auto& preset = grid.presets.getReference(grid.presetIndex);
+    auto& note = grid.notes.getReference(grid.noteIndex);
+    int velocity = grid.velocities[grid.velocityIndex];
+
+    job.presetStateFile = preset;
+    job.noteName = note;
+    job.velocity = velocity;
+    job.settings = grid.settings;
+    job.outputFile = resolveOutputFile(grid.naming, grid.settings.sampleFormat, preset, note, velocity);
+
+    // Advance velocity fastest, then note, then preset, so all views of one
+    // preset state come out back to back
+    if (++grid.velocityIndex >= grid.velocities.size())
+    {
+        grid.velocityIndex = 0;
+        if (++grid.noteIndex >= grid.notes.size())
+        {
+            grid.noteIndex = 0;
+            ++grid.presetIndex;
+        }
+    }
+
+    return true;
+}
+
+bool RenderManifest::readNextGrid()
+{
+    if (stream == nullptr)
+        return false;
+
+    while (!stream->isExhausted())
+    {
+        auto text = stream->readNextLine().trim();
+        ++lineNumber;
+
+        if (text.isEmpty() || text.startsWithChar('#'))
+            continue;
+
+        juce::String errorMsg;
+        juce::var line;
+        auto parseResult = juce::JSON::parse(text, line);
+
+        if (parseResult.failed() || !line.isObject())
+        {
+            errorMsg = parseResult.failed() ? parseResult.getErrorMessage() : "expected a JSON object";
+        }
+        else if (line.hasProperty("settings"))
+        {
+            if (parseSettings(line["settings"], defaultSettings, defaultNaming, errorMsg))
+                continue;
+        }
+        else if (parseGrid(line, grid, errorMsg))
+        {
+            if (!grid.isDone())
+            {
+                hasGrid = true;
+                return true;
+            }
+
+            logWarning("Manifest line " + juce::String(lineNumber) + " expands to no jobs");
+            continue;
+        }
+
+        ++numInvalidLines;
+        logError("Manifest line " + juce::String(lineNumber) + ": " + errorMsg);
+    }
+
+    hasGrid = false;
+    return false;
+}
+
+bool RenderManifest::parseGrid(const juce::var& line, Grid& outGrid, juce::String& errorMsg)
+{
+    Grid parsed;
+    parsed.settings = defaultSettings;
+    parsed.naming = defaultNaming;
+
+    // Per-line overrides use the same keys as the settings object
+    if (!parseSettings(line, parsed.settings, parsed.naming, errorMsg))
+        return false;
+
+    if (line.hasProperty("presets"))
+    {
+        if (!parsePresets(line["presets"], parsed.presets, errorMsg))
+            return false;
+    }
+    else if (line.hasProperty("preset"))
+    {
+        if (!parsePresets(line["preset"], parsed.presets, errorMsg))
+            return false;
+    }
+    else
+    {
+        parsed.presets.add(juce::File());  // Plugin's current state
+    }
+
+    const auto& notes = line.hasProperty("notes") ? line["notes"] : line["note"];
+    if (notes.isArray())
+    {
+        for (const auto& note : *notes.getArray())
+            parsed.notes.add(note.toString());
+    }
+    else if (notes.isString())
+    {
+        parsed.notes.add(notes.toString());
+    }
+    else if (!notes.isVoid())
+    {
+        errorMsg = "\"notes\" must be a string or an array of strings";
+        return false;
+    }
+    else
+    {
+        parsed.notes.add("C4");
+    }
+
+    for (const auto& note : parsed.notes)
+    {
+        if (!SyntheticMidiGenerator::isValidNoteName(note))
+        {
+            errorMsg = "invalid note name: \"" + note + "\"";
+            return false;
+        }
+    }
+
+    const auto& velocities = line.hasProperty("velocities") ? line["velocities"] : line["velocity"];
+    if (velocities.isVoid())
+        parsed.velocities.add(100);
+    else if (!parseVelocities(velocities, parsed.velocities, errorMsg))
+        return false;
+
+    if (parsed.notes.isEmpty() || parsed.velocities.isEmpty())
+        parsed.presets.clear();
+
+    outGrid = std::move(parsed);
+    return true;
+}
+
+bool RenderManifest::parseSettings(const juce::var& object, RenderSettings& settings,
+                                   OutputNaming& naming, juce::String& errorMsg)
+{
+    if (!object.isObject())
+    {
+        errorMsg = "\"settings\" must be a JSON object";
+        return false;
+    }
+
+    RenderSettings parsed = settings;
+    if (object.hasProperty("sampleRate"))         parsed.sampleRate = object["sampleRate"];
+    if (object.hasProperty("blockSize"))          parsed.blockSize = object["blockSize"];
+    if (object.hasProperty("warmupSec"))          parsed.warmupSec = object["warmupSec"];
+    if (object.hasProperty("renderSec"))          parsed.renderSec = object["renderSec"];
+    if (object.hasProperty("tailSec"))            parsed.tailSec = object["tailSec"];
+    if (object.hasProperty("adaptiveTail"))       parsed.adaptiveTail = object["adaptiveTail"];
+    if (object.hasProperty("silenceThresholdDb")) parsed.silenceThresholdDb = object["silenceThresholdDb"];
+    if (object.hasProperty("silentBlocks"))       parsed.silentBlocks = object["silentBlocks"];
+    if (object.hasProperty("asyncWrite"))         parsed.asyncWrite = object["asyncWrite"];
+    if (object.hasProperty("splitAtEvents"))      parsed.splitAtEvents = object["splitAtEvents"];
+
+    if (object.hasProperty("channels"))
+    {
+        auto channels = object["channels"].toString();
+        if (channels == "source")      parsed.channelLayout = ChannelLayout::MatchSource;
+        else if (channels == "mono")   parsed.channelLayout = ChannelLayout::Mono;
+        else if (channels == "stereo") parsed.channelLayout = ChannelLayout::Stereo;
+        else
+        {
+            errorMsg = "\"channels\" must be \"source\", \"mono\" or \"stereo\"";
+            return false;
+        }
+    }
+
+    if (object.hasProperty("verifyTolerance"))    parsed.verifyTolerance = object["verifyTolerance"];
+
+    if (object.hasProperty("warmup"))
+    {
+        auto warmup = object["warmup"].toString();
+        if (warmup == "full")          parsed.warmupMode = WarmupMode::Full;
+        else if (warmup == "snapshot") parsed.warmupMode = WarmupMode::Snapshot;
+        else if (warmup == "verify")   parsed.warmupMode = WarmupMode::Verify;
+        else
+        {
+            errorMsg = "\"warmup\" must be \"full\", \"snapshot\" or \"verify\"";
+            return false;
+        }
+    }
+
+    if (!parseMidiPattern(object, parsed.midiPattern, errorMsg))
+        return false;
+
+    if (object.hasProperty("format") && !parseSampleFormat(object["format"].toString(), parsed.sampleFormat))
+    {
+        errorMsg = "\"format\" must be \"pcm16\", \"pcm24\", \"float32\", \"f32\" or \"npy\"";
+        return false;
+    }
+
+    if (parsed.sampleRate <= 0.0 || parsed.blockSize <= 0)
+    {
+        errorMsg = "sampleRate and blockSize must be positive";
+        return false;
+    }
+
+    if (parsed.warmupSec < 0.0 || parsed.renderSec <= 0.0 || parsed.tailSec < 0.0)
+    {
+        errorMsg = "renderSec must be positive, warmupSec and tailSec non-negative";
+        return false;
+    }
+
+    if (parsed.adaptiveTail && parsed.silentBlocks <= 0)
+    {
+        errorMsg = "silentBlocks must be positive";
+        return false;
+    }
+
+    if (object.hasProperty("outputDir"))
+    {
+        auto dir = object["outputDir"].toString();
+        naming.directory = juce::File::isAbsolutePath(dir)
+            ? juce::File(dir)
+            : getOutputWavDir().getChildFile(dir);
+    }
+
+    if (object.hasProperty("output"))
+        naming.pattern = object["output"].toString();
+
+    settings = parsed;
+    return true;
+}
+
+bool RenderManifest::parseMidiPattern(const juce::var& object, MidiPattern& pattern, juce::String& errorMsg)
+{
+    MidiPattern parsed = pattern;
+
+    // An empty chord or MIDI file name goes back to the single note
+    if (object.hasProperty("chord"))
+    {
+        parsed.intervals.clear();
+        if (!parseIntervals(object["chord"], parsed.intervals, errorMsg))
+            return false;
+
+        parsed.type = parsed.intervals.isEmpty() ? MidiPattern::Type::Note : MidiPattern::Type::Chord;
+    }
+
+    if (object.hasProperty("arpeggio"))
+    {
+        const auto& arpeggio = object["arpeggio"];
+        if (!arpeggio.isObject())
+        {
+            errorMsg = "\"arpeggio\" must be a JSON object";
+            return false;
+        }
+
+        parsed.intervals.clear();
+        if (!parseIntervals(arpeggio["intervals"], parsed.intervals, errorMsg))
+            return false;
+
+        parsed.type = MidiPattern::Type::Arpeggio;
+        parsed.stepSec = arpeggio.getProperty("stepSec", parsed.stepSec);
+        parsed.gate = arpeggio.getProperty("gate", parsed.gate);
+
+        auto direction = arpeggio.getProperty("direction", "up").toString();
+        if (direction == "up")          parsed.direction = MidiTimeline::ArpeggioDirection::Up;
+        else if (direction == "down")   parsed.direction = MidiTimeline::ArpeggioDirection::Down;
+        else if (direction == "updown") parsed.direction = MidiTimeline::ArpeggioDirection::UpDown;
+        else
+        {
+            errorMsg = "arpeggio \"direction\" must be \"up\", \"down\" or \"updown\"";
+            return false;
+        }
+
+        if (parsed.intervals.isEmpty() || parsed.stepSec <= 0.0 || parsed.gate <= 0.0 || parsed.gate > 1.0)
+        {
+            errorMsg = "arpeggio needs intervals, a positive stepSec and a gate in (0, 1]";
+            return false;
+        }
+    }
+
+    if (object.hasProperty("midiFile"))
+    {
+        parsed.midiFile = object["midiFile"].toString();
+        parsed.type = parsed.midiFile.isEmpty() ? MidiPattern::Type::Note : MidiPattern::Type::File;
+
+        if (parsed.type == MidiPattern::Type::File && !parsed.getMidiFile().existsAsFile())
+        {
+            errorMsg = "MIDI file not found: " + parsed.getMidiFile().getFullPathName();
+            return false;
+        }
+    }
+
+    if (object.hasProperty("ramps"))
+    {
+        const auto& ramps = object["ramps"];
+        if (!ramps.isArray())
+        {
+            errorMsg = "\"ramps\" must be an array";
+            return false;
+        }
+
+        parsed.ramps.clear();
+        for (const auto& value : *ramps.getArray())
+        {
+            MidiRamp ramp;
+            const auto& target = value["target"];
+            if (target.toString() == "pitchBend")
+            {
+                ramp.controller = -1;
+            }
+            else if (target.isInt() || target.isInt64() || target.isDouble())
+            {
+                ramp.controller = static_cast<int>(target);
+                if (ramp.controller < 0 || ramp.controller > 127)
+                {
+                    errorMsg = "ramp controller out of range (0-127): " + juce::String(ramp.controller);
+                    return false;
+                }
+            }
+            else
+            {
+                errorMsg = "ramp \"target\" must be \"pitchBend\" or a controller number";
+                return false;
+            }
+
+            ramp.from = value.getProperty("from", 0.0f);
+            ramp.to = value.getProperty("to", 0.0f);
+            ramp.startSec = value.getProperty("start", 0.0);
+            ramp.endSec = value.getProperty("end", -1.0);
+            parsed.ramps.push_back(ramp);
+        }
+    }
+
+    pattern = parsed;
+    return true;
+}
+
+bool RenderManifest::parseIntervals(const juce::var& value, juce::Array<int>& intervals, juce::String& errorMsg)
+{
+    if (!value.isArray())
+    {
+        errorMsg = "chord and arpeggio intervals must be an array of semitones";
+        return false;
+    }
+
+    for (const auto& interval : *value.getArray())
+        intervals.add(static_cast<int>(interval));
+
+    return true;
+}
+
+bool RenderManifest::parsePresets(const juce::var& value, juce::Array<juce::File>& presets,
+                                  juce::String& errorMsg)
+{
+    juce::StringArray names;
+    if (value.isArray())
+    {
+        for (const auto& name : *value.getArray())
+            names.add(name.toString());
+    }
+    else if (value.isString())
+    {
+        names.add(value.toString());
+    }
+    else
+    {
+        errorMsg = "\"preset\" must be a string or an array of strings";
+        return false;
+    }
+
+    auto statesDir = getPresetStatesDir();
+    for (const auto& name : names)
+    {
+        if (name.isEmpty())
+        {
+            presets.add(juce::File());
+        }
+        else if (name.containsAnyOf("*?"))
+        {
+            // Wildcards sweep the preset states directory, sorted for determinism
+            juce::Array<juce::File> matches;
+            statesDir.findChildFiles(matches, juce::File::findFiles, false, name);
+            matches.sort();
+            presets.addArray(matches);
+        }
+        else
+        {
+            presets.add(juce::File::isAbsolutePath(name) ? juce::File(name)
+                                                         : statesDir.getChildFile(name));
+        }
+    }
+
+    return true;
+}
+
+bool RenderManifest::parseVelocities(const juce::var& value, juce::Array<int>& velocities,
+                                     juce::String& errorMsg)
+{
+    if (value.isArray())
+    {
+        for (const auto& velocity : *value.getArray())
+            velocities.add(static_cast<int>(velocity));
+    }
+    else if (value.isObject())
+    {
+        int from = value.getProperty("from", 1);
+        int to = value.getProperty("to", 127);
+        int step = value.getProperty("step", 1);
+
+        if (step <= 0)
+        {
+            errorMsg = "velocity range step must be positive";
+            return false;
+        }
+
+        // Checked before expanding, so a huge range neither allocates nor overflows
+        for (int bound : { from, to })
+        {
+            if (bound < 1 || bound > 127)
+            {
+                errorMsg = "velocity range bound out of range (1-127): " + juce::String(bound);
+                return false;
+            }
+        }
+
+        for (int velocity = from; velocity <= to; velocity += juce::jmin(step, 127))
+            velocities.add(velocity);
+    }
+    else
+    {
+        velocities.add(static_cast<int>(value));
+    }
+
+    for (int velocity : velocities)
+    {
+        if (velocity < 1 || velocity > 127)
+        {
+            errorMsg = "velocity out of range (1-127): " + juce::String(velocity);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+juce::File RenderManifest::resolveOutputFile(const OutputNaming& naming, SampleFormat format,
+                                             const juce::File& preset, const juce::String& note,
+                                             int velocity)
+{
+    auto presetName = preset == juce::File() ? juce::String("default")
+                                             : preset.getFileNameWithoutExtension();
+
+    auto name = naming.pattern
+        .replace("{preset}", presetName)
+        .replace("{note}", note)
+        .replace("{velocity}", juce::String(velocity));
+
+    return naming.directory.getChildFile(name + getSampleFormatExtension(format));
+}
+
+} // namespace serum
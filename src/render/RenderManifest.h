@@ -0,0 +1,109 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "render/RenderJob.h"
+#include <memory>
+
+namespace serum {
+
+/**
+ * Streaming reader for JSONL render manifests
+ *
+ * Each non-empty line is a JSON object. A line with a "settings" object
+ * updates the defaults for every following line; any other line describes a
+ * grid of preset states × notes × velocities that is expanded lazily, one job
+ * per call to next(). Only the current line is ever held in memory.
+ *
+ *   {"settings": {"sampleRate": 48000, "blockSize": 512, "renderSec": 3.0}}
+ *   {"preset": "*.bin", "notes": ["C3", "C4"], "velocities": {"from": 20, "to": 120, "step": 20}}
+ *   {"preset": "pluck.bin", "note": "A4", "velocity": 100, "output": "{preset}/{note}_{velocity}"}
+ *   {"preset": "pad.bin", "notes": ["C3"], "chord": [0, 4, 7], "ramps": [{"target": 1, "from": 0, "to": 127}]}
+ */
+class RenderManifest : public RenderJobSource
+{
+public:
+    RenderManifest();
+    ~RenderManifest() override;
+
+    /**
+     * Open a manifest file for streaming
+     * @param manifestFile JSONL manifest
+     * @param errorMsg Output error message if opening fails
+     * @return true if opened successfully
+     */
+    bool open(const juce::File& manifestFile, juce::String& errorMsg);
+
+    /**
+     * Fetch the next expanded job
+     * Invalid lines are logged and skipped
+     */
+    bool next(RenderJob& job) override;
+
+    /**
+     * Settings of a manifest's first job, read with a separate stream
+     * Lets plugin instances be prepared for them before rendering starts.
+     * @return false if the manifest cannot be read or has no job
+     */
+    static bool readFirstJobSettings(const juce::File& manifestFile, RenderSettings& settings);
+
+    /**
+     * Current line number (1-based) for diagnostics
+     */
+    int64 getLineNumber() const { return lineNumber; }
+
+    /**
+     * Number of lines skipped because they could not be parsed
+     */
+    int64 getNumInvalidLines() const { return numInvalidLines; }
+
+private:
+    struct OutputNaming
+    {
+        juce::File directory;
+        juce::String pattern = "{preset}_{note}_v{velocity}";
+    };
+
+    struct Grid
+    {
+        juce::Array<juce::File> presets;
+        juce::StringArray notes;
+        juce::Array<int> velocities;
+        RenderSettings settings;
+        OutputNaming naming;
+
+        int presetIndex = 0;
+        int noteIndex = 0;
+        int velocityIndex = 0;
+
+        bool isDone() const { return presetIndex >= presets.size(); }
+    };
+
+    static constexpr int readBufferSize = 64 * 1024;
+
+    std::unique_ptr<juce::BufferedInputStream> stream;
+    juce::File manifestFile;
+    int64 lineNumber = 0;
+    int64 numInvalidLines = 0;
+
+    RenderSettings defaultSettings;
+    OutputNaming defaultNaming;
+    Grid grid;
+    bool hasGrid = false;
+
+    bool readNextGrid();
+    bool parseGrid(const juce::var& line, Grid& outGrid, juce::String& errorMsg);
+
+    static bool parseSettings(const juce::var& object, RenderSettings& settings,
+                              OutputNaming& naming, juce::String& errorMsg);
+    static bool parseMidiPattern(const juce::var& object, MidiPattern& pattern, juce::String& errorMsg);
+    static bool parseIntervals(const juce::var& value, juce::Array<int>& intervals, juce::String& errorMsg);
+    static bool parsePresets(const juce::var& value, juce::Array<juce::File>& presets,
+                             juce::String& errorMsg);
+    static bool parseVelocities(const juce::var& value, juce::Array<int>& velocities,
+                                juce::String& errorMsg);
+    static juce::File resolveOutputFile(const OutputNaming& naming, SampleFormat format,
+                                        const juce::File& preset, const juce::String& note,
+                                        int velocity);
+};
+
+} // namespace serum
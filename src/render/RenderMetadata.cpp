@@ -0,0 +1,83 @@
+#include "render/RenderMetadata.h"
+#include "common/Log.h"
+#include "common/Paths.h"
+
+namespace serum {
+
+juce::var RenderMetadata::toVar() const
+{
+    auto* object = new juce::DynamicObject();
+    juce::var result(object);
+
+    const auto& settings = job.settings;
+    object->setProperty("output", job.outputFile.getFullPathName());
+    object->setProperty("preset", job.presetStateFile == juce::File()
+                                      ? juce::String()
+                                      : job.presetStateFile.getFileName());
+    object->setProperty("note", job.noteName);
+    object->setProperty("velocity", job.velocity);
+    object->setProperty("midi", settings.midiPattern.describe());
+
+    object->setProperty("sampleRate", settings.sampleRate);
+    object->setProperty("blockSize", settings.blockSize);
+    object->setProperty("splitAtEvents", settings.splitAtEvents);
+    object->setProperty("warmupSec", settings.warmupSec);
+    object->setProperty("renderSec", settings.renderSec);
+    object->setProperty("tailSec", settings.tailSec);
+    object->setProperty("adaptiveTail", settings.adaptiveTail);
+    object->setProperty("warmup", settings.warmupMode == WarmupMode::Full       ? "full"
+                                : settings.warmupMode == WarmupMode::Snapshot ? "snapshot"
+                                                                              : "verify");
+    object->setProperty("format", juce::String(getSampleFormatName(settings.sampleFormat)));
+    object->setProperty("renderedTailSec", renderedTailSec);
+    object->setProperty("tailCutShort", tailCutShort);
+    object->setProperty("audioHash", audioHash.toHexString());
+    object->setProperty("warmupRestored", warmupRestored);
+    if (snapshotMaxDifference >= 0.0f)
+        object->setProperty("snapshotMaxDifference", snapshotMaxDifference);
+    if (cacheKey.isNotEmpty())
+        object->setProperty("cacheKey", cacheKey);
+
+    object->setProperty("timings", timings.toVar());
+
+    object->setProperty("totalSamples", stats.totalSamples);
+    object->setProperty("peakL", stats.peakL);
+    object->setProperty("peakR", stats.peakR);
+    object->setProperty("rmsL", stats.rmsL);
+    object->setProperty("rmsR", stats.rmsR);
+    object->setProperty("truePeakL", stats.truePeakL);
+    object->setProperty("truePeakR", stats.truePeakR);
+    object->setProperty("dcOffsetL", stats.dcOffsetL);
+    object->setProperty("dcOffsetR", stats.dcOffsetR);
+    object->setProperty("zeroCrossingsL", stats.zeroCrossingsL);
+    object->setProperty("zeroCrossingsR", stats.zeroCrossingsR);
+    object->setProperty("clippedSamplesL", stats.clippedSamplesL);
+    object->setProperty("clippedSamplesR", stats.clippedSamplesR);
+
+    return result;
+}
+
+bool RenderMetadata::writeToFile(const juce::File& metaFile) const
+{
+    ensureDirectoryExists(metaFile.getParentDirectory());
+
+    if (!metaFile.replaceWithText(juce::JSON::toString(toVar())))
+    {
+        logError("Failed to write metadata: " + metaFile.getFullPathName());
+        return false;
+    }
+
+    return true;
+}
+
+juce::File RenderMetadata::getFileFor(const juce::File& outputFile)
+{
+    auto wavDir = getOutputWavDir();
+    auto name = outputFile.isAChildOf(wavDir)
+        ? outputFile.getRelativePathFrom(wavDir)
+        : outputFile.getFileName();
+
+    return getOutputMetaDir().getChildFile(name).withFileExtension(".json");
+}
+
+} // namespace serum
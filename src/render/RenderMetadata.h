@@ -0,0 +1,47 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "render/RenderJob.h"
+#include "render/AudioStats.h"
+#include "render/RenderTimings.h"
+#include "common/Hash.h"
+
+namespace serum {
+
+/**
+ * Per-render metadata written as JSON next to the output in data/outmeta/
+ */
+struct RenderMetadata
+{
+    RenderJob job;
+    AudioStats stats;
+    double renderedTailSec = 0.0;  // Actual tail length (shorter than tailSec if cut short)
+    bool tailCutShort = false;
+    juce::String cacheKey;         // Render cache key, empty when caching is off
+    Hash128 audioHash;             // Hash of the rendered float audio (see HashingSink)
+    bool warmupRestored = false;   // Warmup replaced by a post-warmup snapshot
+    float snapshotMaxDifference = -1.0f;  // Verify mode only: deviation of the snapshot render
+    PhaseTimings timings;          // Where the render's time went (see RenderTimings.h)
+
+    /**
+     * Build the JSON representation
+     */
+    juce::var toVar() const;
+
+    /**
+     * Write as JSON
+     * @param metaFile Output .json file
+     * @return true if written successfully
+     */
+    bool writeToFile(const juce::File& metaFile) const;
+
+    /**
+     * Metadata file for a render output
+     * Mirrors the output's path below data/outwav/ into data/outmeta/
+     * @param outputFile Rendered audio file
+     * @return Matching .json file in the metadata directory
+     */
+    static juce::File getFileFor(const juce::File& outputFile);
+};
+
+} // namespace serum
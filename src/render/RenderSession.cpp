@@ -0,0 +1,147 @@
+#include "render/RenderSession.h"
+#include "render/RenderTimings.h"
+#include "common/Log.h"
+
+namespace serum {
+
+static constexpr size_t midiBufferReserveBytes = 4096;
+
+RenderSession::RenderSession(juce::AudioPluginInstance& plugin)
+    : plugin(plugin)
+{
+    // Reserve once so filling the render loop's MIDI buffer never allocates
+    midiBuffer.ensureSize(midiBufferReserveBytes);
+    scratchMidi.ensureSize(midiBufferReserveBytes);
+
+    // Reset all controllers (CC 121), centred pitch wheel, all notes off
+    // (CC 123) and all sound off (CC 120) on every channel, so automation of
+    // one render never carries into the next
+    for (int channel = 1; channel <= 16; ++channel)
+    {
+        panicMidi.addEvent(juce::MidiMessage::controllerEvent(channel, 121, 0), 0);
+        panicMidi.addEvent(juce::MidiMessage::pitchWheel(channel, 8192), 0);
+        panicMidi.addEvent(juce::MidiMessage::allNotesOff(channel), 0);
+        panicMidi.addEvent(juce::MidiMessage::allSoundOff(channel), 0);
+    }
+}
+
+RenderSession::~RenderSession()
+{
+    release();
+}
+
+bool RenderSession::prepare(double newSampleRate, int newBlockSize)
+{
+    if (prepared && newSampleRate == sampleRate && newBlockSize == blockSize)
+        return true;
+
+    release();
+
+    ScopedPhaseTimer timer(RenderPhase::Prepare);
+    SERUM_LOG_DEBUG("Preparing plugin for playback");
+    sampleRate = newSampleRate;
+    blockSize = newBlockSize;
+
+    plugin.prepareToPlay(sampleRate, blockSize);
+    plugin.setNonRealtime(true);
+
+    // Buffer must hold every input and output channel; a mono synth renders mono
+    numChannels = juce::jmax(1, plugin.getTotalNumInputChannels(), plugin.getTotalNumOutputChannels());
+    buffer.setSize(numChannels, blockSize);
+
+    prepared = true;
+    return false;
+}
+
+void RenderSession::adoptPrepared(double newSampleRate, int newBlockSize)
+{
+    release();
+
+    sampleRate = newSampleRate;
+    blockSize = newBlockSize;
+    plugin.setNonRealtime(true);
+
+    numChannels = juce::jmax(1, plugin.getTotalNumInputChannels(), plugin.getTotalNumOutputChannels());
+    buffer.setSize(numChannels, blockSize);
+
+    prepared = true;
+}
+
+void RenderSession::resetForNextRender()
+{
+    if (!prepared)
+        return;
+
+    ScopedPhaseTimer timer(RenderPhase::Prepare);
+
+    // Let the plugin see the panic messages before its state is reset,
+    // some synths only kill releasing voices on CC 120
+    scratchMidi.clear();
+    scratchMidi.addEvents(panicMidi, 0, -1, 0);
+    buffer.clear();
+    plugin.processBlock(buffer, scratchMidi);
+
+    plugin.reset();
+}
+
+void RenderSession::processSplitAtEvents(juce::AudioBuffer<float>& block, const juce::MidiBuffer& midi)
+{
+    const int numSamples = block.getNumSamples();
+    auto event = midi.cbegin();
+    int segmentStart = 0;
+
+    while (segmentStart < numSamples)
+    {
+        // Events at (or, if out of order, before) the segment start open it
+        scratchMidi.clear();
+        while (event != midi.cend() && (*event).samplePosition <= segmentStart)
+        {
+            const auto metadata = *event;
+            scratchMidi.addEvent(metadata.data, metadata.numBytes, 0);
+            ++event;
+        }
+
+        int segmentEnd = event != midi.cend() ? juce::jmin(numSamples, (*event).samplePosition) : numSamples;
+
+        // View onto the block, no copy or allocation
+        juce::AudioBuffer<float> segment(block.getArrayOfWritePointers(), block.getNumChannels(),
+                                         segmentStart, segmentEnd - segmentStart);
+        plugin.processBlock(segment, scratchMidi);
+
+        segmentStart = segmentEnd;
+    }
+}
+
+void RenderSession::captureWarmupSnapshot(const Hash128& key, int64 warmupSamples)
+{
+    snapshotState.reset();
+    plugin.getStateInformation(snapshotState);
+
+    snapshotKey = key;
+    snapshotWarmupSamples = warmupSamples;
+    snapshotValid = prepared && snapshotState.getSize() > 0;
+}
+
+bool RenderSession::restoreWarmupSnapshot(const Hash128& key, int64 warmupSamples)
+{
+    if (!snapshotValid || key != snapshotKey || warmupSamples != snapshotWarmupSamples)
+        return false;
+
+    plugin.setStateInformation(snapshotState.getData(), static_cast<int>(snapshotState.getSize()));
+    plugin.reset();
+    return true;
+}
+
+void RenderSession::release()
+{
+    // A snapshot belongs to one sample rate and block size
+    snapshotValid = false;
+
+    if (!prepared)
+        return;
+
+    plugin.releaseResources();
+    prepared = false;
+}
+
+} // namespace serum
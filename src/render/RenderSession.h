@@ -0,0 +1,122 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "common/Hash.h"
+
+namespace serum {
+
+/**
+ * Persistent render context for one plugin instance
+ * Prepares the plugin once and keeps it and the block buffers alive across
+ * renders; between renders only voices and DSP state are reset.
+ */
+class RenderSession
+{
+public:
+    /**
+     * Constructor
+     * @param plugin Plugin instance, must outlive the session
+     */
+    explicit RenderSession(juce::AudioPluginInstance& plugin);
+
+    /**
+     * Releases the plugin if still prepared
+     */
+    ~RenderSession();
+
+    /**
+     * Prepare the plugin for playback
+     * No-op if already prepared with the same sample rate and block size
+     * @param sampleRate Sample rate
+     * @param blockSize Maximum block size
+     * @return true if the plugin was already prepared (and only needs a reset)
+     */
+    bool prepare(double sampleRate, int blockSize);
+
+    /**
+     * Take over a plugin that is already prepared, e.g. by PluginInstancePool
+     * The next prepare() with the same settings is then a no-op.
+     * @param sampleRate Sample rate the plugin was prepared with
+     * @param blockSize Block size the plugin was prepared with
+     */
+    void adoptPrepared(double sampleRate, int blockSize);
+
+    /**
+     * Silence every voice and reset DSP state before the next render
+     * Sends reset-all-controllers, a centred pitch wheel and all-notes-off /
+     * all-sound-off on every channel, then reset()
+     */
+    void resetForNextRender();
+
+    /**
+     * Process one block, split at the sample position of every MIDI event
+     * Each sub-block receives its events at offset 0, so plugins that only
+     * apply events at block starts stay sample accurate. Never allocates.
+     * @param block Block of at most the prepared block size
+     * @param midi Events of the block
+     */
+    void processSplitAtEvents(juce::AudioBuffer<float>& block, const juce::MidiBuffer& midi);
+
+    /**
+     * Release plugin resources
+     */
+    void release();
+
+    /**
+     * Keep the plugin state reached after a warmup for later renders
+     * @param key Identifies the preset state the warmup started from
+     * @param warmupSamples Length of that warmup
+     */
+    void captureWarmupSnapshot(const Hash128& key, int64 warmupSamples);
+
+    /**
+     * Restore a snapshot instead of running the warmup again
+     * Applies the captured state and resets the plugin's DSP
+     * @return true if a snapshot for key and warmupSamples was restored
+     */
+    bool restoreWarmupSnapshot(const Hash128& key, int64 warmupSamples);
+
+    /**
+     * Forget the warmup snapshot
+     */
+    void clearWarmupSnapshot() { snapshotValid = false; }
+
+    bool isPrepared() const { return prepared; }
+    double getSampleRate() const { return sampleRate; }
+    int getBlockSize() const { return blockSize; }
+    int getNumChannels() const { return numChannels; }
+
+    juce::AudioPluginInstance& getPlugin() { return plugin; }
+
+    /**
+     * Block buffer sized at prepare(), reused by every render
+     */
+    juce::AudioBuffer<float>& getBuffer() { return buffer; }
+
+    /**
+     * Pre-reserved MIDI buffer for the render loop
+     */
+    juce::MidiBuffer& getMidiBuffer() { return midiBuffer; }
+
+private:
+    juce::AudioPluginInstance& plugin;
+    bool prepared = false;
+    double sampleRate = 0.0;
+    int blockSize = 0;
+    int numChannels = 2;
+
+    juce::AudioBuffer<float> buffer;
+    juce::MidiBuffer midiBuffer;
+    juce::MidiBuffer panicMidi;
+    juce::MidiBuffer scratchMidi;  // Plugins may modify the buffer they are given; also holds sub-block events
+
+    // Post-warmup state; only valid for the current prepare()
+    juce::MemoryBlock snapshotState;
+    Hash128 snapshotKey;
+    int64 snapshotWarmupSamples = 0;
+    bool snapshotValid = false;
+
+    JUCE_DECLARE_NON_COPYABLE(RenderSession)
+};
+
+} // namespace serum
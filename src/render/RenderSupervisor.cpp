@@ -0,0 +1,683 @@
+#include "render/RenderSupervisor.h"
+#include "render/RenderWorkerProcess.h"
+#include "common/Log.h"
+#include "common/Paths.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <csignal>
+ #include <sys/types.h>
+#endif
+
+namespace serum {
+
+// Time granted to workers to exit after being told to quit
+static constexpr double quitTimeoutSec = 5.0;
+
+static double getSeconds()
+{
+    return juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks());
+}
+
+// A hung worker may never read the quit message; end it from outside
+static void killProcess(int processId)
+{
+    if (processId <= 0)
+        return;
+
+#if JUCE_WINDOWS
+    if (auto handle = OpenProcess(PROCESS_TERMINATE, FALSE, static_cast<DWORD>(processId)))
+    {
+        TerminateProcess(handle, 1);
+        CloseHandle(handle);
+    }
+#else
+    ::kill(static_cast<pid_t>(processId), SIGKILL);
+#endif
+}
+
+void RenderSupervisor::WorkerConnection::handleMessageFromWorker(const juce::MemoryBlock& block)
+{
+    auto message = decodeWorkerMessage(block);
+    auto type = message["type"].toString();
+
+    Event event;
+    event.slot = slot;
+    event.generation = generation;
+
+    if (type == "started")
+    {
+        event.type = Event::Type::Started;
+        event.processId = message["processId"];
+    }
+    else if (type == "ready")
+    {
+        event.type = Event::Type::Ready;
+    }
+    else if (type == "result")
+    {
+        event.type = Event::Type::Result;
+        event.index = static_cast<int64>(message["index"]);
+        event.ok = message["ok"];
+    }
+    else if (type == "error")
+    {
+        event.type = Event::Type::Error;
+        event.message = message["message"].toString();
+    }
+    else
+    {
+        return;
+    }
+
+    owner.postEvent(event);
+}
+
+void RenderSupervisor::WorkerConnection::handleConnectionLost()
+{
+    Event event;
+    event.type = Event::Type::Lost;
+    event.slot = slot;
+    event.generation = generation;
+    owner.postEvent(event);
+}
+
+RenderSupervisor::RenderSupervisor(const juce::PluginDescription& desc, const RenderSupervisorOptions& options)
+    : desc(desc)
+    , options(options)
+{
+}
+
+RenderSupervisor::~RenderSupervisor()
+{
+    stopWorkers();
+    finishConsumers();
+}
+
+juce::File RenderSupervisor::getDefaultQuarantineFile()
+{
+    return getOutputMetaDir().getChildFile("quarantine.jsonl");
+}
+
+bool RenderSupervisor::run(const juce::File& file, RenderSupervisorSummary& outSummary)
+{
+    outSummary = RenderSupervisorSummary();
+    summary = RenderSupervisorSummary();
+    manifestFile = file;
+    nextIndex = 0;
+    manifestExhausted = false;
+    retries.clear();
+
+    juce::String errorMsg;
+    if (!manifest.open(manifestFile, errorMsg))
+        return false;
+
+    loadQuarantine();
+    if (options.logDirectory != juce::File())
+        ensureDirectoryExists(options.logDirectory);
+
+    int numWorkers = juce::jmax(1, options.numWorkers);
+    logInfo("Starting render supervisor with " + juce::String(numWorkers) + " worker processes");
+    auto startTime = getSeconds();
+
+    slots.clear();
+    slots.resize(static_cast<size_t>(numWorkers));
+    if (!startConsumers())
+    {
+        slots.clear();
+        return false;
+    }
+
+    for (int i = 0; i < numWorkers; ++i)
+        launch(i);
+
+    int64 lastReported = 0;
+    auto lastReportTime = startTime;
+
+    for (;;)
+    {
+        std::deque<Event> pending;
+        {
+            std::lock_guard<std::mutex> lock(eventsMutex);
+            pending.swap(events);
+        }
+
+        for (const auto& event : pending)
+            handleEvent(event);
+
+        auto now = getSeconds();
+        bool anyActive = false;
+        bool anyAlive = false;
+
+        for (int i = 0; i < numWorkers; ++i)
+        {
+            auto& slot = slots[static_cast<size_t>(i)];
+
+            if (slot.state == SlotState::Starting && now > slot.deadline)
+            {
+                logError("Worker " + juce::String(i) + " did not start within "
+                         + juce::String(options.startupTimeoutSec, 0) + "s");
+                ++slot.launchFailures;
+                restart(i, "startup timeout", true);
+            }
+            else if (slot.state == SlotState::Busy && now > slot.deadline)
+            {
+                logError("Worker " + juce::String(i) + " timed out rendering "
+                         + slot.job.job.outputFile.getFullPathName());
+                ++summary.workerTimeouts;
+                restart(i, "timeout", true);
+            }
+
+            if (slot.state == SlotState::Idle)
+                dispatch(i);
+
+            anyActive = anyActive || slot.state == SlotState::Starting || slot.state == SlotState::Busy;
+            anyAlive = anyAlive || slot.state != SlotState::Dead;
+        }
+
+        if (!anyActive)
+        {
+            // Idle workers took every job there was
+            if (anyAlive)
+                break;
+
+            logError("No render workers left, failing the remaining jobs");
+            PendingJob job;
+            while (takeNextJob(job))
+                ++summary.jobsFailed;
+            break;
+        }
+
+        int64 finished = summary.jobsCompleted + summary.jobsFailed + summary.jobsQuarantined;
+        if (now - lastReportTime >= 5.0)
+        {
+            if (finished != lastReported)
+                logInfo("Render supervisor progress: " + juce::String(finished) + " jobs finished");
+
+            lastReported = finished;
+            lastReportTime = now;
+        }
+
+        eventPosted.wait(20);
+    }
+
+    stopWorkers();
+    finishConsumers();
+
+    summary.wallSeconds = getSeconds() - startTime;
+    outSummary = summary;
+
+    double rendersPerSec = summary.wallSeconds > 0.0
+        ? static_cast<double>(summary.jobsCompleted) / summary.wallSeconds
+        : 0.0;
+
+    logInfo("Render supervisor finished: " + juce::String(summary.jobsCompleted) + " completed, "
+            + juce::String(summary.jobsFailed) + " failed, "
+            + juce::String(summary.jobsQuarantined) + " quarantined, "
+            + juce::String(summary.jobsSkipped) + " skipped as quarantined, "
+            + juce::String(summary.jobsRetried) + " retried");
+    logInfo("Workers: " + juce::String(summary.workersLaunched) + " launched, "
+            + juce::String(summary.workerCrashes) + " crashed, "
+            + juce::String(summary.workerTimeouts) + " timed out");
+    logInfo("Wall time: " + juce::String(summary.wallSeconds, 2) + "s ("
+            + juce::String(rendersPerSec, 2) + " renders/s)");
+
+    if (manifest.getNumInvalidLines() > 0)
+        logError("Skipped " + juce::String(manifest.getNumInvalidLines()) + " invalid manifest lines");
+
+    return summary.jobsFailed == 0 && summary.jobsQuarantined == 0 && manifest.getNumInvalidLines() == 0;
+}
+
+void RenderSupervisor::postEvent(const Event& event)
+{
+    {
+        std::lock_guard<std::mutex> lock(eventsMutex);
+        events.push_back(event);
+    }
+    eventPosted.signal();
+}
+
+void RenderSupervisor::handleEvent(const Event& event)
+{
+    if (event.slot < 0 || event.slot >= static_cast<int>(slots.size()))
+        return;
+
+    auto& slot = slots[static_cast<size_t>(event.slot)];
+
+    // Late messages from a worker that has since been replaced
+    if (event.generation != slot.generation || slot.connection == nullptr)
+        return;
+
+    switch (event.type)
+    {
+        case Event::Type::Started:
+            slot.processId = event.processId;
+            break;
+
+        case Event::Type::Ready:
+            if (slot.state == SlotState::Starting)
+            {
+                slot.state = SlotState::Idle;
+                slot.launchFailures = 0;
+            }
+            break;
+
+        case Event::Type::Result:
+            if (slot.state == SlotState::Busy && event.index == slot.job.index)
+            {
+                if (event.ok)
+                    ++summary.jobsCompleted;
+                else
+                    ++summary.jobsFailed;
+
+                slot.state = SlotState::Idle;
+            }
+            break;
+
+        case Event::Type::Error:
+            logError("Worker " + juce::String(event.slot) + ": " + event.message);
+            if (slot.state == SlotState::Starting)
+                ++slot.launchFailures;
+            restart(event.slot, "error", false);
+            break;
+
+        case Event::Type::Lost:
+            if (slot.state == SlotState::Starting)
+            {
+                logError("Worker " + juce::String(event.slot) + " exited during startup");
+                ++slot.launchFailures;
+            }
+            else if (slot.state == SlotState::Busy)
+            {
+                logError("Worker " + juce::String(event.slot) + " crashed rendering "
+                         + slot.job.job.outputFile.getFullPathName());
+                ++summary.workerCrashes;
+            }
+            else
+            {
+                logWarning("Worker " + juce::String(event.slot) + " exited unexpectedly");
+                ++summary.workerCrashes;
+            }
+
+            restart(event.slot, "crash", false);
+            break;
+    }
+}
+
+bool RenderSupervisor::launch(int slotIndex)
+{
+    auto& slot = slots[static_cast<size_t>(slotIndex)];
+    auto executable = juce::File::getSpecialLocation(juce::File::currentExecutableFile);
+
+    auto* config = new juce::DynamicObject();
+    juce::var configVar(config);
+    config->setProperty("type", "config");
+    config->setProperty("workerIndex", slotIndex);
+    config->setProperty("plugin", desc.createXml()->toString());
+    config->setProperty("manifest", manifestFile.getFullPathName());
+    config->setProperty("blockSize", options.blockSize);
+    config->setProperty("cacheDirectory", options.cacheDirectory == juce::File()
+                                              ? juce::String()
+                                              : options.cacheDirectory.getFullPathName());
+    config->setProperty("logLevel", static_cast<int>(getLogLevel()));
+    config->setProperty("logJson", options.logJson);
+    if (slot.ring != nullptr)
+        config->setProperty("shmRing", slot.ring->getName());
+    if (options.logDirectory != juce::File())
+        config->setProperty("logFile", options.logDirectory
+                                           .getChildFile("worker_" + juce::String(slotIndex) + ".log")
+                                           .getFullPathName());
+
+    while (slot.launchFailures < options.maxLaunchFailures)
+    {
+        ++slot.generation;
+        slot.processId = 0;
+        slot.connection = std::make_unique<WorkerConnection>(*this, slotIndex, slot.generation);
+
+        // No stdout/stderr pipes: nobody would read them, and a full pipe
+        // would stall the worker. Workers log to their own file instead.
+        if (slot.connection->launchWorkerProcess(executable, renderWorkerProcessId, 0, 0)
+            && slot.connection->sendMessageToWorker(encodeWorkerMessage(configVar)))
+        {
+            ++summary.workersLaunched;
+            slot.state = SlotState::Starting;
+            slot.deadline = getSeconds() + options.startupTimeoutSec;
+            return true;
+        }
+
+        logError("Failed to launch worker " + juce::String(slotIndex));
+        slot.connection.reset();
+        ++slot.launchFailures;
+    }
+
+    logError("Giving up on worker " + juce::String(slotIndex) + " after "
+             + juce::String(slot.launchFailures) + " failed launches");
+    slot.state = SlotState::Dead;
+    return false;
+}
+
+void RenderSupervisor::restart(int slotIndex, const juce::String& reason, bool hung)
+{
+    auto& slot = slots[static_cast<size_t>(slotIndex)];
+
+    if (slot.state == SlotState::Busy)
+        jobKilledWorker(slot.job, reason);
+
+    terminate(slot, hung);
+    launch(slotIndex);
+}
+
+void RenderSupervisor::terminate(Slot& slot, bool hung)
+{
+    slot.connection.reset();
+    if (hung)
+        killProcess(slot.processId);
+
+    slot.processId = 0;
+    slot.state = SlotState::Dead;
+}
+
+void RenderSupervisor::stopWorkers()
+{
+    auto quit = new juce::DynamicObject();
+    juce::var quitVar(quit);
+    quit->setProperty("type", "quit");
+
+    for (auto& slot : slots)
+    {
+        if (slot.connection != nullptr && slot.state != SlotState::Dead)
+            slot.connection->sendMessageToWorker(encodeWorkerMessage(quitVar));
+    }
+
+    // Let the workers finish their logs and exit on their own
+    auto deadline = getSeconds() + quitTimeoutSec;
+    std::vector<bool> exited(slots.size(), false);
+
+    while (getSeconds() < deadline)
+    {
+        {
+            std::lock_guard<std::mutex> lock(eventsMutex);
+            for (const auto& event : events)
+            {
+                if (event.type == Event::Type::Lost
+                    && event.generation == slots[static_cast<size_t>(event.slot)].generation)
+                    exited[static_cast<size_t>(event.slot)] = true;
+            }
+            events.clear();
+        }
+
+        bool allExited = true;
+        for (size_t i = 0; i < slots.size(); ++i)
+            allExited = allExited && (exited[i] || slots[i].connection == nullptr);
+
+        if (allExited)
+            break;
+
+        eventPosted.wait(20);
+    }
+
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        if (slots[i].connection != nullptr)
+            terminate(slots[i], !exited[i]);
+    }
+}
+
+bool RenderSupervisor::startConsumers()
+{
+    stopConsumers = false;
+    if (options.shardDirectory == juce::File())
+        return true;
+
+    if (!ShmAudioRing::isSupported())
+    {
+        logError("Shard output in supervisor mode needs shared memory, which this platform lacks");
+        return false;
+    }
+
+    for (size_t i = 0; i < slots.size(); ++i)
+    {
+        auto& slot = slots[i];
+
+        juce::String errorMsg;
+        slot.ring = ShmAudioRing::create(ShmAudioRing::makeUniqueName("w" + juce::String(static_cast<int>(i))),
+                                         options.ringSlots, options.ringChannels, options.ringBlockSize, errorMsg);
+        if (slot.ring == nullptr)
+        {
+            logError("Failed to create audio ring: " + errorMsg);
+            finishConsumers();
+            return false;
+        }
+
+        slot.shardWriter = std::make_unique<ShardWriter>(
+            options.shardDirectory, "w" + juce::String(static_cast<int>(i)).paddedLeft('0', 2),
+            options.maxShardBytes, options.ringChannels, options.ringBlockSize);
+        slot.consumer = std::thread([this, &slot] { consumeRing(slot); });
+    }
+
+    logInfo("Streaming renders through " + juce::String(static_cast<int>(slots.size())) + " shared-memory rings of "
+            + juce::String(static_cast<double>(slots.front().ring->getMappedBytes()) / (1024.0 * 1024.0), 1) + " MB");
+    return true;
+}
+
+void RenderSupervisor::finishConsumers()
+{
+    // Workers are gone; consumers drain what is left in their rings and stop
+    stopConsumers = true;
+
+    for (auto& slot : slots)
+    {
+        if (slot.consumer.joinable())
+            slot.consumer.join();
+
+        slot.shardWriter.reset();
+        slot.ring.reset();
+    }
+}
+
+void RenderSupervisor::consumeRing(Slot& slot)
+{
+    auto& ring = *slot.ring;
+    auto& writer = *slot.shardWriter;
+
+    ShmMessage message;
+    uint64 renderId = 0;
+    bool recordOpen = false;
+    bool recordEnded = false;
+
+    for (;;)
+    {
+        if (!ring.read(message, 50))
+        {
+            if (stopConsumers)
+                break;
+
+            continue;
+        }
+
+        const auto& header = *message.header;
+        switch (header.type)
+        {
+            case ShmMessageType::Begin:
+                // Abandons a record left open by a worker that died mid-render
+                renderId = header.renderId;
+                recordOpen = writer.beginRecord(header.key, header.sampleRate,
+                                                static_cast<int>(header.outputChannels));
+                recordEnded = false;
+                break;
+
+            case ShmMessageType::Block:
+                if (recordOpen && header.renderId == renderId && !writer.writeBlock(message.audio))
+                    recordOpen = false;
+                break;
+
+            case ShmMessageType::End:
+                recordEnded = recordOpen && header.renderId == renderId;
+                break;
+
+            case ShmMessageType::Metadata:
+                // Only a render that finished and was published reaches the index
+                if (recordEnded && header.renderId == renderId && writer.endRecord())
+                    writer.appendMetadata(juce::JSON::parse(juce::String::fromUTF8(message.payload)));
+
+                recordOpen = recordEnded = false;
+                break;
+        }
+
+        ring.release();
+    }
+
+    writer.close();
+}
+
+bool RenderSupervisor::dispatch(int slotIndex)
+{
+    auto& slot = slots[static_cast<size_t>(slotIndex)];
+
+    PendingJob job;
+    if (!takeNextJob(job))
+        return false;
+
+    auto* message = new juce::DynamicObject();
+    juce::var messageVar(message);
+    message->setProperty("type", "job");
+    message->setProperty("index", job.index);
+
+    if (!slot.connection->sendMessageToWorker(encodeWorkerMessage(messageVar)))
+    {
+        // Not the job's fault; it goes to the next worker untouched
+        retries.push_front(std::move(job));
+        ++summary.workerCrashes;
+        restart(slotIndex, "lost connection", false);
+        return false;
+    }
+
+    slot.deadline = getSeconds() + getJobTimeout(job.job);
+    slot.job = std::move(job);
+    slot.state = SlotState::Busy;
+    return true;
+}
+
+bool RenderSupervisor::takeNextJob(PendingJob& job)
+{
+    if (!retries.empty())
+    {
+        job = std::move(retries.front());
+        retries.pop_front();
+        return true;
+    }
+
+    while (!manifestExhausted)
+    {
+        RenderJob next;
+        if (!manifest.next(next))
+        {
+            manifestExhausted = true;
+            break;
+        }
+
+        // Indices count every job, so they match the workers' own manifests
+        int64 index = nextIndex++;
+
+        if (quarantinedOutputs.count(next.outputFile.getFullPathName()) > 0)
+        {
+            logWarning("Skipping quarantined job: " + next.outputFile.getFullPathName());
+            ++summary.jobsSkipped;
+            continue;
+        }
+
+        job.index = index;
+        job.job = std::move(next);
+        job.attempts = 0;
+        return true;
+    }
+
+    return false;
+}
+
+double RenderSupervisor::getJobTimeout(const RenderJob& job) const
+{
+    if (options.jobTimeoutSec > 0.0)
+        return options.jobTimeoutSec;
+
+    const auto& settings = job.settings;
+    double audioSec = settings.warmupSec + settings.renderSec + settings.tailSec;
+
+    // Verify mode renders every job twice
+    if (settings.warmupMode == WarmupMode::Verify)
+        audioSec *= 2.0;
+
+    return options.minJobTimeoutSec + options.timeoutPerAudioSec * audioSec;
+}
+
+void RenderSupervisor::jobKilledWorker(const PendingJob& job, const juce::String& reason)
+{
+    auto retry = job;
+    ++retry.attempts;
+
+    if (retry.attempts >= options.maxAttempts)
+    {
+        quarantine(retry, reason);
+        return;
+    }
+
+    // A crash can be left over from an earlier job, so give it a fresh worker
+    logWarning("Retrying " + job.job.outputFile.getFullPathName() + " after worker " + reason);
+    ++summary.jobsRetried;
+    retries.push_back(std::move(retry));
+}
+
+void RenderSupervisor::loadQuarantine()
+{
+    quarantinedOutputs.clear();
+    if (options.quarantineFile == juce::File() || !options.quarantineFile.existsAsFile())
+        return;
+
+    juce::StringArray lines;
+    options.quarantineFile.readLines(lines);
+
+    for (const auto& line : lines)
+    {
+        auto output = juce::JSON::parse(line)["output"].toString();
+        if (output.isNotEmpty())
+            quarantinedOutputs.insert(output);
+    }
+
+    if (!quarantinedOutputs.empty())
+        logInfo(juce::String(static_cast<int>(quarantinedOutputs.size())) + " quarantined jobs listed in "
+                + options.quarantineFile.getFullPathName());
+}
+
+void RenderSupervisor::quarantine(const PendingJob& job, const juce::String& reason)
+{
+    const auto& renderJob = job.job;
+    logError("Quarantining " + renderJob.outputFile.getFullPathName() + " (" + reason + ", "
+             + juce::String(job.attempts) + " attempts)");
+    ++summary.jobsQuarantined;
+    quarantinedOutputs.insert(renderJob.outputFile.getFullPathName());
+
+    if (options.quarantineFile == juce::File())
+        return;
+
+    auto* record = new juce::DynamicObject();
+    juce::var recordVar(record);
+    record->setProperty("output", renderJob.outputFile.getFullPathName());
+    record->setProperty("preset", renderJob.presetStateFile == juce::File()
+                                      ? juce::String()
+                                      : renderJob.presetStateFile.getFullPathName());
+    record->setProperty("note", renderJob.noteName);
+    record->setProperty("velocity", renderJob.velocity);
+    record->setProperty("reason", reason);
+    record->setProperty("attempts", job.attempts);
+    record->setProperty("time", juce::Time::getCurrentTime().toISO8601(true));
+
+    ensureDirectoryExists(options.quarantineFile.getParentDirectory());
+    if (!options.quarantineFile.appendText(juce::JSON::toString(recordVar, true) + "\n"))
+        logError("Failed to write quarantine list: " + options.quarantineFile.getFullPathName());
+}
+
+} // namespace serum
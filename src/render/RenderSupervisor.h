@@ -0,0 +1,220 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "render/RenderJob.h"
+#include "render/RenderManifest.h"
+#include "render/ShardWriter.h"
+#include "render/ShmAudioRing.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+namespace serum {
+
+/**
+ * Options for supervisor mode
+ */
+struct RenderSupervisorOptions
+{
+    int numWorkers = 1;        // Worker processes
+    int blockSize = 0;         // Overrides every job's blockSize when positive
+    juce::File cacheDirectory; // Shared render cache, empty to disable
+
+    // Per-job deadline; when zero it is minJobTimeoutSec plus
+    // timeoutPerAudioSec for every second of audio the job renders
+    double jobTimeoutSec = 0.0;
+    double minJobTimeoutSec = 30.0;
+    double timeoutPerAudioSec = 20.0;
+    double startupTimeoutSec = 60.0;   // Launch until the plugin is created
+
+    int maxAttempts = 2;        // Crashes or timeouts before a job is quarantined
+    int maxLaunchFailures = 3;  // Consecutive failed launches before a slot is given up
+
+    // When set, workers stream their renders through shared-memory rings
+    // (ShmAudioRing) and the supervisor appends them to shards here
+    juce::File shardDirectory;
+    int64 maxShardBytes = 1024 * 1024 * 1024;
+    int ringSlots = 32;
+    int ringChannels = 8;
+    int ringBlockSize = 4096;
+
+    // Quarantined jobs are appended here as JSONL; jobs already listed are skipped
+    juce::File quarantineFile;
+
+    // Worker logs go to worker_<n>.log here; discarded when unset
+    juce::File logDirectory;
+    bool logJson = false;
+};
+
+/**
+ * Totals reported after a supervised run
+ */
+struct RenderSupervisorSummary
+{
+    int64 jobsCompleted = 0;
+    int64 jobsFailed = 0;        // Renders that failed inside a healthy worker
+    int64 jobsRetried = 0;       // Requeued after their worker crashed or hung
+    int64 jobsQuarantined = 0;   // Gave up on this run
+    int64 jobsSkipped = 0;       // Quarantined by an earlier run
+    int64 workerCrashes = 0;
+    int64 workerTimeouts = 0;
+    int64 workersLaunched = 0;
+    double wallSeconds = 0.0;
+};
+
+/**
+ * Renders a manifest in sandboxed worker processes (RenderWorkerProcess)
+ *
+ * Each worker process hosts its own plugin instance; the supervisor hands out
+ * one job at a time by its index in the manifest and waits for the result. A
+ * worker that crashes or misses the job's deadline is killed and replaced,
+ * and its job is retried on the new worker. A job that keeps taking workers
+ * down is quarantined, so faulty presets cost a restart each instead of the
+ * whole sweep.
+ *
+ * With a shard directory, workers stream audio and metadata through one
+ * shared-memory ring each and a consumer thread per ring appends the records
+ * to that slot's shards; a record is only committed once its metadata
+ * arrives, so renders cut short by a crash never reach the index.
+ *
+ * Runs on the message thread; the supervisor never loads the plugin.
+ */
+class RenderSupervisor
+{
+public:
+    /**
+     * Constructor
+     * @param desc Plugin every worker instantiates
+     * @param options Supervisor options
+     */
+    RenderSupervisor(const juce::PluginDescription& desc, const RenderSupervisorOptions& options);
+    ~RenderSupervisor();
+
+    /**
+     * Render every job of a manifest, blocking until done
+     * @param manifestFile JSONL manifest, streamed by the supervisor and every worker
+     * @param outSummary Output totals
+     * @return true if every job rendered successfully
+     */
+    bool run(const juce::File& manifestFile, RenderSupervisorSummary& outSummary);
+
+    /**
+     * Default quarantine list (data/outmeta/quarantine.jsonl)
+     */
+    static juce::File getDefaultQuarantineFile();
+
+private:
+    struct Event
+    {
+        enum class Type
+        {
+            Started,
+            Ready,
+            Result,
+            Error,
+            Lost
+        };
+
+        Type type = Type::Lost;
+        int slot = 0;
+        int generation = 0;
+        int64 index = -1;
+        bool ok = false;
+        int processId = 0;
+        juce::String message;
+    };
+
+    /**
+     * Connection to one worker process; forwards everything as events
+     */
+    class WorkerConnection : public juce::ChildProcessCoordinator
+    {
+    public:
+        WorkerConnection(RenderSupervisor& owner, int slot, int generation)
+            : owner(owner), slot(slot), generation(generation) {}
+
+        ~WorkerConnection() override { killWorkerProcess(); }
+
+        void handleMessageFromWorker(const juce::MemoryBlock& message) override;
+        void handleConnectionLost() override;
+
+    private:
+        RenderSupervisor& owner;
+        const int slot;
+        const int generation;
+    };
+
+    struct PendingJob
+    {
+        int64 index = -1;
+        RenderJob job;
+        int attempts = 0;
+    };
+
+    enum class SlotState
+    {
+        Starting,
+        Idle,
+        Busy,
+        Dead
+    };
+
+    struct Slot
+    {
+        std::unique_ptr<WorkerConnection> connection;
+        int generation = 0;
+        SlotState state = SlotState::Dead;
+        PendingJob job;         // In flight while Busy
+        double deadline = 0.0;  // Startup or job deadline, in seconds
+        int launchFailures = 0;
+        int processId = 0;      // Reported by the worker as it starts
+
+        // Shard output: survives worker restarts
+        std::unique_ptr<ShmAudioRing> ring;
+        std::unique_ptr<ShardWriter> shardWriter;
+        std::thread consumer;
+    };
+
+    juce::PluginDescription desc;
+    RenderSupervisorOptions options;
+    juce::File manifestFile;
+
+    std::vector<Slot> slots;
+    RenderManifest manifest;
+    int64 nextIndex = 0;
+    bool manifestExhausted = false;
+    std::deque<PendingJob> retries;
+    std::set<juce::String> quarantinedOutputs;
+    RenderSupervisorSummary summary;
+
+    std::atomic<bool> stopConsumers { false };
+
+    std::mutex eventsMutex;
+    std::deque<Event> events;
+    juce::WaitableEvent eventPosted;
+
+    void postEvent(const Event& event);
+    void handleEvent(const Event& event);
+
+    bool launch(int slotIndex);
+    void restart(int slotIndex, const juce::String& reason, bool hung);
+    void terminate(Slot& slot, bool hung);
+    void stopWorkers();
+    bool dispatch(int slotIndex);
+    bool takeNextJob(PendingJob& job);
+    double getJobTimeout(const RenderJob& job) const;
+    void jobKilledWorker(const PendingJob& job, const juce::String& reason);
+
+    bool startConsumers();
+    void finishConsumers();
+    void consumeRing(Slot& slot);
+
+    void loadQuarantine();
+    void quarantine(const PendingJob& job, const juce::String& reason);
+};
+
+} // namespace serum
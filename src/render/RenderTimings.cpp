@@ -0,0 +1,214 @@
+#include "render/RenderTimings.h"
+#include "common/Log.h"
+#include "common/Paths.h"
+#include <cmath>
+
+namespace serum {
+
+const char* getRenderPhaseName(RenderPhase phase)
+{
+    switch (phase)
+    {
+        case RenderPhase::Prepare:    return "prepare";
+        case RenderPhase::StateLoad:  return "stateLoad";
+        case RenderPhase::Warmup:     return "warmup";
+        case RenderPhase::MainRender: return "mainRender";
+        case RenderPhase::Tail:       return "tail";
+        case RenderPhase::Stats:      return "stats";
+        case RenderPhase::Write:      return "write";
+        case RenderPhase::Close:      return "close";
+        case RenderPhase::NumPhases:  break;
+    }
+
+    return "unknown";
+}
+
+void PhaseTimings::add(const PhaseTimings& other)
+{
+    for (size_t i = 0; i < seconds.size(); ++i)
+    {
+        seconds[i] += other.seconds[i];
+        calls[i] += other.calls[i];
+    }
+}
+
+void PhaseTimings::scale(double factor)
+{
+    for (auto& phaseSeconds : seconds)
+        phaseSeconds *= factor;
+}
+
+double PhaseTimings::getTotalSeconds() const
+{
+    double total = 0.0;
+    for (double phaseSeconds : seconds)
+        total += phaseSeconds;
+    return total;
+}
+
+juce::var PhaseTimings::toVar() const
+{
+    auto* object = new juce::DynamicObject();
+    juce::var result(object);
+
+    for (int i = 0; i < numRenderPhases; ++i)
+    {
+        if (calls[static_cast<size_t>(i)] > 0)
+            object->setProperty(juce::String(getRenderPhaseName(static_cast<RenderPhase>(i))) + "Ms",
+                                seconds[static_cast<size_t>(i)] * 1000.0);
+    }
+
+    object->setProperty("totalMs", getTotalSeconds() * 1000.0);
+    return result;
+}
+
+PhaseTimings& getThreadPhaseTimings()
+{
+    static thread_local PhaseTimings timings;
+    return timings;
+}
+
+void PhaseHistogram::add(double seconds)
+{
+    double micros = seconds * 1.0e6;
+    int bucket = micros < 1.0 ? 0 : static_cast<int>(std::floor(std::log2(micros))) + 1;
+    ++counts[static_cast<size_t>(juce::jlimit(0, numBuckets - 1, bucket))];
+
+    ++renders;
+    totalSeconds += seconds;
+    maxSeconds = juce::jmax(maxSeconds, seconds);
+}
+
+void PhaseHistogram::merge(const PhaseHistogram& other)
+{
+    for (size_t i = 0; i < counts.size(); ++i)
+        counts[i] += other.counts[i];
+
+    renders += other.renders;
+    totalSeconds += other.totalSeconds;
+    maxSeconds = juce::jmax(maxSeconds, other.maxSeconds);
+}
+
+double PhaseHistogram::getQuantileSeconds(double quantile) const
+{
+    if (renders == 0)
+        return 0.0;
+
+    auto target = static_cast<int64>(std::ceil(quantile * static_cast<double>(renders)));
+    int64 seen = 0;
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        seen += counts[static_cast<size_t>(i)];
+        if (seen >= juce::jmax<int64>(1, target))
+            return juce::jmin(maxSeconds, std::ldexp(1.0e-6, i));
+    }
+
+    return maxSeconds;
+}
+
+juce::var PhaseHistogram::toVar() const
+{
+    auto* object = new juce::DynamicObject();
+    juce::var result(object);
+
+    object->setProperty("renders", renders);
+    object->setProperty("totalSec", totalSeconds);
+    object->setProperty("meanMs", renders > 0 ? totalSeconds * 1000.0 / static_cast<double>(renders) : 0.0);
+    object->setProperty("p50Ms", getQuantileSeconds(0.5) * 1000.0);
+    object->setProperty("p90Ms", getQuantileSeconds(0.9) * 1000.0);
+    object->setProperty("p99Ms", getQuantileSeconds(0.99) * 1000.0);
+    object->setProperty("maxMs", maxSeconds * 1000.0);
+
+    // Non-empty buckets only, as upper bounds
+    juce::Array<juce::var> buckets;
+    for (int i = 0; i < numBuckets; ++i)
+    {
+        if (counts[static_cast<size_t>(i)] == 0)
+            continue;
+
+        auto* bucket = new juce::DynamicObject();
+        bucket->setProperty("belowMs", std::ldexp(1.0e-3, i));
+        bucket->setProperty("count", counts[static_cast<size_t>(i)]);
+        buckets.add(juce::var(bucket));
+    }
+    object->setProperty("buckets", buckets);
+
+    return result;
+}
+
+void RenderTimingReport::addRender(const PhaseTimings& timings)
+{
+    for (size_t i = 0; i < phases.size(); ++i)
+    {
+        if (timings.calls[i] > 0)
+            phases[i].add(timings.seconds[i]);
+    }
+
+    total.add(timings.getTotalSeconds());
+    ++renders;
+}
+
+void RenderTimingReport::merge(const RenderTimingReport& other)
+{
+    for (size_t i = 0; i < phases.size(); ++i)
+        phases[i].merge(other.phases[i]);
+
+    total.merge(other.total);
+    renders += other.renders;
+}
+
+void RenderTimingReport::logSummary() const
+{
+    if (renders == 0)
+        return;
+
+    logInfo("Render phases over " + juce::String(renders) + " renders (mean / p50 / p90 / max ms, share):");
+    for (int i = 0; i < numRenderPhases; ++i)
+    {
+        const auto& phase = phases[static_cast<size_t>(i)];
+        if (phase.renders == 0)
+            continue;
+
+        double share = total.totalSeconds > 0.0 ? 100.0 * phase.totalSeconds / total.totalSeconds : 0.0;
+        logInfo("  " + juce::String(getRenderPhaseName(static_cast<RenderPhase>(i))).paddedRight(' ', 12)
+                + juce::String(phase.totalSeconds * 1000.0 / static_cast<double>(phase.renders), 3) + " / "
+                + juce::String(phase.getQuantileSeconds(0.5) * 1000.0, 3) + " / "
+                + juce::String(phase.getQuantileSeconds(0.9) * 1000.0, 3) + " / "
+                + juce::String(phase.maxSeconds * 1000.0, 3) + "  "
+                + juce::String(share, 1) + "%");
+    }
+}
+
+juce::var RenderTimingReport::toVar() const
+{
+    auto* object = new juce::DynamicObject();
+    juce::var result(object);
+
+    auto* phaseObject = new juce::DynamicObject();
+    for (int i = 0; i < numRenderPhases; ++i)
+    {
+        if (phases[static_cast<size_t>(i)].renders > 0)
+            phaseObject->setProperty(getRenderPhaseName(static_cast<RenderPhase>(i)),
+                                     phases[static_cast<size_t>(i)].toVar());
+    }
+
+    object->setProperty("renders", renders);
+    object->setProperty("phases", juce::var(phaseObject));
+    object->setProperty("total", total.toVar());
+    return result;
+}
+
+bool RenderTimingReport::writeToFile(const juce::File& file) const
+{
+    ensureDirectoryExists(file.getParentDirectory());
+
+    if (!file.replaceWithText(juce::JSON::toString(toVar())))
+    {
+        logError("Failed to write timing report: " + file.getFullPathName());
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace serum
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+#include <chrono>
+
+namespace serum {
+
+/**
+ * Phases of a render, timed separately
+ * MainRender and Tail cover MIDI and plugin processing only; the statistics
+ * and sink calls of their blocks are counted under Stats and Write.
+ */
+enum class RenderPhase
+{
+    Prepare,     // prepareToPlay, or the reset between renders
+    StateLoad,   // Reading and applying the preset state
+    Warmup,      // Warmup blocks or snapshot restore
+    MainRender,
+    Tail,
+    Stats,       // AudioStats updates and finalize
+    Write,       // Sink begin and block writes
+    Close,       // Sink end (file finalize)
+    NumPhases
+};
+
+constexpr int numRenderPhases = static_cast<int>(RenderPhase::NumPhases);
+
+const char* getRenderPhaseName(RenderPhase phase);
+
+/**
+ * Time spent and number of timed sections per phase
+ */
+struct PhaseTimings
+{
+    std::array<double, numRenderPhases> seconds {};
+    std::array<int64, numRenderPhases> calls {};
+
+    void reset() { *this = PhaseTimings(); }
+    void addTime(RenderPhase phase, double phaseSeconds)
+    {
+        seconds[static_cast<size_t>(phase)] += phaseSeconds;
+        ++calls[static_cast<size_t>(phase)];
+    }
+    void add(const PhaseTimings& other);
+    void scale(double factor);
+
+    double get(RenderPhase phase) const { return seconds[static_cast<size_t>(phase)]; }
+    double getTotalSeconds() const;
+
+    /**
+     * {"<phase>Ms": milliseconds, ..., "totalMs": ...}; phases never timed are left out
+     */
+    juce::var toVar() const;
+};
+
+/**
+ * Phase timings of the calling thread
+ * Owned by the thread, so timers never synchronize. Reset before a render and
+ * read after it to get that render's record.
+ */
+PhaseTimings& getThreadPhaseTimings();
+
+/**
+ * Adds the lifetime of the scope to a phase of the calling thread
+ */
+class ScopedPhaseTimer
+{
+public:
+    explicit ScopedPhaseTimer(RenderPhase phase)
+        : phase(phase)
+        , timings(getThreadPhaseTimings())
+        , start(std::chrono::steady_clock::now())
+    {
+    }
+
+    ~ScopedPhaseTimer()
+    {
+        timings.addTime(phase, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    RenderPhase phase;
+    PhaseTimings& timings;
+    std::chrono::steady_clock::time_point start;
+
+    JUCE_DECLARE_NON_COPYABLE(ScopedPhaseTimer)
+};
+
+/**
+ * Distribution of one phase's time per render, in power-of-two buckets
+ * Bucket i holds times below 2^i microseconds.
+ */
+struct PhaseHistogram
+{
+    static constexpr int numBuckets = 36;
+
+    std::array<int64, numBuckets> counts {};
+    int64 renders = 0;
+    double totalSeconds = 0.0;
+    double maxSeconds = 0.0;
+
+    void add(double seconds);
+    void merge(const PhaseHistogram& other);
+
+    /**
+     * Upper bound of the bucket holding the given quantile (0-1)
+     */
+    double getQuantileSeconds(double quantile) const;
+
+    juce::var toVar() const;
+};
+
+/**
+ * Per-phase histograms over a batch of renders
+ */
+class RenderTimingReport
+{
+public:
+    void addRender(const PhaseTimings& timings);
+    void merge(const RenderTimingReport& other);
+    void reset() { *this = RenderTimingReport(); }
+
+    int64 getNumRenders() const { return renders; }
+
+    /**
+     * One line per phase: mean, p50, p90, max and share of the total
+     */
+    void logSummary() const;
+
+    juce::var toVar() const;
+    bool writeToFile(const juce::File& file) const;
+
+private:
+    std::array<PhaseHistogram, numRenderPhases> phases;
+    PhaseHistogram total;
+    int64 renders = 0;
+};
+
+} // namespace serum
@@ -0,0 +1,237 @@
+#include "render/RenderWorkerProcess.h"
+#include "render/RenderFarm.h"
+#include "vst/PluginFactory.h"
+#include "common/Log.h"
+
+#if JUCE_WINDOWS
+ #ifndef NOMINMAX
+  #define NOMINMAX
+ #endif
+ #include <windows.h>
+#else
+ #include <unistd.h>
+#endif
+
+namespace serum {
+
+const char* const renderWorkerProcessId = "serum-render-worker";
+
+// A worker that is not configured in time was not launched by a supervisor
+static constexpr int configTimeoutMs = 30000;
+
+static int getCurrentProcessId()
+{
+#if JUCE_WINDOWS
+    return static_cast<int>(GetCurrentProcessId());
+#else
+    return static_cast<int>(getpid());
+#endif
+}
+
+juce::MemoryBlock encodeWorkerMessage(const juce::var& message)
+{
+    auto text = juce::JSON::toString(message, true);
+    return juce::MemoryBlock(text.toRawUTF8(), text.getNumBytesAsUTF8());
+}
+
+juce::var decodeWorkerMessage(const juce::MemoryBlock& block)
+{
+    return juce::JSON::parse(block.toString());
+}
+
+RenderWorkerProcess::RenderWorkerProcess() = default;
+
+RenderWorkerProcess::~RenderWorkerProcess() = default;
+
+void RenderWorkerProcess::handleMessageFromCoordinator(const juce::MemoryBlock& block)
+{
+    auto message = decodeWorkerMessage(block);
+    auto type = message["type"].toString();
+
+    if (type == "config")
+    {
+        config = message;
+        configReceived.signal();
+    }
+    else if (type == "job")
+    {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            pendingJobs.push_back(static_cast<int64>(message["index"]));
+        }
+        jobAvailable.signal();
+    }
+    else if (type == "quit")
+    {
+        handleConnectionLost();
+    }
+}
+
+void RenderWorkerProcess::handleConnectionLost()
+{
+    quitting = true;
+    configReceived.signal();
+    jobAvailable.signal();
+}
+
+int RenderWorkerProcess::run()
+{
+    if (!configReceived.wait(configTimeoutMs) || quitting)
+        return 1;
+
+    // Lets the supervisor kill this process if it hangs, even during startup
+    auto* started = new juce::DynamicObject();
+    started->setProperty("type", "started");
+    started->setProperty("processId", getCurrentProcessId());
+    sendMessageToCoordinator(encodeWorkerMessage(juce::var(started)));
+
+    LogOptions logOptions;
+    logOptions.minLevel = static_cast<LogLevel>(static_cast<int>(config["logLevel"]));
+    logOptions.jsonLines = config["logJson"];
+    if (config["logFile"].toString().isNotEmpty())
+        logOptions.outputFile = juce::File(config["logFile"].toString());
+    configureLogging(logOptions);
+
+    logInfo("Render worker " + config["workerIndex"].toString() + " started");
+
+    juce::PluginDescription desc;
+    auto descXml = juce::parseXML(config["plugin"].toString());
+    if (descXml == nullptr || !desc.loadFromXml(*descXml))
+    {
+        sendError("Invalid plugin description");
+        return 1;
+    }
+
+    JobSource source(*this, juce::File(config["manifest"].toString()));
+
+    // One job in flight at a time, so the supervisor always knows which job
+    // a crash or hang belongs to
+    RenderFarmOptions options;
+    options.numWorkers = 1;
+    options.refillBatchSize = 1;
+    options.maxPresetBatch = 1;
+    options.blockSize = config["blockSize"];
+    if (config["cacheDirectory"].toString().isNotEmpty())
+        options.cacheDirectory = juce::File(config["cacheDirectory"].toString());
+    options.shmRingName = config["shmRing"].toString();
+    options.onJobFinished = [this, &source](const RenderJob&, bool ok)
+    {
+        sendResult(source.getCurrentIndex(), ok);
+    };
+
+    PluginFactory factory;
+    RenderFarm farm(factory, desc, options);
+
+    RenderSettings firstSettings;
+    RenderManifest::readFirstJobSettings(juce::File(config["manifest"].toString()), firstSettings);
+
+    juce::String errorMsg;
+    if (!farm.createWorkers(errorMsg, firstSettings))
+    {
+        sendError(errorMsg);
+        return 1;
+    }
+
+    auto* ready = new juce::DynamicObject();
+    ready->setProperty("type", "ready");
+    sendMessageToCoordinator(encodeWorkerMessage(juce::var(ready)));
+
+    RenderFarmSummary summary;
+    farm.run(source, summary);
+
+    logInfo("Render worker " + config["workerIndex"].toString() + " exiting");
+    flushLog();
+    return 0;
+}
+
+bool RenderWorkerProcess::takeJobIndex(int64& index)
+{
+    for (;;)
+    {
+        {
+            std::lock_guard<std::mutex> lock(jobsMutex);
+            if (!pendingJobs.empty())
+            {
+                index = pendingJobs.front();
+                pendingJobs.pop_front();
+                return true;
+            }
+        }
+
+        if (quitting)
+            return false;
+
+        jobAvailable.wait(100);
+    }
+}
+
+void RenderWorkerProcess::sendResult(int64 index, bool ok)
+{
+    auto* result = new juce::DynamicObject();
+    result->setProperty("type", "result");
+    result->setProperty("index", index);
+    result->setProperty("ok", ok);
+    sendMessageToCoordinator(encodeWorkerMessage(juce::var(result)));
+}
+
+void RenderWorkerProcess::sendError(const juce::String& message)
+{
+    logError(message);
+
+    auto* error = new juce::DynamicObject();
+    error->setProperty("type", "error");
+    error->setProperty("message", message);
+    sendMessageToCoordinator(encodeWorkerMessage(juce::var(error)));
+    flushLog();
+}
+
+bool RenderWorkerProcess::JobSource::next(RenderJob& job)
+{
+    int64 index = 0;
+    while (owner.takeJobIndex(index))
+    {
+        if (seek(index, job))
+        {
+            currentIndex = index;
+
+            // The result is reported as soon as the job finishes, so the
+            // file has to be complete by then
+            job.settings.asyncWrite = false;
+            return true;
+        }
+
+        logError("Manifest has no job " + juce::String(index));
+        owner.sendResult(index, false);
+    }
+
+    return false;
+}
+
+bool RenderWorkerProcess::JobSource::seek(int64 index, RenderJob& job)
+{
+    // Jobs normally arrive in manifest order; a retried job rewinds
+    if (manifest == nullptr || index < manifestIndex)
+    {
+        manifest = std::make_unique<RenderManifest>();
+        manifestIndex = 0;
+
+        juce::String errorMsg;
+        if (!manifest->open(manifestFile, errorMsg))
+        {
+            manifest.reset();
+            return false;
+        }
+    }
+
+    while (manifestIndex <= index)
+    {
+        if (!manifest->next(job))
+            return false;
+
+        ++manifestIndex;
+    }
+
+    return true;
+}
+
+} // namespace serum
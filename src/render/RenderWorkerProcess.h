@@ -0,0 +1,95 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "render/RenderJob.h"
+#include "render/RenderManifest.h"
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+
+namespace serum {
+
+/**
+ * Command line ID shared by the supervisor and its worker processes
+ */
+extern const char* const renderWorkerProcessId;
+
+/**
+ * Messages between supervisor and worker are single JSON objects with a "type"
+ *
+ *   supervisor -> worker: config, job {index}, quit
+ *   worker -> supervisor: started {processId}, ready, error {message}, result {index, ok}
+ */
+juce::MemoryBlock encodeWorkerMessage(const juce::var& message);
+juce::var decodeWorkerMessage(const juce::MemoryBlock& block);
+
+/**
+ * Child side of supervisor mode
+ *
+ * Hosts its own PluginFactory and a single-worker RenderFarm. Jobs arrive as
+ * indices into the manifest, which the worker streams itself, so a job never
+ * has to be serialized. Audio is written by the worker straight to its
+ * output file and never crosses the process boundary.
+ *
+ * Usage from main(), before anything else:
+ *
+ *   RenderWorkerProcess worker;
+ *   if (worker.initialiseFromCommandLine(commandLine, renderWorkerProcessId))
+ *       return worker.run();
+ */
+class RenderWorkerProcess : public juce::ChildProcessWorker
+{
+public:
+    RenderWorkerProcess();
+    ~RenderWorkerProcess() override;
+
+    /**
+     * Wait for the configuration, render every job the supervisor sends and
+     * return once told to quit or when the supervisor goes away
+     * Must be called on the message thread
+     * @return process exit code
+     */
+    int run();
+
+    void handleMessageFromCoordinator(const juce::MemoryBlock& message) override;
+    void handleConnectionLost() override;
+
+private:
+    /**
+     * Job source fed by the supervisor; blocks until a job index arrives
+     */
+    class JobSource : public RenderJobSource
+    {
+    public:
+        JobSource(RenderWorkerProcess& owner, const juce::File& manifestFile)
+            : owner(owner), manifestFile(manifestFile) {}
+
+        bool next(RenderJob& job) override;
+
+        int64 getCurrentIndex() const { return currentIndex; }
+
+    private:
+        RenderWorkerProcess& owner;
+        juce::File manifestFile;
+        std::unique_ptr<RenderManifest> manifest;
+        int64 manifestIndex = 0;  // Index of the job the manifest yields next
+        int64 currentIndex = -1;  // Job being rendered
+
+        bool seek(int64 index, RenderJob& job);
+    };
+
+    juce::var config;
+    juce::WaitableEvent configReceived;
+
+    std::mutex jobsMutex;
+    std::deque<int64> pendingJobs;
+    juce::WaitableEvent jobAvailable;
+    std::atomic<bool> quitting { false };
+
+    bool takeJobIndex(int64& index);
+    void sendResult(int64 index, bool ok);
+    void sendError(const juce::String& message);
+};
+
+} // namespace serum
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <JuceHeader.h>
+
+namespace serum {
+
+/**
+ * On-disk layout of the packed shard container
+ *
+ * A shard is a pair of append-only files:
+ *   name.shard  64-byte ShardFileHeader, then one record per render: interleaved
+ *               little-endian float32 frames, each record starting on a
+ *               64-byte boundary
+ *   name.idx    64-byte ShardIndexHeader, then one 64-byte ShardIndexEntry per
+ *               completed record
+ *
+ * An index entry is appended only after its record's data, so a crash leaves
+ * at most some unreferenced bytes at the end of the .shard file. Both files
+ * can be memory-mapped and read in place (see ShardReader).
+ */
+namespace shard {
+
+constexpr char dataMagic[8]  = { 'S', 'R', 'S', 'H', 'A', 'R', 'D', '1' };
+constexpr char indexMagic[8] = { 'S', 'R', 'S', 'I', 'D', 'X', '0', '1' };
+constexpr uint32 version = 1;
+constexpr int alignment = 64;
+constexpr int presetHashSize = 16;
+
+constexpr const char* dataExtension = ".shard";
+constexpr const char* indexExtension = ".idx";
+constexpr const char* metadataExtension = ".jsonl";
+
+} // namespace shard
+
+struct ShardFileHeader
+{
+    char magic[8];
+    uint32 version;
+    uint32 headerSize;
+    uint32 alignment;
+    uint32 reserved[11];
+};
+
+struct ShardIndexHeader
+{
+    char magic[8];
+    uint32 version;
+    uint32 entrySize;
+    uint32 reserved[12];
+};
+
+struct ShardIndexEntry
+{
+    uint8 presetHash[shard::presetHashSize];  // Zero for the plugin's default state
+    uint64 offset;                            // Byte offset of the record in the .shard file
+    uint64 numFrames;
+    uint32 sampleRate;
+    uint16 numChannels;
+    uint8 note;                               // MIDI note number
+    uint8 velocity;
+    uint8 reserved[24];
+
+    uint64 getLengthBytes() const { return numFrames * numChannels * sizeof(float); }
+};
+
+static_assert(sizeof(ShardFileHeader) == shard::alignment, "Shard header must fill one alignment unit");
+static_assert(sizeof(ShardIndexHeader) == shard::alignment, "Index header must fill one alignment unit");
+static_assert(sizeof(ShardIndexEntry) == 64, "Index entries are fixed 64-byte records");
+
+/**
+ * Identifies one render inside a shard
+ */
+struct ShardKey
+{
+    uint8 presetHash[shard::presetHashSize] = {};
+    int note = 60;
+    int velocity = 100;
+};
+
+} // namespace serum
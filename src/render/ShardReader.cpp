@@ -0,0 +1,76 @@
+#include "render/ShardReader.h"
+#include "common/Log.h"
+
+namespace serum {
+
+bool ShardReader::open(const juce::File& shardFile)
+{
+    entries = nullptr;
+    numRecords = 0;
+
+    data = std::make_unique<juce::MemoryMappedFile>(shardFile, juce::MemoryMappedFile::readOnly);
+    index = std::make_unique<juce::MemoryMappedFile>(shardFile.withFileExtension(shard::indexExtension),
+                                                     juce::MemoryMappedFile::readOnly);
+
+    if (data->getData() == nullptr || index->getData() == nullptr)
+    {
+        logError("Failed to map shard: " + shardFile.getFullPathName());
+        return false;
+    }
+
+    auto* fileHeader = static_cast<const ShardFileHeader*>(data->getData());
+    auto* indexHeader = static_cast<const ShardIndexHeader*>(index->getData());
+
+    if (data->getSize() < sizeof(ShardFileHeader) || index->getSize() < sizeof(ShardIndexHeader)
+        || std::memcmp(fileHeader->magic, shard::dataMagic, sizeof(fileHeader->magic)) != 0
+        || std::memcmp(indexHeader->magic, shard::indexMagic, sizeof(indexHeader->magic)) != 0
+        || fileHeader->version != shard::version
+        || indexHeader->entrySize != sizeof(ShardIndexEntry))
+    {
+        logError("Not a valid shard: " + shardFile.getFullPathName());
+        return false;
+    }
+
+    entries = reinterpret_cast<const ShardIndexEntry*>(static_cast<const char*>(index->getData())
+                                                       + sizeof(ShardIndexHeader));
+
+    // A torn trailing entry or one pointing past the data means the writer was
+    // interrupted; everything before it is intact
+    auto available = static_cast<int>((index->getSize() - sizeof(ShardIndexHeader)) / sizeof(ShardIndexEntry));
+    while (numRecords < available)
+    {
+        const auto& entry = entries[numRecords];
+        if (entry.offset % shard::alignment != 0
+            || entry.offset + entry.getLengthBytes() > data->getSize())
+        {
+            logError("Shard index truncated at record " + juce::String(numRecords) + ": "
+                     + shardFile.getFullPathName());
+            break;
+        }
+
+        ++numRecords;
+    }
+
+    return true;
+}
+
+const float* ShardReader::getSamples(int record) const
+{
+    jassert(record >= 0 && record < numRecords);
+    return reinterpret_cast<const float*>(static_cast<const char*>(data->getData()) + entries[record].offset);
+}
+
+int ShardReader::findRecord(const ShardKey& key) const
+{
+    for (int i = 0; i < numRecords; ++i)
+    {
+        const auto& entry = entries[i];
+        if (entry.note == key.note && entry.velocity == key.velocity
+            && std::memcmp(entry.presetHash, key.presetHash, sizeof(entry.presetHash)) == 0)
+            return i;
+    }
+
+    return -1;
+}
+
+} // namespace serum
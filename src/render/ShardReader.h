@@ -0,0 +1,45 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "render/ShardFormat.h"
+
+namespace serum {
+
+/**
+ * Random access to a shard written by ShardWriter
+ * Both the data and the index are memory-mapped; samples are returned as
+ * pointers into the mapping, so reading a record costs no copy or parsing.
+ */
+class ShardReader
+{
+public:
+    /**
+     * Map a shard and its index
+     * @param shardFile The .shard file; the .idx is expected next to it
+     * @return true if both files are valid
+     */
+    bool open(const juce::File& shardFile);
+
+    int getNumRecords() const { return numRecords; }
+
+    const ShardIndexEntry& getEntry(int record) const { return entries[record]; }
+
+    /**
+     * Interleaved float32 frames of a record, getEntry().numFrames long
+     */
+    const float* getSamples(int record) const;
+
+    /**
+     * Find a record by key
+     * @return record index, or -1 if not present
+     */
+    int findRecord(const ShardKey& key) const;
+
+private:
+    std::unique_ptr<juce::MemoryMappedFile> data;
+    std::unique_ptr<juce::MemoryMappedFile> index;
+    const ShardIndexEntry* entries = nullptr;
+    int numRecords = 0;
+};
+
+} // namespace serum
@@ -0,0 +1,200 @@
+#include "render/ShardWriter.h"
+#include "render/WavWriter.h"
+#include "common/Log.h"
+
+namespace serum {
+
+ShardWriter::ShardWriter(const juce::File& directory, const juce::String& baseName,
+                         int64 maxShardBytes, int maxChannels, int maxBlockSize)
+    : directory(directory)
+    , baseName(baseName)
+    , maxShardBytes(maxShardBytes)
+    , maxChannels(maxChannels)
+    , scratchSamples(juce::jmax(1, maxBlockSize))
+    , interleaved(static_cast<size_t>(maxChannels * juce::jmax(1, maxBlockSize)))
+{
+}
+
+ShardWriter::~ShardWriter()
+{
+    close();
+}
+
+bool ShardWriter::openNextShard()
+{
+    close();
+
+    if (!directory.createDirectory())
+    {
+        logError("Failed to create shard directory: " + directory.getFullPathName());
+        return false;
+    }
+
+    // Never append to a shard from an earlier run; its index may be in use
+    do
+    {
+        ++shardNumber;
+        shardFile = directory.getChildFile(baseName + "-" + juce::String(shardNumber).paddedLeft('0', 5)
+                                           + shard::dataExtension);
+    }
+    while (shardFile.exists());
+
+    dataStream = std::make_unique<juce::FileOutputStream>(shardFile, 1 << 20);
+    indexStream = std::make_unique<juce::FileOutputStream>(shardFile.withFileExtension(shard::indexExtension));
+    metadataStream = std::make_unique<juce::FileOutputStream>(shardFile.withFileExtension(shard::metadataExtension));
+
+    if (!dataStream->openedOk() || !indexStream->openedOk() || !metadataStream->openedOk())
+    {
+        logError("Failed to create shard: " + shardFile.getFullPathName());
+        close();
+        return false;
+    }
+
+    ShardFileHeader fileHeader {};
+    std::memcpy(fileHeader.magic, shard::dataMagic, sizeof(fileHeader.magic));
+    fileHeader.version = shard::version;
+    fileHeader.headerSize = sizeof(ShardFileHeader);
+    fileHeader.alignment = shard::alignment;
+
+    ShardIndexHeader indexHeader {};
+    std::memcpy(indexHeader.magic, shard::indexMagic, sizeof(indexHeader.magic));
+    indexHeader.version = shard::version;
+    indexHeader.entrySize = sizeof(ShardIndexEntry);
+
+    if (!dataStream->write(&fileHeader, sizeof(fileHeader))
+        || !indexStream->write(&indexHeader, sizeof(indexHeader)))
+    {
+        logError("Failed to write shard headers: " + shardFile.getFullPathName());
+        close();
+        return false;
+    }
+
+    recordsInShard = 0;
+    logInfo("Opened shard: " + shardFile.getFullPathName());
+    return true;
+}
+
+bool ShardWriter::padToAlignment()
+{
+    static const char zeros[shard::alignment] = {};
+
+    auto misalignment = static_cast<int>(dataStream->getPosition() % shard::alignment);
+    if (misalignment == 0)
+        return true;
+
+    return dataStream->write(zeros, static_cast<size_t>(shard::alignment - misalignment));
+}
+
+bool ShardWriter::beginRecord(const ShardKey& key, double sampleRate, int numChannels)
+{
+    recordOpen = false;
+
+    if (numChannels < 1 || numChannels > maxChannels)
+    {
+        logError("Unsupported shard channel count: " + juce::String(numChannels));
+        return false;
+    }
+
+    if (dataStream == nullptr || dataStream->getPosition() >= maxShardBytes)
+    {
+        if (!openNextShard())
+            return false;
+    }
+
+    // An abandoned record leaves its bytes behind; start after them
+    if (!padToAlignment())
+        return false;
+
+    entry = ShardIndexEntry();
+    std::memcpy(entry.presetHash, key.presetHash, sizeof(entry.presetHash));
+    entry.offset = static_cast<uint64>(dataStream->getPosition());
+    entry.sampleRate = static_cast<uint32>(juce::roundToInt(sampleRate));
+    entry.numChannels = static_cast<uint16>(numChannels);
+    entry.note = static_cast<uint8>(juce::jlimit(0, 127, key.note));
+    entry.velocity = static_cast<uint8>(juce::jlimit(0, 127, key.velocity));
+
+    mapped.setSize(numChannels, scratchSamples, false, false, true);
+    recordOpen = true;
+    recordFailed = false;
+    return true;
+}
+
+bool ShardWriter::writeBlock(const juce::AudioBuffer<float>& block)
+{
+    if (!recordOpen || recordFailed)
+        return false;
+
+    int blockSamples = block.getNumSamples();
+    if (block.getNumChannels() == 0 || blockSamples == 0)
+        return true;
+
+    for (int start = 0; start < blockSamples; start += scratchSamples)
+    {
+        int numSamples = juce::jmin(scratchSamples, blockSamples - start);
+
+        mapChannels(block, start, numSamples, mapped);
+        interleaveSamples(mapped, numSamples, interleaved.get());
+
+        if (!dataStream->write(interleaved.get(), static_cast<size_t>(numSamples * entry.numChannels) * sizeof(float)))
+        {
+            logError("Failed to write shard record: " + shardFile.getFullPathName());
+            recordFailed = true;
+            return false;
+        }
+
+        entry.numFrames += static_cast<uint64>(numSamples);
+    }
+
+    return true;
+}
+
+bool ShardWriter::endRecord()
+{
+    if (!recordOpen)
+        return false;
+
+    recordOpen = false;
+    if (recordFailed)
+        return false;
+
+    // Data must be on disk before the index refers to it
+    dataStream->flush();
+    if (!indexStream->write(&entry, sizeof(entry)))
+    {
+        logError("Failed to write shard index: " + shardFile.getFullPathName());
+        return false;
+    }
+
+    indexStream->flush();
+    ++recordsInShard;
+    ++recordsWritten;
+    return true;
+}
+
+bool ShardWriter::appendMetadata(const juce::var& metadata)
+{
+    if (metadataStream == nullptr || recordsInShard == 0)
+        return false;
+
+    if (auto* object = metadata.getDynamicObject())
+    {
+        object->setProperty("shard", shardFile.getFileName());
+        object->setProperty("record", recordsInShard - 1);
+    }
+
+    return metadataStream->writeText(juce::JSON::toString(metadata, true) + "\n", false, false, nullptr);
+}
+
+void ShardWriter::close()
+{
+    recordOpen = false;
+
+    if (dataStream != nullptr)
+        dataStream->flush();
+
+    dataStream.reset();
+    indexStream.reset();
+    metadataStream.reset();
+}
+
+} // namespace serum
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "render/ShardFormat.h"
+
+namespace serum {
+
+/**
+ * Appends renders to packed shard files instead of one file per render
+ *
+ * Records are written as interleaved float32 straight from the render blocks;
+ * the index entry is appended once the record is complete. A new shard is
+ * started when the current one exceeds maxShardBytes. Existing shards are never
+ * reopened: a restarted writer picks the next free shard number.
+ *
+ * Not thread safe; the render farm gives every worker its own writer.
+ */
+class ShardWriter
+{
+public:
+    /**
+     * Constructor, files are created on the first record
+     * @param directory Directory holding the shards
+     * @param baseName Shard name prefix, unique per writer (e.g. "w03")
+     * @param maxShardBytes Size after which the next record starts a new shard
+     * @param maxChannels Most channels a record can have
+     * @param maxBlockSize Samples converted per write; larger blocks are chunked
+     */
+    ShardWriter(const juce::File& directory, const juce::String& baseName,
+                int64 maxShardBytes = 1024 * 1024 * 1024, int maxChannels = 8, int maxBlockSize = 8192);
+    ~ShardWriter();
+
+    /**
+     * Start a record; an unfinished previous record is abandoned
+     * @param key Preset hash, note and velocity stored in the index
+     * @param sampleRate Sample rate stored in the index
+     * @param numChannels Channels of the record; blocks are mapped to it
+     * @return true if the shard is open and ready
+     */
+    bool beginRecord(const ShardKey& key, double sampleRate, int numChannels);
+
+    /**
+     * Append a block to the current record
+     */
+    bool writeBlock(const juce::AudioBuffer<float>& block);
+
+    /**
+     * Finish the current record and append its index entry
+     * @return true if the record is now in the index
+     */
+    bool endRecord();
+
+    /**
+     * Append a JSON line describing the last completed record
+     * "shard" and "record" properties are added to object metadata
+     */
+    bool appendMetadata(const juce::var& metadata);
+
+    /**
+     * Close the current shard
+     */
+    void close();
+
+    /**
+     * Current shard data file, juce::File() before the first record
+     */
+    juce::File getCurrentShardFile() const { return shardFile; }
+
+    int64 getNumRecordsWritten() const { return recordsWritten; }
+
+private:
+    juce::File directory;
+    juce::String baseName;
+    int64 maxShardBytes;
+    int maxChannels;
+    int scratchSamples;
+
+    juce::File shardFile;
+    std::unique_ptr<juce::FileOutputStream> dataStream;
+    std::unique_ptr<juce::FileOutputStream> indexStream;
+    std::unique_ptr<juce::FileOutputStream> metadataStream;
+    int shardNumber = -1;
+    int64 recordsInShard = 0;
+    int64 recordsWritten = 0;
+
+    // Current record
+    bool recordOpen = false;
+    bool recordFailed = false;
+    ShardIndexEntry entry {};
+
+    juce::AudioBuffer<float> mapped;
+    juce::HeapBlock<float> interleaved;
+
+    bool openNextShard();
+    bool padToAlignment();
+};
+
+} // namespace serum
@@ -0,0 +1,441 @@
+#include "render/ShmAudioRing.h"
+#include "common/Log.h"
+#include <cstring>
+#include <new>
+#include <thread>
+
+#if ! JUCE_WINDOWS
+ #include <cerrno>
+ #include <fcntl.h>
+ #include <sys/mman.h>
+ #include <sys/stat.h>
+ #include <unistd.h>
+#endif
+
+#if JUCE_LINUX
+ #include <climits>
+ #include <linux/futex.h>
+ #include <sys/syscall.h>
+ #include <time.h>
+#endif
+
+namespace serum {
+
+namespace {
+
+constexpr uint32 ringMagic = 0x474e5252;  // "RRNG"
+constexpr uint32 ringVersion = 1;
+constexpr size_t cacheLine = 64;
+constexpr int maxRingChannels = 32;
+
+size_t alignUp(size_t value, size_t alignment)
+{
+    return (value + alignment - 1) / alignment * alignment;
+}
+
+static_assert(std::atomic<uint32>::is_always_lock_free, "ring indices must be lock free to be shared");
+static_assert(sizeof(std::atomic<uint32>) == sizeof(uint32), "ring indices double as futex words");
+
+/**
+ * Sleep until word no longer holds expected, timeoutMs passes or a spurious wakeup
+ */
+void waitForChange(std::atomic<uint32>& word, uint32 expected, int timeoutMs)
+{
+#if JUCE_LINUX
+    timespec timeout { timeoutMs / 1000, static_cast<long>(timeoutMs % 1000) * 1000000L };
+    syscall(SYS_futex, reinterpret_cast<uint32*>(&word), FUTEX_WAIT, expected, &timeout, nullptr, 0);
+#else
+    juce::ignoreUnused(word, expected, timeoutMs);
+    std::this_thread::sleep_for(std::chrono::microseconds(100));
+#endif
+}
+
+void wakeWaiters(std::atomic<uint32>& word)
+{
+#if JUCE_LINUX
+    syscall(SYS_futex, reinterpret_cast<uint32*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+    juce::ignoreUnused(word);
+#endif
+}
+
+} // namespace
+
+/**
+ * Start of the shared mapping; the slots follow it
+ * Each index has a cache line to itself, next to the flag its owner's peer
+ * sets before sleeping on it
+ */
+struct ShmAudioRing::Control
+{
+    uint32 magic = 0;
+    uint32 version = 0;
+    uint32 numSlots = 0;
+    uint32 maxChannels = 0;
+    uint32 maxBlockSize = 0;
+    uint32 reserved = 0;
+    uint64 slotBytes = 0;
+
+    alignas(cacheLine) std::atomic<uint32> writeIndex { 0 };
+    std::atomic<uint32> consumerWaiting { 0 };
+
+    alignas(cacheLine) std::atomic<uint32> readIndex { 0 };
+    std::atomic<uint32> producerWaiting { 0 };
+};
+
+ShmAudioRing::~ShmAudioRing()
+{
+#if ! JUCE_WINDOWS
+    if (mapping != nullptr)
+        munmap(mapping, mappedBytes);
+
+    if (fd >= 0)
+        ::close(fd);
+
+    if (owner)
+        shm_unlink(name.toRawUTF8());
+#endif
+}
+
+bool ShmAudioRing::isSupported()
+{
+#if JUCE_WINDOWS
+    return false;
+#else
+    return true;
+#endif
+}
+
+juce::String ShmAudioRing::makeUniqueName(const juce::String& tag)
+{
+    static std::atomic<int> counter { 0 };
+
+#if JUCE_WINDOWS
+    int processId = 0;
+#else
+    int processId = static_cast<int>(getpid());
+#endif
+
+    // Kept short: some systems limit shared memory names to 31 characters
+    return "/serum-" + tag + "-" + juce::String(processId) + "-" + juce::String(counter++);
+}
+
+std::unique_ptr<ShmAudioRing> ShmAudioRing::create(const juce::String& name, int numSlots, int maxChannels,
+                                                   int maxBlockSize, juce::String& errorMsg)
+{
+#if JUCE_WINDOWS
+    juce::ignoreUnused(name, numSlots, maxChannels, maxBlockSize);
+    errorMsg = "Shared-memory audio rings are not supported on Windows";
+    return nullptr;
+#else
+    if (maxChannels < 1 || maxChannels > maxRingChannels || maxBlockSize < 1)
+    {
+        errorMsg = "Invalid shared-memory ring geometry";
+        return nullptr;
+    }
+
+    // A power of two keeps slot = index % numSlots stable when the 32-bit indices wrap
+    auto slots = static_cast<uint32>(juce::nextPowerOfTwo(juce::jmax(2, numSlots)));
+    auto channelBytes = alignUp(static_cast<size_t>(maxBlockSize) * sizeof(float), cacheLine);
+    auto slotBytes = alignUp(sizeof(ShmSlotHeader), cacheLine) + channelBytes * static_cast<size_t>(maxChannels);
+    auto controlBytes = alignUp(sizeof(Control), cacheLine);
+    auto totalBytes = controlBytes + slotBytes * slots;
+
+    std::unique_ptr<ShmAudioRing> ring(new ShmAudioRing());
+    ring->name = name;
+
+    // Left over from a run that crashed before removing it
+    shm_unlink(name.toRawUTF8());
+
+    ring->fd = shm_open(name.toRawUTF8(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (ring->fd < 0)
+    {
+        errorMsg = "shm_open failed for " + name + ": " + juce::String(std::strerror(errno));
+        return nullptr;
+    }
+
+    ring->owner = true;
+
+    if (ftruncate(ring->fd, static_cast<off_t>(totalBytes)) != 0)
+    {
+        errorMsg = "Failed to size shared memory " + name + ": " + juce::String(std::strerror(errno));
+        return nullptr;
+    }
+
+    ring->mapping = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (ring->mapping == MAP_FAILED)
+    {
+        ring->mapping = nullptr;
+        errorMsg = "Failed to map shared memory " + name + ": " + juce::String(std::strerror(errno));
+        return nullptr;
+    }
+
+    ring->mappedBytes = totalBytes;
+    ring->control = new (ring->mapping) Control();
+    ring->control->numSlots = slots;
+    ring->control->maxChannels = static_cast<uint32>(maxChannels);
+    ring->control->maxBlockSize = static_cast<uint32>(maxBlockSize);
+    ring->control->slotBytes = slotBytes;
+    ring->control->version = ringVersion;
+    ring->control->magic = ringMagic;
+
+    ring->slots = static_cast<uint8*>(ring->mapping) + controlBytes;
+    ring->slotBytes = slotBytes;
+    return ring;
+#endif
+}
+
+std::unique_ptr<ShmAudioRing> ShmAudioRing::open(const juce::String& name, juce::String& errorMsg)
+{
+#if JUCE_WINDOWS
+    juce::ignoreUnused(name);
+    errorMsg = "Shared-memory audio rings are not supported on Windows";
+    return nullptr;
+#else
+    std::unique_ptr<ShmAudioRing> ring(new ShmAudioRing());
+    ring->name = name;
+
+    ring->fd = shm_open(name.toRawUTF8(), O_RDWR, 0600);
+    if (ring->fd < 0)
+    {
+        errorMsg = "shm_open failed for " + name + ": " + juce::String(std::strerror(errno));
+        return nullptr;
+    }
+
+    struct stat info {};
+    if (fstat(ring->fd, &info) != 0 || static_cast<size_t>(info.st_size) < sizeof(Control))
+    {
+        errorMsg = "Shared memory " + name + " is not a ring";
+        return nullptr;
+    }
+
+    auto totalBytes = static_cast<size_t>(info.st_size);
+    ring->mapping = mmap(nullptr, totalBytes, PROT_READ | PROT_WRITE, MAP_SHARED, ring->fd, 0);
+    if (ring->mapping == MAP_FAILED)
+    {
+        ring->mapping = nullptr;
+        errorMsg = "Failed to map shared memory " + name + ": " + juce::String(std::strerror(errno));
+        return nullptr;
+    }
+
+    ring->mappedBytes = totalBytes;
+    ring->control = static_cast<Control*>(ring->mapping);
+
+    auto controlBytes = alignUp(sizeof(Control), cacheLine);
+    const auto& control = *ring->control;
+    if (control.magic != ringMagic || control.version != ringVersion
+        || control.maxChannels < 1 || control.maxChannels > static_cast<uint32>(maxRingChannels)
+        || controlBytes + control.slotBytes * control.numSlots > totalBytes)
+    {
+        errorMsg = "Shared memory " + name + " has an incompatible ring layout";
+        return nullptr;
+    }
+
+    ring->slots = static_cast<uint8*>(ring->mapping) + controlBytes;
+    ring->slotBytes = static_cast<size_t>(control.slotBytes);
+    return ring;
+#endif
+}
+
+int ShmAudioRing::getNumSlots() const
+{
+    return static_cast<int>(control->numSlots);
+}
+
+int ShmAudioRing::getMaxChannels() const
+{
+    return static_cast<int>(control->maxChannels);
+}
+
+int ShmAudioRing::getMaxBlockSize() const
+{
+    return static_cast<int>(control->maxBlockSize);
+}
+
+uint8* ShmAudioRing::getSlot(uint32 index) const
+{
+    return slots + static_cast<size_t>(index & (control->numSlots - 1)) * slotBytes;
+}
+
+float* ShmAudioRing::getChannel(uint8* slot, int channel) const
+{
+    auto channelBytes = alignUp(static_cast<size_t>(control->maxBlockSize) * sizeof(float), cacheLine);
+    return reinterpret_cast<float*>(slot + alignUp(sizeof(ShmSlotHeader), cacheLine)
+                                    + channelBytes * static_cast<size_t>(channel));
+}
+
+ShmSlotHeader* ShmAudioRing::acquireWrite(int timeoutMs)
+{
+    const auto deadline = juce::Time::getMillisecondCounter() + static_cast<uint32>(timeoutMs);
+    const auto write = control->writeIndex.load(std::memory_order_relaxed);
+
+    for (;;)
+    {
+        auto read = control->readIndex.load(std::memory_order_acquire);
+        if (write - read < control->numSlots)
+            return new (getSlot(write)) ShmSlotHeader();
+
+        auto now = juce::Time::getMillisecondCounter();
+        if (now >= deadline)
+            return nullptr;
+
+        // Announce the wait, then re-check: the consumer wakes us only if it
+        // sees the flag after releasing a slot
+        control->producerWaiting.store(1);
+        read = control->readIndex.load();
+        if (write - read >= control->numSlots)
+            waitForChange(control->readIndex, read, static_cast<int>(deadline - now));
+        control->producerWaiting.store(0, std::memory_order_relaxed);
+    }
+}
+
+void ShmAudioRing::publish()
+{
+    control->writeIndex.store(control->writeIndex.load(std::memory_order_relaxed) + 1);
+    if (control->consumerWaiting.load() != 0)
+        wakeWaiters(control->writeIndex);
+}
+
+bool ShmAudioRing::writeBegin(uint64 renderId, const ShardKey& key, double sampleRate, int numChannels,
+                              int outputChannels, int64 expectedSamples, int timeoutMs)
+{
+    auto* header = acquireWrite(timeoutMs);
+    if (header == nullptr)
+        return false;
+
+    header->type = ShmMessageType::Begin;
+    header->renderId = renderId;
+    header->key = key;
+    header->sampleRate = sampleRate;
+    header->numChannels = static_cast<uint32>(juce::jmin(numChannels, getMaxChannels()));
+    header->outputChannels = static_cast<uint32>(outputChannels);
+    header->expectedSamples = expectedSamples;
+    publish();
+    return true;
+}
+
+bool ShmAudioRing::writeBlock(uint64 renderId, const juce::AudioBuffer<float>& block, int timeoutMs)
+{
+    const int numChannels = juce::jmin(block.getNumChannels(), getMaxChannels());
+    const int maxBlockSize = getMaxBlockSize();
+
+    // Blocks larger than a slot are split across several
+    for (int start = 0; start < block.getNumSamples(); start += maxBlockSize)
+    {
+        int numSamples = juce::jmin(maxBlockSize, block.getNumSamples() - start);
+
+        auto* header = acquireWrite(timeoutMs);
+        if (header == nullptr)
+            return false;
+
+        header->type = ShmMessageType::Block;
+        header->renderId = renderId;
+        header->numChannels = static_cast<uint32>(numChannels);
+        header->numSamples = static_cast<uint32>(numSamples);
+
+        auto* slot = reinterpret_cast<uint8*>(header);
+        for (int ch = 0; ch < numChannels; ++ch)
+            std::memcpy(getChannel(slot, ch), block.getReadPointer(ch, start),
+                        static_cast<size_t>(numSamples) * sizeof(float));
+
+        publish();
+    }
+
+    return true;
+}
+
+bool ShmAudioRing::writeEnd(uint64 renderId, int timeoutMs)
+{
+    auto* header = acquireWrite(timeoutMs);
+    if (header == nullptr)
+        return false;
+
+    header->type = ShmMessageType::End;
+    header->renderId = renderId;
+    publish();
+    return true;
+}
+
+bool ShmAudioRing::writeMetadata(uint64 renderId, const juce::String& json, int timeoutMs)
+{
+    // The payload uses the slot's audio area
+    auto capacity = static_cast<size_t>(getMaxChannels()) * static_cast<size_t>(getMaxBlockSize()) * sizeof(float);
+    auto numBytes = json.getNumBytesAsUTF8();
+    if (numBytes + 1 > capacity)
+    {
+        logError("Render metadata too large for shared-memory ring: " + juce::String(static_cast<int64>(numBytes)) + " bytes");
+        return false;
+    }
+
+    auto* header = acquireWrite(timeoutMs);
+    if (header == nullptr)
+        return false;
+
+    header->type = ShmMessageType::Metadata;
+    header->renderId = renderId;
+    header->numBytes = static_cast<uint32>(numBytes);
+
+    auto* payload = reinterpret_cast<char*>(getChannel(reinterpret_cast<uint8*>(header), 0));
+    std::memcpy(payload, json.toRawUTF8(), numBytes);
+    payload[numBytes] = 0;
+    publish();
+    return true;
+}
+
+bool ShmAudioRing::read(ShmMessage& message, int timeoutMs)
+{
+    const auto deadline = juce::Time::getMillisecondCounter() + static_cast<uint32>(timeoutMs);
+    const auto read = control->readIndex.load(std::memory_order_relaxed);
+
+    while (control->writeIndex.load(std::memory_order_acquire) == read)
+    {
+        auto now = juce::Time::getMillisecondCounter();
+        if (now >= deadline)
+            return false;
+
+        control->consumerWaiting.store(1);
+        if (control->writeIndex.load() == read)
+            waitForChange(control->writeIndex, read, static_cast<int>(deadline - now));
+        control->consumerWaiting.store(0, std::memory_order_relaxed);
+    }
+
+    auto* slot = getSlot(read);
+    auto* header = reinterpret_cast<const ShmSlotHeader*>(slot);
+    message.header = header;
+    message.payload = nullptr;
+
+    if (header->type == ShmMessageType::Block)
+    {
+        // The producer is another process; never trust its sizes
+        int numChannels = static_cast<int>(juce::jmin(header->numChannels, control->maxChannels));
+        int numSamples = static_cast<int>(juce::jmin(header->numSamples, control->maxBlockSize));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            channelPointers[ch] = getChannel(slot, ch);
+
+        message.audio.setDataToReferTo(channelPointers, numChannels, numSamples);
+    }
+    else
+    {
+        message.audio.setDataToReferTo(channelPointers, 0, 0);
+
+        if (header->type == ShmMessageType::Metadata)
+        {
+            auto capacity = static_cast<size_t>(control->maxChannels) * control->maxBlockSize * sizeof(float);
+            auto* payload = reinterpret_cast<char*>(getChannel(slot, 0));
+            payload[juce::jmin(static_cast<size_t>(header->numBytes), capacity - 1)] = 0;
+            message.payload = payload;
+        }
+    }
+
+    return true;
+}
+
+void ShmAudioRing::release()
+{
+    control->readIndex.store(control->readIndex.load(std::memory_order_relaxed) + 1);
+    if (control->producerWaiting.load() != 0)
+        wakeWaiters(control->readIndex);
+}
+
+} // namespace serum
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "render/ShardFormat.h"
+#include <atomic>
+
+namespace serum {
+
+/**
+ * Kinds of message carried by a ShmAudioRing slot
+ */
+enum class ShmMessageType : uint32
+{
+    Begin = 1,     // A render starts; sampleRate, channels, expectedSamples and key are set
+    Block = 2,     // numSamples of audio per channel
+    End = 3,       // The render's audio is complete
+    Metadata = 4   // numBytes of UTF-8 JSON describing the finished render
+};
+
+/**
+ * Header at the start of every slot
+ */
+struct ShmSlotHeader
+{
+    ShmMessageType type = ShmMessageType::Block;
+    uint32 numChannels = 0;     // Rendered channels (Begin, Block)
+    uint32 outputChannels = 0;  // Channels the consumer stores (Begin)
+    uint32 numSamples = 0;      // Samples per channel (Block)
+    uint32 numBytes = 0;        // Payload bytes (Metadata)
+    uint32 reserved = 0;
+    uint64 renderId = 0;        // Shared by every message of one render
+    double sampleRate = 0.0;    // Begin
+    int64 expectedSamples = 0;  // Begin
+    ShardKey key;               // Begin
+};
+
+/**
+ * One message as seen by the consumer, valid until release()
+ * The audio buffer refers straight into shared memory; nothing is copied.
+ */
+struct ShmMessage
+{
+    const ShmSlotHeader* header = nullptr;
+    juce::AudioBuffer<float> audio;  // Block messages
+    const char* payload = nullptr;   // Metadata messages
+};
+
+/**
+ * Single-producer, single-consumer ring of audio blocks in POSIX shared memory
+ *
+ * Carries renders from a producer (OfflineRenderer through ShmSink, usually
+ * in a worker process) to a consumer in another process or thread. Slots
+ * hold a header and planar float channels sized for maxChannels ×
+ * maxBlockSize, so memory is fixed at creation. The producer copies each
+ * block into a slot once; the consumer reads the slot in place. Waiting uses
+ * futexes on the ring indices on Linux (no syscall unless the other side is
+ * asleep) and short sleeps elsewhere. Not available on Windows.
+ *
+ * The consumer creates the ring and removes its name when destroyed; the
+ * producer opens it by name. A producer that dies and is replaced may leave
+ * a render without End; consumers treat a new Begin as abandoning it.
+ */
+class ShmAudioRing
+{
+public:
+    ~ShmAudioRing();
+
+    /**
+     * True if this platform supports shared-memory rings
+     */
+    static bool isSupported();
+
+    /**
+     * Name unique to this process, for create()
+     */
+    static juce::String makeUniqueName(const juce::String& tag);
+
+    /**
+     * Create a ring (consumer side)
+     * @param name Shared memory name, see makeUniqueName()
+     * @param numSlots Ring capacity, rounded up to a power of two
+     * @param maxChannels Most channels a block can have
+     * @param maxBlockSize Samples per slot; larger blocks are split
+     * @return nullptr with errorMsg set on failure
+     */
+    static std::unique_ptr<ShmAudioRing> create(const juce::String& name, int numSlots, int maxChannels,
+                                                int maxBlockSize, juce::String& errorMsg);
+
+    /**
+     * Open an existing ring (producer side)
+     */
+    static std::unique_ptr<ShmAudioRing> open(const juce::String& name, juce::String& errorMsg);
+
+    const juce::String& getName() const { return name; }
+    int getNumSlots() const;
+    int getMaxChannels() const;
+    int getMaxBlockSize() const;
+
+    /**
+     * Bytes of shared memory mapped
+     */
+    size_t getMappedBytes() const { return mappedBytes; }
+
+    //==========================================================================
+    // Producer; every call blocks while the ring is full, up to timeoutMs
+
+    bool writeBegin(uint64 renderId, const ShardKey& key, double sampleRate, int numChannels,
+                    int outputChannels, int64 expectedSamples, int timeoutMs = defaultTimeoutMs);
+    bool writeBlock(uint64 renderId, const juce::AudioBuffer<float>& block, int timeoutMs = defaultTimeoutMs);
+    bool writeEnd(uint64 renderId, int timeoutMs = defaultTimeoutMs);
+    bool writeMetadata(uint64 renderId, const juce::String& json, int timeoutMs = defaultTimeoutMs);
+
+    //==========================================================================
+    // Consumer
+
+    /**
+     * Wait for the next message
+     * @return false if none arrived within timeoutMs
+     */
+    bool read(ShmMessage& message, int timeoutMs);
+
+    /**
+     * Hand the slot of the last message back to the producer
+     */
+    void release();
+
+private:
+    struct Control;
+
+    static constexpr int defaultTimeoutMs = 10000;
+
+    juce::String name;
+    bool owner = false;
+    int fd = -1;
+    void* mapping = nullptr;
+    size_t mappedBytes = 0;
+    Control* control = nullptr;
+    uint8* slots = nullptr;
+    size_t slotBytes = 0;
+    float* channelPointers[32] = {};
+
+    ShmAudioRing() = default;
+
+    uint8* getSlot(uint32 index) const;
+    float* getChannel(uint8* slot, int channel) const;
+
+    ShmSlotHeader* acquireWrite(int timeoutMs);
+    void publish();
+
+    JUCE_DECLARE_NON_COPYABLE(ShmAudioRing)
+};
+
+} // namespace serum
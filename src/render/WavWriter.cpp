@@ -3,6 +3,100 @@
 
 namespace serum {
 
+int getLayoutChannels(ChannelLayout layout, int sourceChannels)
+{
+    switch (layout)
+    {
+        case ChannelLayout::Mono:   return 1;
+        case ChannelLayout::Stereo: return 2;
+        default:                    return juce::jmax(1, sourceChannels);
+    }
+}
+
+void mapChannels(const juce::AudioBuffer<float>& source, int startSample, int numSamples,
+                 juce::AudioBuffer<float>& dest)
+{
+    int sourceChannels = source.getNumChannels();
+    int destChannels = dest.getNumChannels();
+    
+    if (destChannels == 1 && sourceChannels > 1)
+    {
+        // Downmix into the single dest channel
+        float* out = dest.getWritePointer(0);
+        float gain = 1.0f / static_cast<float>(sourceChannels);
+        
+        juce::FloatVectorOperations::copyWithMultiply(out, source.getReadPointer(0, startSample), gain, numSamples);
+        for (int srcCh = 1; srcCh < sourceChannels; ++srcCh)
+            juce::FloatVectorOperations::addWithMultiply(out, source.getReadPointer(srcCh, startSample), gain, numSamples);
+    }
+    else
+    {
+        // Matching channels map 1:1; a mono source is duplicated into every dest channel
+        for (int ch = 0; ch < destChannels; ++ch)
+            dest.copyFrom(ch, 0, source, juce::jmin(ch, sourceChannels - 1), startSample, numSamples);
+    }
+}
+
+void interleaveSamples(const juce::AudioBuffer<float>& source, int numSamples, float* dest)
+{
+    int numChannels = source.getNumChannels();
+    
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const float* src = source.getReadPointer(ch);
+        for (int i = 0; i < numSamples; ++i)
+            dest[i * numChannels + ch] = src[i];
+    }
+}
+
+const char* getSampleFormatName(SampleFormat format)
+{
+    switch (format)
+    {
+        case SampleFormat::Pcm16:      return "pcm16";
+        case SampleFormat::Float32:    return "float32";
+        case SampleFormat::RawFloat32: return "f32";
+        case SampleFormat::Npy:        return "npy";
+        default:                       return "pcm24";
+    }
+}
+
+bool parseSampleFormat(const juce::String& name, SampleFormat& format)
+{
+    for (auto candidate : { SampleFormat::Pcm16, SampleFormat::Pcm24, SampleFormat::Float32,
+                            SampleFormat::RawFloat32, SampleFormat::Npy })
+    {
+        if (name.equalsIgnoreCase(getSampleFormatName(candidate)))
+        {
+            format = candidate;
+            return true;
+        }
+    }
+    
+    return false;
+}
+
+const char* getSampleFormatExtension(SampleFormat format)
+{
+    switch (format)
+    {
+        case SampleFormat::RawFloat32: return ".f32";
+        case SampleFormat::Npy:        return ".npy";
+        default:                       return ".wav";
+    }
+}
+
+static bool isRawFormat(SampleFormat format)
+{
+    return format == SampleFormat::RawFloat32 || format == SampleFormat::Npy;
+}
+
+// Full-scale 32-bit integer, as expected by AudioFormatWriter::write()
+static inline int toFullScaleInt(float sample)
+{
+    return juce::roundToInt(static_cast<double>(juce::jlimit(-1.0f, 1.0f, sample)) * 2147483647.0);
+}
+
 WavWriter::WavWriter()
     : numChannels(2)
 {
@@ -13,14 +107,37 @@ WavWriter::~WavWriter()
     close();
 }
 
-bool WavWriter::open(const juce::File& outputFile, double sampleRate, int numChannels)
+bool WavWriter::open(const juce::File& outputFile, double sampleRate, int numChannels,
+                     SampleFormat format, int maxBlockSize)
 {
     close();  // Ensure any previous file is closed
     
+    if (numChannels < 1 || numChannels > maxChannels)
+    {
+        logError("Unsupported channel count: " + juce::String(numChannels));
+        return false;
+    }
+    
     this->numChannels = numChannels;
+    this->format = format;
+    framesWritten = 0;
+    fileHashValid = false;
+    
+    // Scratch for channel mapping and conversion, reused by every writeBlock()
+    scratchSamples = juce::jmax(1, maxBlockSize);
+    mapped.setSize(numChannels, scratchSamples, false, false, true);
+    scratch.allocate(static_cast<size_t>(numChannels * scratchSamples), false);
+    
+    // Float WAV takes the mapped floats as they are, reinterpreted as ints
+    for (int ch = 0; ch < numChannels; ++ch)
+        channelPointers[ch] = format == SampleFormat::Float32
+            ? reinterpret_cast<const int*>(mapped.getReadPointer(ch))
+            : scratch.get() + ch * scratchSamples;
+    channelPointers[numChannels] = nullptr;
     
-    logInfo("Opening WAV file: " + outputFile.getFullPathName());
-    logInfo("Sample rate: " + juce::String(sampleRate) + " Hz, Channels: " + juce::String(numChannels));
+    SERUM_LOG_DEBUG("Opening output file: " + outputFile.getFullPathName());
+    SERUM_LOG_DEBUG("Sample rate: " + juce::String(sampleRate) + " Hz, Channels: " + juce::String(numChannels)
+            + ", Format: " + getSampleFormatName(format));
     
     // Delete existing file
     if (outputFile.existsAsFile())
@@ -29,8 +146,13 @@ bool WavWriter::open(const juce::File& outputFile, double sampleRate, int numCha
     // Create parent directory if needed
     outputFile.getParentDirectory().createDirectory();
     
+    return isRawFormat(format) ? openRaw(outputFile) : openWav(outputFile, sampleRate);
+}
+
+bool WavWriter::openWav(const juce::File& outputFile, double sampleRate)
+{
     // Create file stream
-    fileStream = std::make_unique<juce::FileOutputStream>(outputFile);
+    fileStream = std::make_unique<HashingFileOutputStream>(outputFile);
     if (!fileStream->openedOk())
     {
         logError("Failed to open output file");
@@ -38,13 +160,17 @@ bool WavWriter::open(const juce::File& outputFile, double sampleRate, int numCha
         return false;
     }
     
-    // Create WAV format writer (24-bit PCM)
+    // 32 bits selects IEEE float in WavAudioFormat
+    int bitsPerSample = format == SampleFormat::Pcm16 ? 16
+                      : format == SampleFormat::Float32 ? 32
+                      : 24;
+    
     juce::WavAudioFormat wavFormat;
     writer.reset(wavFormat.createWriterFor(
         fileStream.get(),
         sampleRate,
         static_cast<unsigned int>(numChannels),
-        24,  // 24-bit
+        bitsPerSample,
         {},  // metadata
         0    // quality option
     ));
@@ -56,51 +182,162 @@ bool WavWriter::open(const juce::File& outputFile, double sampleRate, int numCha
         return false;
     }
     
-    // Release ownership of stream to writer
-    fileStream.release();
+    // The writer has written its header; release ownership of stream to writer
+    fileStream->markDataStart();
+    wavStream = fileStream.release();
+    
+    return true;
+}
+
+bool WavWriter::openRaw(const juce::File& outputFile)
+{
+    rawStream = std::make_unique<HashingFileOutputStream>(outputFile);
+    if (!rawStream->openedOk())
+    {
+        logError("Failed to open output file");
+        rawStream.reset();
+        return false;
+    }
+    
+    // The .npy header is rewritten with the final shape on close
+    if (format == SampleFormat::Npy && !writeNpyHeader())
+    {
+        logError("Failed to write .npy header");
+        rawStream.reset();
+        return false;
+    }
     
+    rawStream->markDataStart();
     return true;
 }
 
+bool WavWriter::writeNpyHeader()
+{
+    // Format 1.0: magic, version, header length, then a padded Python dict.
+    // The dict is padded to a fixed size so the data offset (128) never changes
+    // and stays aligned for memory-mapping.
+    juce::String dict = "{'descr': '<f4', 'fortran_order': False, 'shape': ("
+                      + juce::String(framesWritten) + ", " + juce::String(numChannels) + "), }";
+    
+    const int dictSize = npyHeaderSize - 10;
+    dict = dict.paddedRight(' ', dictSize - 1) + "\n";
+    jassert(dict.length() == dictSize);
+    
+    const char preamble[] = { '\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0 };
+    
+    return rawStream->write(preamble, sizeof(preamble))
+        && rawStream->writeShort(static_cast<short>(dictSize))
+        && rawStream->write(dict.toRawUTF8(), static_cast<size_t>(dictSize));
+}
+
 bool WavWriter::writeBlock(const juce::AudioBuffer<float>& block)
 {
-    if (writer == nullptr)
+    if (!isOpen())
     {
-        logError("WAV writer not open");
+        logError("Output file not open");
         return false;
     }
     
-    int blockChannels = block.getNumChannels();
     int blockSamples = block.getNumSamples();
     
-    if (blockSamples == 0)
+    if (block.getNumChannels() == 0 || blockSamples == 0)
         return true;  // Nothing to write
     
-    // Handle mono-to-stereo conversion if needed
-    if (blockChannels == 1 && numChannels == 2)
+    for (int start = 0; start < blockSamples; start += scratchSamples)
     {
-        // Create temporary stereo buffer
-        juce::AudioBuffer<float> stereoBuffer(2, blockSamples);
-        stereoBuffer.copyFrom(0, 0, block, 0, 0, blockSamples);
-        stereoBuffer.copyFrom(1, 0, block, 0, 0, blockSamples);
-        
-        return writer->writeFromAudioSampleBuffer(stereoBuffer, 0, blockSamples);
+        if (!writeChunk(block, start, juce::jmin(scratchSamples, blockSamples - start)))
+            return false;
     }
     
-    // Direct write
-    return writer->writeFromAudioSampleBuffer(block, 0, blockSamples);
+    return true;
+}
+
+bool WavWriter::writeChunk(const juce::AudioBuffer<float>& block, int startSample, int numSamples)
+{
+    mapChannels(block, startSample, numSamples, mapped);
+    framesWritten += numSamples;
+    
+    switch (format)
+    {
+        case SampleFormat::Float32:
+            // channelPointers already alias the mapped floats
+            return writer->write(channelPointers, numSamples);
+        
+        case SampleFormat::RawFloat32:
+        case SampleFormat::Npy:
+        {
+            // Interleave into scratch; little-endian is the native order on supported hosts
+            auto* dest = reinterpret_cast<float*>(scratch.get());
+            interleaveSamples(mapped, numSamples, dest);
+            
+            return rawStream->write(dest, static_cast<size_t>(numSamples * numChannels) * sizeof(float));
+        }
+        
+        default:
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                int* dest = scratch.get() + ch * scratchSamples;
+                const float* src = mapped.getReadPointer(ch);
+                
+                for (int i = 0; i < numSamples; ++i)
+                    dest[i] = toFullScaleInt(src[i]);
+            }
+            
+            return writer->write(channelPointers, numSamples);
+    }
 }
 
-void WavWriter::close()
+bool WavWriter::close()
 {
+    bool ok = true;
+    
     if (writer != nullptr)
     {
-        writer->flush();
+        // Also rewrites the header with the final sizes
+        ok = writer->flush();
+        fileHashValid = ok && wavStream->getFileHash(fileHash, fileHeaderSize);
         writer.reset();
-        logInfo("Closed WAV file");
+        wavStream = nullptr;
+        
+        if (ok)
+            SERUM_LOG_DEBUG("Closed WAV file");
+        else
+            logError("Failed to finalize WAV file");
+    }
+    
+    if (rawStream != nullptr)
+    {
+        // Patch the final shape into the .npy header
+        if (format == SampleFormat::Npy && !(rawStream->setPosition(0) && writeNpyHeader()))
+        {
+            logError("Failed to finalize .npy header");
+            ok = false;
+        }
+        
+        rawStream->flush();
+        if (rawStream->getStatus().failed())
+        {
+            logError("Failed to flush output file: " + rawStream->getStatus().getErrorMessage());
+            ok = false;
+        }
+        
+        fileHashValid = ok && rawStream->getFileHash(fileHash, fileHeaderSize);
+        rawStream.reset();
+        SERUM_LOG_DEBUG("Closed output file");
     }
     
     fileStream.reset();
+    return ok;
+}
+
+bool WavWriter::getFileHash(Hash128& hash, int64& headerSize) const
+{
+    if (!fileHashValid)
+        return false;
+    
+    hash = fileHash;
+    headerSize = fileHeaderSize;
+    return true;
 }
 
 } // namespace serum
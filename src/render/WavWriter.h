@@ -1,12 +1,76 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include "common/Hash.h"
+#include "render/HashingFileOutputStream.h"
 
 namespace serum {
 
 /**
- * Streaming WAV file writer
- * Writes audio blocks directly to disk with no buffering
+ * Channel layout of a written file relative to the rendered source
+ */
+enum class ChannelLayout
+{
+    MatchSource,  // As many channels as the source (mono stays mono)
+    Mono,         // Downmix to one channel
+    Stereo        // Two channels; mono sources are duplicated
+};
+
+/**
+ * Number of file channels for a layout
+ * @param layout Requested layout
+ * @param sourceChannels Channels in the rendered blocks
+ */
+int getLayoutChannels(ChannelLayout layout, int sourceChannels);
+
+/**
+ * Map a range of source channels onto every channel of dest
+ * Matching channels are copied 1:1, a mono source is duplicated and wider
+ * sources are averaged into a mono dest
+ */
+void mapChannels(const juce::AudioBuffer<float>& source, int startSample, int numSamples,
+                 juce::AudioBuffer<float>& dest);
+
+/**
+ * Interleave the first numSamples of every channel of source into dest
+ */
+void interleaveSamples(const juce::AudioBuffer<float>& source, int numSamples, float* dest);
+
+/**
+ * Sample encoding of a written file
+ */
+enum class SampleFormat
+{
+    Pcm16,       // 16-bit PCM WAV
+    Pcm24,       // 24-bit PCM WAV
+    Float32,     // 32-bit IEEE float WAV
+    RawFloat32,  // Headerless interleaved little-endian float32 (.f32)
+    Npy          // NumPy array of shape (samples, channels), dtype '<f4' (.npy)
+};
+
+/**
+ * Name used in manifests and metadata ("pcm16", "pcm24", "float32", "f32", "npy")
+ */
+const char* getSampleFormatName(SampleFormat format);
+
+/**
+ * Parse a format name as returned by getSampleFormatName()
+ * @return false if the name is unknown
+ */
+bool parseSampleFormat(const juce::String& name, SampleFormat& format);
+
+/**
+ * File extension for a format, including the dot
+ */
+const char* getSampleFormatExtension(SampleFormat format);
+
+/**
+ * Streaming audio file writer
+ * Writes audio blocks directly to disk with no buffering. Channel mapping and
+ * sample conversion go through scratch memory sized at open(), so writeBlock()
+ * never allocates. Besides WAV it writes raw float32 and .npy files, which
+ * training loaders can memory-map without parsing; float formats skip
+ * quantization entirely.
  */
 class WavWriter
 {
@@ -15,35 +79,74 @@ public:
     ~WavWriter();
     
     /**
-     * Open WAV file for writing
+     * Open file for writing
      * @param outputFile Output file path
-     * @param sampleRate Sample rate
-     * @param numChannels Number of channels (1 or 2)
+     * @param sampleRate Sample rate (not stored by the raw and .npy formats)
+     * @param numChannels Number of channels in the file (1 to 8)
+     * @param format Sample encoding
+     * @param maxBlockSize Largest block written in one call; larger ones are chunked
      * @return true if opened successfully
      */
-    bool open(const juce::File& outputFile, double sampleRate, int numChannels);
+    bool open(const juce::File& outputFile, double sampleRate, int numChannels,
+              SampleFormat format = SampleFormat::Pcm24, int maxBlockSize = 8192);
     
     /**
      * Write audio block to file
+     * Blocks with a different channel count are mapped to the file's layout:
+     * mono sources are duplicated, wider sources are downmixed into mono
      * @param block Audio data to write
      * @return true if written successfully
      */
     bool writeBlock(const juce::AudioBuffer<float>& block);
     
     /**
-     * Close the file
+     * Close the file, finalizing its header
+     * @return false if flushing or finalizing the header failed
      */
-    void close();
+    bool close();
     
     /**
      * Check if file is open
      */
-    bool isOpen() const { return writer != nullptr; }
+    bool isOpen() const { return writer != nullptr || rawStream != nullptr; }
+    
+    /**
+     * Hash of the last closed file, computed while it was written
+     * Verify it with computeFastHash128FromFile(file, headerSize, hash).
+     * @return false if no file was closed successfully or the file could not be
+     *         hashed as it streamed out
+     */
+    bool getFileHash(Hash128& hash, int64& headerSize) const;
     
 private:
-    std::unique_ptr<juce::FileOutputStream> fileStream;
-    std::unique_ptr<juce::AudioFormatWriter> writer;
+    static constexpr int maxChannels = 8;
+    static constexpr int npyHeaderSize = 128;
+    
+    std::unique_ptr<HashingFileOutputStream> fileStream;
+    std::unique_ptr<juce::AudioFormatWriter> writer;       // WAV formats
+    std::unique_ptr<HashingFileOutputStream> rawStream;    // .f32 and .npy
+    HashingFileOutputStream* wavStream = nullptr;          // Owned by writer
+    
+    // Hash of the last closed file
+    bool fileHashValid = false;
+    Hash128 fileHash;
+    int64 fileHeaderSize = 0;
     int numChannels;
+    SampleFormat format = SampleFormat::Pcm24;
+    int64 framesWritten = 0;
+    
+    // Source blocks mapped to the file's channels, maxBlockSize per channel
+    juce::AudioBuffer<float> mapped;
+    
+    // Encoded samples: planar full-scale ints for PCM, interleaved floats for raw
+    juce::HeapBlock<int> scratch;
+    int scratchSamples = 0;
+    const int* channelPointers[maxChannels + 1] = {};
+    
+    bool openWav(const juce::File& outputFile, double sampleRate);
+    bool openRaw(const juce::File& outputFile);
+    bool writeNpyHeader();
+    bool writeChunk(const juce::AudioBuffer<float>& block, int startSample, int numSamples);
 };
 
 } // namespace serum
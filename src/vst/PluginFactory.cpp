@@ -1,4 +1,5 @@
 #include "vst/PluginFactory.h"
+#include "vst/ReferenceSynth.h"
 #include "common/Log.h"
 
 namespace serum {
@@ -15,14 +16,23 @@ PluginFactory::~PluginFactory()
 
 std::unique_ptr<juce::AudioPluginInstance> PluginFactory::createPlugin(
     const juce::PluginDescription& desc,
-    juce::String& errorMsg)
+    juce::String& errorMsg,
+    double sampleRate,
+    int blockSize)
 {
-    logInfo("Creating plugin instance: " + desc.name);
+    SERUM_LOG_DEBUG("Creating plugin instance: " + desc.name);
     
     // Synchronous plugin loading for deterministic behavior
     errorMsg = "";
     
-    auto* format = formatManager.findFormatForDescription(desc, errorMsg);
+    // Built-in reference synth does not go through a plugin format
+    if (desc.pluginFormatName == ReferenceSynth::formatName)
+    {
+        SERUM_LOG_DEBUG("Successfully created plugin instance");
+        return std::make_unique<ReferenceSynth>();
+    }
+    
+    auto* format = findFormat(desc, errorMsg);
     if (format == nullptr)
     {
         errorMsg = "No format found for plugin: " + desc.name;
@@ -31,7 +41,7 @@ std::unique_ptr<juce::AudioPluginInstance> PluginFactory::createPlugin(
     }
     
     std::unique_ptr<juce::AudioPluginInstance> instance;
-    instance.reset(format->createInstanceFromDescription(desc, 44100.0, 512));
+    instance.reset(format->createInstanceFromDescription(desc, sampleRate, blockSize));
     
     if (instance == nullptr)
     {
@@ -40,8 +50,24 @@ std::unique_ptr<juce::AudioPluginInstance> PluginFactory::createPlugin(
         return nullptr;
     }
     
-    logInfo("Successfully created plugin instance");
+    SERUM_LOG_DEBUG("Successfully created plugin instance");
     return instance;
 }
 
+juce::AudioPluginFormat* PluginFactory::findFormat(const juce::PluginDescription& desc, juce::String& errorMsg)
+{
+    auto key = desc.pluginFormatName + "|" + desc.fileOrIdentifier;
+    
+    std::lock_guard<std::mutex> lock(formatMutex);
+    auto cached = formats.find(key);
+    if (cached != formats.end())
+        return cached->second;
+    
+    auto* format = formatManager.findFormatForDescription(desc, errorMsg);
+    if (format != nullptr)
+        formats[key] = format;
+    
+    return format;
+}
+
 } // namespace serum
@@ -1,12 +1,15 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <map>
 #include <memory>
+#include <mutex>
 
 namespace serum {
 
 /**
  * Factory for creating plugin instances
+ * Safe to call from several threads; see PluginInstancePool for creating many at once
  */
 class PluginFactory
 {
@@ -18,15 +21,24 @@ public:
      * Create a plugin instance synchronously
      * @param desc Plugin description
      * @param errorMsg Output error message if creation fails
+     * @param sampleRate Sample rate the instance will be prepared for
+     * @param blockSize Block size the instance will be prepared for
      * @return Plugin instance or nullptr on failure
      */
     std::unique_ptr<juce::AudioPluginInstance> createPlugin(
         const juce::PluginDescription& desc,
-        juce::String& errorMsg
+        juce::String& errorMsg,
+        double sampleRate = 44100.0,
+        int blockSize = 512
     );
     
 private:
     juce::AudioPluginFormatManager formatManager;
+    
+    std::mutex formatMutex;
+    std::map<juce::String, juce::AudioPluginFormat*> formats;  // By format name and file
+    
+    juce::AudioPluginFormat* findFormat(const juce::PluginDescription& desc, juce::String& errorMsg);
 };
 
 } // namespace serum
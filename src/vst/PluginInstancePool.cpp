@@ -0,0 +1,179 @@
+#include "vst/PluginInstancePool.h"
+#include "common/Log.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+namespace serum {
+
+PluginInstancePool::PluginInstancePool(PluginFactory& factory, const juce::PluginDescription& desc,
+                                       double sampleRate, int blockSize)
+    : factory(factory)
+    , desc(desc)
+    , sampleRate(sampleRate)
+    , blockSize(blockSize)
+{
+}
+
+PluginInstancePool::~PluginInstancePool()
+{
+    if (resident != nullptr)
+        resident->releaseResources();
+}
+
+std::unique_ptr<juce::AudioPluginInstance> PluginInstancePool::createPrepared(juce::String& errorMsg,
+                                                                              double& elapsedMs)
+{
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+
+    auto instance = factory.createPlugin(desc, errorMsg, sampleRate, blockSize);
+    if (instance != nullptr)
+    {
+        instance->setNonRealtime(true);
+        instance->prepareToPlay(sampleRate, blockSize);
+    }
+
+    elapsedMs = juce::Time::getMillisecondCounterHiRes() - startMs;
+    return instance;
+}
+
+bool PluginInstancePool::loadModule(juce::String& errorMsg)
+{
+    if (resident != nullptr)
+        return true;
+
+    resident = createPrepared(errorMsg, moduleLoadMs);
+    if (resident == nullptr)
+        return false;
+
+    logInfo("Loaded " + desc.name + " in " + juce::String(moduleLoadMs, 1) + " ms");
+    return true;
+}
+
+bool PluginInstancePool::createInstances(int count, std::vector<std::unique_ptr<juce::AudioPluginInstance>>& instances,
+                                         juce::String& errorMsg, int numThreads)
+{
+    instances.clear();
+    creationMs.assign(static_cast<size_t>(juce::jmax(0, count)), 0.0);
+
+    if (!loadModule(errorMsg))
+        return false;
+
+    if (count <= 0)
+        return true;
+
+    instances.resize(static_cast<size_t>(count));
+
+    auto* messageManager = juce::MessageManager::getInstanceWithoutCreating();
+    const bool onMessageThread = messageManager != nullptr && messageManager->isThisTheMessageThread();
+
+#if JUCE_MODAL_LOOPS_PERMITTED
+    const bool canWaitOnMessageThread = true;
+#else
+    const bool canWaitOnMessageThread = !onMessageThread;
+#endif
+
+    // Without a way to service the message thread while waiting, creating on
+    // other threads could deadlock, so create here one at a time
+    if (!canWaitOnMessageThread)
+    {
+        numThreads = 1;
+        logWarning("Creating plugin instances one at a time: modal loops are disabled "
+                   "(JUCE_MODAL_LOOPS_PERMITTED) and this is the message thread");
+    }
+    else if (numThreads <= 0)
+    {
+        numThreads = juce::SystemStats::getNumCpus();
+    }
+
+    numThreads = juce::jlimit(1, count, numThreads);
+    logInfo("Creating " + juce::String(count) + " instances of " + desc.name + " on "
+            + juce::String(numThreads) + (numThreads == 1 ? " thread" : " threads"));
+
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+    std::atomic<int> next { 0 };
+    std::atomic<bool> failed { false };
+    std::mutex errorMutex;
+
+    auto createLoop = [&]
+    {
+        for (int i = next++; i < count && !failed; i = next++)
+        {
+            juce::String instanceError;
+            auto index = static_cast<size_t>(i);
+            instances[index] = createPrepared(instanceError, creationMs[index]);
+
+            if (instances[index] == nullptr)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (!failed.exchange(true))
+                    errorMsg = "Instance " + juce::String(i) + ": " + instanceError;
+            }
+        }
+    };
+
+    if (!canWaitOnMessageThread)
+    {
+        createLoop();
+    }
+    else
+    {
+        std::atomic<int> running { numThreads };
+        std::vector<std::thread> threads;
+        for (int t = 0; t < numThreads; ++t)
+        {
+            threads.emplace_back([&]
+            {
+                createLoop();
+                --running;
+            });
+        }
+
+        // Some formats hand creation to the message thread and wait for it
+        while (running.load() > 0)
+        {
+#if JUCE_MODAL_LOOPS_PERMITTED
+            if (onMessageThread)
+                messageManager->runDispatchLoopUntil(5);
+            else
+                juce::Thread::sleep(5);
+#else
+            juce::Thread::sleep(5);
+#endif
+        }
+
+        for (auto& thread : threads)
+            thread.join();
+    }
+
+    if (failed)
+    {
+        logError(errorMsg);
+        instances.clear();
+        return false;
+    }
+
+    double totalMs = 0.0;
+    double maxMs = 0.0;
+    for (size_t i = 0; i < creationMs.size(); ++i)
+    {
+        SERUM_LOG_DEBUG("Instance " + juce::String(static_cast<int>(i)) + " ready in "
+                        + juce::String(creationMs[i], 1) + " ms");
+        totalMs += creationMs[i];
+        maxMs = juce::jmax(maxMs, creationMs[i]);
+    }
+
+    logInfo("Created " + juce::String(count) + " instances of " + desc.name + " on "
+            + juce::String(numThreads) + (numThreads == 1 ? " thread in " : " threads in ")
+            + juce::String(juce::Time::getMillisecondCounterHiRes() - startMs, 1) + " ms (per instance: mean "
+            + juce::String(totalMs / count, 1) + " ms, max " + juce::String(maxMs, 1) + " ms; module load "
+            + juce::String(moduleLoadMs, 1) + " ms)");
+    return true;
+}
+
+std::unique_ptr<juce::AudioPluginInstance> PluginInstancePool::takeResidentInstance()
+{
+    return std::move(resident);
+}
+
+} // namespace serum
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "vst/PluginFactory.h"
+#include <memory>
+#include <vector>
+
+namespace serum {
+
+/**
+ * Creates many instances of one plugin at once, ready to render
+ *
+ * The pool's first instance stays resident until handed out with
+ * takeResidentInstance(), so the plugin's module is loaded and initialised
+ * once instead of per instance. Further instances are created on several
+ * threads and prepared for playback (prepareToPlay, non-realtime) at the
+ * pool's sample rate and block size on the thread that created them. Formats
+ * that create instances on the message thread (VST3) still do so one at a
+ * time; the calling thread services those requests while it waits.
+ */
+class PluginInstancePool
+{
+public:
+    /**
+     * Constructor
+     * @param factory Factory to create instances with, must outlive the pool
+     * @param desc Plugin to instantiate
+     * @param sampleRate Sample rate every instance is prepared for
+     * @param blockSize Block size every instance is prepared for
+     */
+    PluginInstancePool(PluginFactory& factory, const juce::PluginDescription& desc,
+                       double sampleRate, int blockSize);
+    ~PluginInstancePool();
+
+    /**
+     * Create the resident instance, loading the plugin's module
+     * Called by createInstances() when needed
+     * @return false with errorMsg set on failure
+     */
+    bool loadModule(juce::String& errorMsg);
+
+    /**
+     * Create prepared instances
+     * @param count Number of instances, not counting the resident one
+     * @param instances Receives the instances in order
+     * @param errorMsg Error message of the first failure
+     * @param numThreads Instances created at once; 0 = one per CPU core
+     * @return false if any instance failed, in which case instances is empty
+     */
+    bool createInstances(int count, std::vector<std::unique_ptr<juce::AudioPluginInstance>>& instances,
+                         juce::String& errorMsg, int numThreads = 0);
+
+    /**
+     * Hand over the resident instance, prepared like the others
+     * Once it is gone the module stays loaded only while other instances live.
+     * @return nullptr if loadModule() has not succeeded
+     */
+    std::unique_ptr<juce::AudioPluginInstance> takeResidentInstance();
+
+    double getSampleRate() const { return sampleRate; }
+    int getBlockSize() const { return blockSize; }
+
+    /**
+     * Milliseconds to create and prepare the resident instance, including the module load
+     */
+    double getModuleLoadMilliseconds() const { return moduleLoadMs; }
+
+    /**
+     * Milliseconds to create and prepare each instance of the last createInstances() call
+     */
+    const std::vector<double>& getCreationMilliseconds() const { return creationMs; }
+
+private:
+    PluginFactory& factory;
+    juce::PluginDescription desc;
+    double sampleRate;
+    int blockSize;
+
+    std::unique_ptr<juce::AudioPluginInstance> resident;
+    double moduleLoadMs = 0.0;
+    std::vector<double> creationMs;
+
+    std::unique_ptr<juce::AudioPluginInstance> createPrepared(juce::String& errorMsg, double& elapsedMs);
+
+    JUCE_DECLARE_NON_COPYABLE(PluginInstancePool)
+};
+
+} // namespace serum
@@ -1,9 +1,85 @@
 #include "vst/PluginScanner.h"
 #include "common/Log.h"
+#include <atomic>
+#include <thread>
 
 namespace serum {
 
-PluginScanner::PluginScanner()
+namespace {
+
+constexpr int cacheMagic = 0x43505253;  // "SRPC"
+constexpr int cacheVersion = 1;
+constexpr int maxTypesPerBundle = 4096;
+
+const juce::String scanBundleOption = "--scan-plugin-bundle";
+const juce::String scanOutputOption = "--scan-output";
+
+#if JUCE_WINDOWS
+const juce::String searchPathSeparator = ";";
+#else
+const juce::String searchPathSeparator = ":";
+#endif
+
+void writeDescription(juce::OutputStream& out, const juce::PluginDescription& desc)
+{
+    out.writeString(desc.name);
+    out.writeString(desc.descriptiveName);
+    out.writeString(desc.pluginFormatName);
+    out.writeString(desc.category);
+    out.writeString(desc.manufacturerName);
+    out.writeString(desc.version);
+    out.writeString(desc.fileOrIdentifier);
+    out.writeInt64(desc.lastFileModTime.toMilliseconds());
+    out.writeInt64(desc.lastInfoUpdateTime.toMilliseconds());
+    out.writeInt(desc.deprecatedUid);
+    out.writeInt(desc.uniqueId);
+    out.writeBool(desc.isInstrument);
+    out.writeInt(desc.numInputChannels);
+    out.writeInt(desc.numOutputChannels);
+    out.writeBool(desc.hasSharedContainer);
+#if JUCE_MAJOR_VERSION >= 7
+    out.writeBool(desc.hasARAExtension);
+#else
+    out.writeBool(false);
+#endif
+}
+
+juce::PluginDescription readDescription(juce::InputStream& in)
+{
+    juce::PluginDescription desc;
+    desc.name = in.readString();
+    desc.descriptiveName = in.readString();
+    desc.pluginFormatName = in.readString();
+    desc.category = in.readString();
+    desc.manufacturerName = in.readString();
+    desc.version = in.readString();
+    desc.fileOrIdentifier = in.readString();
+    desc.lastFileModTime = juce::Time(in.readInt64());
+    desc.lastInfoUpdateTime = juce::Time(in.readInt64());
+    desc.deprecatedUid = in.readInt();
+    desc.uniqueId = in.readInt();
+    desc.isInstrument = in.readBool();
+    desc.numInputChannels = in.readInt();
+    desc.numOutputChannels = in.readInt();
+    desc.hasSharedContainer = in.readBool();
+#if JUCE_MAJOR_VERSION >= 7
+    desc.hasARAExtension = in.readBool();
+#else
+    in.readBool();
+#endif
+    return desc;
+}
+
+void addToFingerprint(const juce::DirectoryEntry& entry, int64& modificationTime, int64& size)
+{
+    modificationTime = juce::jmax(modificationTime, entry.getModificationTime().toMilliseconds());
+    size += entry.getFileSize();
+}
+
+} // namespace
+
+PluginScanner::PluginScanner(const PluginScanOptions& options)
+    : options(options)
 {
 }
 
@@ -11,77 +87,381 @@ PluginScanner::~PluginScanner()
 {
 }
 
-juce::File PluginScanner::getCacheFile()
+juce::File PluginScanner::getCacheFile() const
 {
-    return juce::File::getCurrentWorkingDirectory().getChildFile("plugin_cache.xml");
+    if (options.cacheFile != juce::File())
+        return options.cacheFile;
+
+    return juce::File::getCurrentWorkingDirectory().getChildFile("plugin_cache.bin");
 }
 
 bool PluginScanner::loadOrScan()
+{
+    if (loadCache())
+        logInfo("Loaded " + juce::String(pluginList.getNumTypes()) + " plugins from cache, checking for changes");
+    else
+        logInfo("No valid cache found, scanning VST3 plugins...");
+
+    if (scan(true))
+        saveCache();
+
+    return pluginList.getNumTypes() > 0;
+}
+
+void PluginScanner::rescan()
+{
+    scan(false);
+}
+
+bool PluginScanner::loadCache()
 {
     auto cacheFile = getCacheFile();
-    
-    if (cacheFile.existsAsFile())
+    juce::MemoryBlock data;
+    if (!cacheFile.existsAsFile() || !cacheFile.loadFileAsData(data))
+        return false;
+
+    logInfo("Loading plugin cache from: " + cacheFile.getFullPathName());
+
+    juce::MemoryInputStream in(data, false);
+    if (in.readInt() != cacheMagic || in.readInt() != cacheVersion)
+    {
+        logWarning("Plugin cache has an unknown format, will rescan");
+        return false;
+    }
+
+    std::map<juce::String, Bundle> loaded;
+    const int numBundles = in.readInt();
+    for (int i = 0; i < numBundles && !in.isExhausted(); ++i)
     {
-        logInfo("Loading plugin cache from: " + cacheFile.getFullPathName());
-        auto xml = juce::parseXML(cacheFile);
-        if (xml != nullptr)
+        auto path = in.readString();
+        Bundle bundle;
+        bundle.modificationTime = in.readInt64();
+        bundle.size = in.readInt64();
+        bundle.failed = in.readBool();
+
+        const int numTypes = in.readInt();
+        if (numTypes < 0 || numTypes > maxTypesPerBundle)
+            break;
+
+        for (int t = 0; t < numTypes; ++t)
+            bundle.types.push_back(readDescription(in));
+
+        loaded[path] = std::move(bundle);
+    }
+
+    // The trailing marker catches truncated files, which read as zeros
+    if (in.readInt() != cacheMagic)
+    {
+        logWarning("Plugin cache is damaged, will rescan");
+        return false;
+    }
+
+    bundles = std::move(loaded);
+    rebuildPluginList();
+    return true;
+}
+
+void PluginScanner::saveCache()
+{
+    auto cacheFile = getCacheFile();
+
+    juce::MemoryOutputStream out;
+    out.writeInt(cacheMagic);
+    out.writeInt(cacheVersion);
+    out.writeInt(static_cast<int>(bundles.size()));
+
+    for (const auto& [path, bundle] : bundles)
+    {
+        out.writeString(path);
+        out.writeInt64(bundle.modificationTime);
+        out.writeInt64(bundle.size);
+        out.writeBool(bundle.failed);
+        out.writeInt(static_cast<int>(bundle.types.size()));
+
+        for (const auto& desc : bundle.types)
+            writeDescription(out, desc);
+    }
+
+    out.writeInt(cacheMagic);
+
+    if (cacheFile.replaceWithData(out.getData(), out.getDataSize()))
+    {
+        logInfo("Saved plugin cache to: " + cacheFile.getFullPathName());
+    }
+    else
+    {
+        logError("Failed to save plugin cache");
+    }
+}
+
+bool PluginScanner::scan(bool useCache)
+{
+    const double startMs = juce::Time::getMillisecondCounterHiRes();
+
+    juce::VST3PluginFormat vst3Format;
+    juce::StringArray found;
+    for (const auto& dir : getSearchPaths())
+    {
+        logInfo("Scanning VST3 directory: " + dir);
+        found.addArray(vst3Format.searchPathsForPlugins(juce::FileSearchPath(dir), true));
+    }
+    found.removeDuplicates(false);
+
+    int removed = 0;
+    for (const auto& [path, bundle] : bundles)
+        if (!found.contains(path))
+            ++removed;
+
+    // Reuse every bundle whose fingerprint is unchanged
+    std::map<juce::String, Bundle> current;
+    juce::StringArray toScan;
+    for (const auto& path : found)
+    {
+        auto fingerprint = fingerprintBundle(juce::File(path));
+        auto cached = bundles.find(path);
+
+        if (useCache && cached != bundles.end()
+            && cached->second.modificationTime == fingerprint.modificationTime
+            && cached->second.size == fingerprint.size)
+        {
+            current[path] = std::move(cached->second);
+        }
+        else
         {
-            pluginList.recreateFromXml(*xml);
-            logInfo("Loaded " + juce::String(pluginList.getNumTypes()) + " plugins from cache");
-            return pluginList.getNumTypes() > 0;
+            current[path] = std::move(fingerprint);
+            toScan.add(path);
         }
-        logWarning("Failed to parse plugin cache, will rescan");
     }
-    
-    logInfo("No valid cache found, scanning VST3 plugins...");
-    scanDefaultLocations();
-    saveCache();
-    
-    return pluginList.getNumTypes() > 0;
+
+    if (!toScan.isEmpty())
+    {
+        std::vector<Bundle> results(static_cast<size_t>(toScan.size()));
+        scanBundles(toScan, results);
+
+        for (int i = 0; i < toScan.size(); ++i)
+        {
+            auto& bundle = current[toScan[i]];
+            bundle.failed = results[static_cast<size_t>(i)].failed;
+            bundle.types = std::move(results[static_cast<size_t>(i)].types);
+        }
+    }
+
+    bundles = std::move(current);
+    rebuildPluginList();
+
+    logInfo("Scan complete. Found " + juce::String(pluginList.getNumTypes()) + " plugins in "
+            + juce::String(static_cast<int>(bundles.size())) + " bundles ("
+            + juce::String(toScan.size()) + " scanned, " + juce::String(removed) + " removed) in "
+            + juce::String((juce::Time::getMillisecondCounterHiRes() - startMs) / 1000.0, 2) + "s");
+
+    return !toScan.isEmpty() || removed > 0;
 }
 
-void PluginScanner::scanDefaultLocations()
+void PluginScanner::rebuildPluginList()
 {
-    juce::VST3PluginFormat vst3Format;
-    
-    // Default Windows VST3 path
-    juce::String defaultPath = "C:\\Program Files\\Common Files\\VST3";
-    
-    logInfo("Scanning VST3 directory: " + defaultPath);
-    
-    juce::PluginDirectoryScanner scanner(
-        pluginList,
-        vst3Format,
-        juce::FileSearchPath(defaultPath),
-        true,  // recursive
-        juce::File()  // dead mans pedal file (unused)
-    );
-    
-    juce::String pluginBeingScanned;
-    while (scanner.scanNextFile(true, pluginBeingScanned))
-    {
-        logInfo("Scanning: " + pluginBeingScanned);
-    }
-    
-    logInfo("Scan complete. Found " + juce::String(pluginList.getNumTypes()) + " plugins");
+    pluginList.clear();
+
+    for (const auto& [path, bundle] : bundles)
+        for (const auto& desc : bundle.types)
+            pluginList.addType(desc);
 }
 
-void PluginScanner::saveCache()
+void PluginScanner::scanBundles(const juce::StringArray& paths, std::vector<Bundle>& results)
 {
-    auto cacheFile = getCacheFile();
-    auto xml = pluginList.createXml();
-    
-    if (xml != nullptr)
+    if (!options.outOfProcess)
     {
-        if (xml->writeToFile(cacheFile, {}))
+        // Plugins are not guaranteed to load safely from several threads, so one at a time
+        for (int i = 0; i < paths.size(); ++i)
         {
-            logInfo("Saved plugin cache to: " + cacheFile.getFullPathName());
+            logInfo("Scanning: " + paths[i]);
+            scanBundleInProcess(paths[i], results[static_cast<size_t>(i)]);
         }
-        else
+        return;
+    }
+
+    const int numJobs = juce::jlimit(1, paths.size(),
+                                     options.numJobs > 0 ? options.numJobs : juce::SystemStats::getNumCpus());
+    logInfo("Scanning " + juce::String(paths.size()) + " bundles in " + juce::String(numJobs) + " processes");
+
+    // Unique per scan, so concurrent scanners on one machine never share output files
+    auto tempDir = juce::File::getSpecialLocation(juce::File::tempDirectory);
+    auto tag = juce::String::toHexString(juce::Random::getSystemRandom().nextInt64());
+
+    std::atomic<int> next { 0 };
+    std::vector<std::thread> threads;
+    for (int j = 0; j < numJobs; ++j)
+    {
+        threads.emplace_back([&]
+        {
+            for (int i = next++; i < paths.size(); i = next++)
+            {
+                auto outputFile = tempDir.getChildFile("serum-scan-" + tag + "-" + juce::String(i) + ".xml");
+                logInfo("Scanning: " + paths[i]);
+                scanBundleOutOfProcess(paths[i], outputFile, results[static_cast<size_t>(i)]);
+                outputFile.deleteFile();
+            }
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+}
+
+bool PluginScanner::scanBundleInProcess(const juce::String& path, Bundle& result)
+{
+    juce::VST3PluginFormat vst3Format;
+    juce::OwnedArray<juce::PluginDescription> found;
+    vst3Format.findAllTypesForFile(found, path);
+
+    for (auto* desc : found)
+        result.types.push_back(*desc);
+
+    return true;
+}
+
+bool PluginScanner::scanBundleOutOfProcess(const juce::String& path, const juce::File& outputFile, Bundle& result)
+{
+    auto executable = juce::File::getSpecialLocation(juce::File::currentExecutableFile);
+    juce::StringArray command { executable.getFullPathName(), scanBundleOption, path,
+                                scanOutputOption, outputFile.getFullPathName() };
+
+    // Plugin output is discarded: an unread pipe could fill up and stall the child
+    juce::ChildProcess process;
+    if (!process.start(command, 0))
+    {
+        logError("Cannot launch scan process for " + path);
+        result.failed = true;
+        return false;
+    }
+
+    if (!process.waitForProcessToFinish(juce::roundToInt(options.bundleTimeoutSec * 1000.0)))
+    {
+        process.kill();
+        logWarning("Scan of " + path + " timed out after " + juce::String(options.bundleTimeoutSec, 0)
+                   + "s; skipped until it changes");
+        result.failed = true;
+        return false;
+    }
+
+    const auto exitCode = process.getExitCode();
+    auto xml = exitCode == 0 ? juce::parseXML(outputFile) : nullptr;
+    if (xml == nullptr)
+    {
+        logWarning("Scan of " + path + " failed (exit code " + juce::String(exitCode)
+                   + "); skipped until it changes");
+        result.failed = true;
+        return false;
+    }
+
+    for (auto* element : xml->getChildIterator())
+    {
+        juce::PluginDescription desc;
+        if (desc.loadFromXml(*element))
+            result.types.push_back(desc);
+    }
+
+    return true;
+}
+
+PluginScanner::Bundle PluginScanner::fingerprintBundle(const juce::File& bundle)
+{
+    Bundle fingerprint;
+    fingerprint.modificationTime = bundle.getLastModificationTime().toMilliseconds();
+
+    if (!bundle.isDirectory())
+    {
+        fingerprint.size = bundle.getSize();
+        return fingerprint;
+    }
+
+    // Binaries and moduleinfo.json live under Contents/; Resources/ can hold
+    // thousands of files that never affect the scan, so it is skipped
+    auto contents = bundle.getChildFile("Contents");
+    for (const auto& entry : juce::RangedDirectoryIterator(contents, false, "*", juce::File::findFilesAndDirectories))
+    {
+        if (!entry.isDirectory())
         {
-            logError("Failed to save plugin cache");
+            addToFingerprint(entry, fingerprint.modificationTime, fingerprint.size);
+            continue;
         }
+
+        if (entry.getFile().getFileName() == "Resources")
+            continue;
+
+        for (const auto& inner : juce::RangedDirectoryIterator(entry.getFile(), true, "*", juce::File::findFiles))
+            addToFingerprint(inner, fingerprint.modificationTime, fingerprint.size);
     }
+
+    return fingerprint;
+}
+
+juce::StringArray PluginScanner::getSearchPaths() const
+{
+    juce::StringArray candidates(options.searchPaths);
+    if (options.includeDefaultPaths)
+        candidates.addArray(getDefaultSearchPaths());
+
+    juce::StringArray paths;
+    for (const auto& candidate : candidates)
+    {
+        auto dir = juce::File::getCurrentWorkingDirectory().getChildFile(candidate);
+        if (dir.isDirectory())
+            paths.addIfNotAlreadyThere(dir.getFullPathName());
+    }
+
+    return paths;
+}
+
+juce::StringArray PluginScanner::splitSearchPath(const juce::String& searchPath)
+{
+    auto paths = juce::StringArray::fromTokens(searchPath, searchPathSeparator, "");
+    paths.trim();
+    paths.removeEmptyStrings();
+    return paths;
+}
+
+juce::StringArray PluginScanner::getDefaultSearchPaths()
+{
+    auto paths = splitSearchPath(juce::SystemStats::getEnvironmentVariable("SERUM_VST3_PATH", {}));
+    auto home = juce::File::getSpecialLocation(juce::File::userHomeDirectory);
+
+#if JUCE_WINDOWS
+    paths.add("C:\\Program Files\\Common Files\\VST3");
+    paths.add(juce::File::getSpecialLocation(juce::File::windowsLocalAppData)
+                  .getChildFile("Programs\\Common\\VST3").getFullPathName());
+#elif JUCE_MAC
+    paths.add(home.getChildFile("Library/Audio/Plug-Ins/VST3").getFullPathName());
+    paths.add("/Library/Audio/Plug-Ins/VST3");
+#else
+    paths.add(home.getChildFile(".vst3").getFullPathName());
+    paths.add("/usr/lib/vst3");
+    paths.add("/usr/local/lib/vst3");
+#endif
+
+    return paths;
+}
+
+bool PluginScanner::isScanWorkerCommandLine(const juce::ArgumentList& args)
+{
+    return args.containsOption(scanBundleOption);
+}
+
+int PluginScanner::runScanWorker(const juce::ArgumentList& args)
+{
+    auto path = args.getValueForOption(scanBundleOption);
+    auto outputPath = args.getValueForOption(scanOutputOption);
+    if (path.isEmpty() || !juce::File::isAbsolutePath(outputPath))
+        return 1;
+
+    juce::VST3PluginFormat vst3Format;
+    juce::OwnedArray<juce::PluginDescription> found;
+    vst3Format.findAllTypesForFile(found, path);
+
+    juce::XmlElement xml("PLUGINS");
+    for (auto* desc : found)
+        xml.addChildElement(desc->createXml().release());
+
+    return xml.writeTo(juce::File(outputPath)) ? 0 : 1;
 }
 
 juce::PluginDescription* PluginScanner::findSerum2()
@@ -95,7 +475,7 @@ juce::PluginDescription* PluginScanner::findSerum2()
             return desc;
         }
     }
-    
+
     logError("Serum plugin not found in plugin list");
     return nullptr;
 }
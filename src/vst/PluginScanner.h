@@ -1,49 +1,118 @@
 #pragma once
 
 #include <JuceHeader.h>
+#include <map>
 #include <memory>
+#include <vector>
 
 namespace serum {
 
+/**
+ * Where and how PluginScanner looks for VST3 bundles
+ */
+struct PluginScanOptions
+{
+    juce::StringArray searchPaths;      // Searched before the default locations
+    bool includeDefaultPaths = true;    // $SERUM_VST3_PATH and the platform's VST3 folders
+    int numJobs = 0;                    // Bundles scanned at once; 0 = one per CPU core
+    bool outOfProcess = true;           // Scan each bundle in a child process (see runScanWorker())
+    double bundleTimeoutSec = 60.0;     // Out of process: give up on a bundle after this long
+    juce::File cacheFile;               // Default plugin_cache.bin in the working directory
+};
+
 /**
  * Scans for VST3 plugins and caches results
+ *
+ * Results are cached per bundle together with the bundle's modification time
+ * and size, so a rescan only inspects bundles that are new or have changed
+ * and drops the ones that disappeared. Bundles are inspected in child
+ * processes, several at once; a bundle whose scan crashes or hangs is
+ * remembered as failed until it changes. The cache is a compact binary file.
  */
 class PluginScanner
 {
 public:
-    PluginScanner();
+    PluginScanner(const PluginScanOptions& options = {});
     ~PluginScanner();
-    
+
     /**
-     * Load plugin list from cache if available, otherwise scan and save cache
-     * @return true if plugins are available (from cache or scan)
+     * Load the cache, then rescan only new or changed bundles (saving the cache if anything changed)
+     * @return true if plugins are available
      */
     bool loadOrScan();
-    
+
     /**
-     * Scan default VST3 directories
+     * Scan every bundle in the search paths, ignoring cached results
      */
-    void scanDefaultLocations();
-    
+    void rescan();
+
     /**
      * Save current plugin list to cache
      */
     void saveCache();
-    
+
     /**
      * Find Serum2 plugin by name
      * @return PluginDescription if found, nullptr otherwise
      */
     juce::PluginDescription* findSerum2();
-    
+
     /**
      * Get the known plugin list
      */
     juce::KnownPluginList& getPluginList() { return pluginList; }
-    
+
+    /**
+     * Existing directories searched, in order
+     */
+    juce::StringArray getSearchPaths() const;
+
+    /**
+     * $SERUM_VST3_PATH entries, then the platform's VST3 folders
+     * (~/.vst3, /usr/lib/vst3 and /usr/local/lib/vst3 on Linux)
+     */
+    static juce::StringArray getDefaultSearchPaths();
+
+    /**
+     * Split a search path list (":"-separated, ";" on Windows)
+     */
+    static juce::StringArray splitSearchPath(const juce::String& searchPath);
+
+    /**
+     * True if the command line asks this process to scan one bundle for a parent scanner
+     * Executables that scan out of process must check this first thing in main().
+     */
+    static bool isScanWorkerCommandLine(const juce::ArgumentList& args);
+
+    /**
+     * Scan the bundle named on the command line and write its descriptions for the parent
+     * @return process exit code
+     */
+    static int runScanWorker(const juce::ArgumentList& args);
+
 private:
+    struct Bundle
+    {
+        int64 modificationTime = 0;     // Milliseconds since the epoch
+        int64 size = 0;
+        bool failed = false;            // Scan crashed or hung
+        std::vector<juce::PluginDescription> types;
+    };
+
+    PluginScanOptions options;
     juce::KnownPluginList pluginList;
-    juce::File getCacheFile();
+    std::map<juce::String, Bundle> bundles;     // By bundle path
+
+    juce::File getCacheFile() const;
+    bool loadCache();
+    bool scan(bool useCache);  // True if the bundle list changed
+    void rebuildPluginList();
+
+    void scanBundles(const juce::StringArray& paths, std::vector<Bundle>& results);
+    bool scanBundleInProcess(const juce::String& path, Bundle& result);
+    bool scanBundleOutOfProcess(const juce::String& path, const juce::File& outputFile, Bundle& result);
+
+    static Bundle fingerprintBundle(const juce::File& bundle);
 };
 
 } // namespace serum
@@ -49,10 +49,23 @@ bool PresetStateIO::loadState(juce::AudioPluginInstance& plugin, const juce::Fil
         return false;
     }
     
-    plugin.setStateInformation(stateData.getData(), static_cast<int>(stateData.getSize()));
+    if (!applyState(plugin, stateData.getData(), stateData.getSize()))
+        return false;
     
     logInfo("Loaded " + juce::String(stateData.getSize()) + " bytes");
     return true;
 }
 
+bool PresetStateIO::applyState(juce::AudioPluginInstance& plugin, const void* data, size_t size)
+{
+    if (data == nullptr || size == 0 || size > static_cast<size_t>(std::numeric_limits<int>::max()))
+    {
+        logError("Invalid plugin state size: " + juce::String(static_cast<int64>(size)));
+        return false;
+    }
+    
+    plugin.setStateInformation(data, static_cast<int>(size));
+    return true;
+}
+
 } // namespace serum
@@ -25,6 +25,15 @@ public:
      * @return true if successful
      */
     static bool loadState(juce::AudioPluginInstance& plugin, const juce::File& inputFile);
+    
+    /**
+     * Apply state already in memory (e.g. from PresetStateStore)
+     * @param plugin Plugin instance
+     * @param data State bytes
+     * @param size Number of bytes
+     * @return true if successful
+     */
+    static bool applyState(juce::AudioPluginInstance& plugin, const void* data, size_t size);
 };
 
 } // namespace serum
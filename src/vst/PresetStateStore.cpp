@@ -0,0 +1,106 @@
+#include "vst/PresetStateStore.h"
+#include "common/Log.h"
+
+namespace serum {
+
+int PresetStateStore::scan(const juce::File& directory)
+{
+    auto files = directory.findChildFiles(juce::File::findFiles, true, "*.bin");
+    files.sort();
+
+    int added = 0;
+    for (const auto& file : files)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (addFile(file) != nullptr)
+            ++added;
+    }
+
+    logInfo("Preset state store: " + juce::String(getNumFiles()) + " files, "
+            + juce::String(getNumBlobs()) + " distinct states, "
+            + juce::String(static_cast<double>(getPoolBytes()) / (1024.0 * 1024.0), 1) + " MB");
+    return added;
+}
+
+const PresetStateBlob* PresetStateStore::getState(const juce::File& stateFile)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+
+    auto it = blobsByPath.find(stateFile.getFullPathName());
+    if (it != blobsByPath.end())
+        return it->second;
+
+    return addFile(stateFile);
+}
+
+int PresetStateStore::getNumFiles() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(blobsByPath.size());
+}
+
+int PresetStateStore::getNumBlobs() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return static_cast<int>(blobs.size());
+}
+
+size_t PresetStateStore::getPoolBytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return poolBytes;
+}
+
+void* PresetStateStore::allocate(size_t size)
+{
+    // States larger than a chunk get a chunk of their own
+    if (chunks.empty() || chunkUsed + size > chunks.back()->getSize())
+    {
+        chunks.push_back(std::make_unique<juce::MemoryBlock>(juce::jmax(chunkSize, size)));
+        chunkUsed = 0;
+    }
+
+    auto* data = static_cast<char*>(chunks.back()->getData()) + chunkUsed;
+    chunkUsed += size;
+    poolBytes += size;
+    return data;
+}
+
+const PresetStateBlob* PresetStateStore::addFile(const juce::File& stateFile)
+{
+    juce::MemoryMappedFile mapped(stateFile, juce::MemoryMappedFile::readOnly);
+    if (mapped.getData() == nullptr || mapped.getSize() == 0)
+    {
+        logError("Failed to read state file: " + stateFile.getFullPathName());
+        return nullptr;
+    }
+
+    auto hash = computeFastHash128(mapped.getData(), mapped.getSize());
+    auto key = std::make_pair(hash.low, hash.high);
+
+    const PresetStateBlob* blob = nullptr;
+    auto existing = blobsByHash.find(key);
+    if (existing != blobsByHash.end() && existing->second->size == mapped.getSize())
+    {
+        blob = existing->second;
+    }
+    else
+    {
+        auto newBlob = std::make_unique<PresetStateBlob>();
+        newBlob->size = mapped.getSize();
+        newBlob->hash = hash;
+
+        void* data = allocate(newBlob->size);
+        std::memcpy(data, mapped.getData(), newBlob->size);
+        newBlob->data = data;
+
+        blob = newBlob.get();
+        blobsByHash[key] = blob;
+        blobs.push_back(std::move(newBlob));
+    }
+
+    blobsByPath[stateFile.getFullPathName()] = blob;
+    return blob;
+}
+
+} // namespace serum
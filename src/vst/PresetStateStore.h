@@ -0,0 +1,74 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include "common/Hash.h"
+#include <map>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace serum {
+
+/**
+ * One distinct preset state, held in the store's pool
+ */
+struct PresetStateBlob
+{
+    const void* data = nullptr;
+    size_t size = 0;
+    Hash128 hash;   // Identical states share one blob
+};
+
+/**
+ * In-memory pool of preset states
+ *
+ * scan() reads every .bin under a directory once into large pooled chunks;
+ * files with identical contents share a single blob. Blobs never move, so
+ * pointers stay valid for the store's lifetime. Files outside the scanned set
+ * are loaded on first use. Thread safe.
+ */
+class PresetStateStore
+{
+public:
+    PresetStateStore() = default;
+
+    /**
+     * Load every .bin file below directory (recursively)
+     * @return number of files added
+     */
+    int scan(const juce::File& directory);
+
+    /**
+     * Blob for a state file, loaded into the pool if it was not scanned
+     * @return nullptr if the file cannot be read or is empty
+     */
+    const PresetStateBlob* getState(const juce::File& stateFile);
+
+    /**
+     * Number of files and of distinct blobs held
+     */
+    int getNumFiles() const;
+    int getNumBlobs() const;
+
+    /**
+     * Bytes held in the pool
+     */
+    size_t getPoolBytes() const;
+
+private:
+    static constexpr size_t chunkSize = 16 * 1024 * 1024;
+
+    mutable std::mutex mutex;
+    std::vector<std::unique_ptr<juce::MemoryBlock>> chunks;
+    size_t chunkUsed = 0;
+    size_t poolBytes = 0;
+
+    std::vector<std::unique_ptr<PresetStateBlob>> blobs;
+    std::map<std::pair<uint64, uint64>, const PresetStateBlob*> blobsByHash;
+    std::map<juce::String, const PresetStateBlob*> blobsByPath;
+
+    const PresetStateBlob* addFile(const juce::File& stateFile);
+    void* allocate(size_t size);
+};
+
+} // namespace serum
@@ -0,0 +1,271 @@
+#include "vst/ReferenceSynth.h"
+
+namespace serum {
+
+const char* const ReferenceSynth::formatName = "Internal";
+
+static constexpr int stateMagic = 0x52534e31;    // "RSN1": gain, release
+static constexpr int stateMagicV2 = 0x52534e32;  // "RSN2": gain, ADSR, harmonics
+
+// Level at which a releasing voice is freed (-60 dB)
+static constexpr float silenceLevel = 0.001f;
+
+/**
+ * Per-sample multiplier that falls by 60 dB over the given time
+ */
+static float getSixtyDbCoefficient(float seconds, double sampleRate)
+{
+    if (seconds <= 0.0f)
+        return 0.0f;
+
+    return static_cast<float>(std::pow(0.001, 1.0 / (static_cast<double>(seconds) * sampleRate)));
+}
+
+ReferenceSynth::ReferenceSynth()
+    : juce::AudioPluginInstance(BusesProperties()
+        .withOutput("Output", juce::AudioChannelSet::stereo(), true))
+{
+}
+
+ReferenceSynth::~ReferenceSynth()
+{
+}
+
+juce::PluginDescription ReferenceSynth::createDescription()
+{
+    juce::PluginDescription desc;
+    desc.name = "Reference Synth";
+    desc.descriptiveName = "Deterministic additive synth standing in for Serum2";
+    desc.pluginFormatName = formatName;
+    desc.category = "Synth";
+    desc.manufacturerName = "serum-renderer";
+    desc.version = "1.1.0";
+    desc.fileOrIdentifier = "internal:reference-synth";
+    desc.uniqueId = stateMagic;
+    desc.isInstrument = true;
+    desc.numInputChannels = 0;
+    desc.numOutputChannels = 2;
+    return desc;
+}
+
+void ReferenceSynth::fillInPluginDescription(juce::PluginDescription& description) const
+{
+    description = createDescription();
+}
+
+void ReferenceSynth::setNumHarmonics(int harmonics)
+{
+    numHarmonics = juce::jlimit(1, maxHarmonics, harmonics);
+}
+
+void ReferenceSynth::setEnvelope(float attack, float decay, float sustain, float release)
+{
+    attackSec = juce::jmax(0.0f, attack);
+    decaySec = juce::jmax(0.0f, decay);
+    sustainLevel = juce::jlimit(0.0f, 1.0f, sustain);
+    releaseSec = juce::jmax(0.0f, release);
+    updateEnvelope();
+}
+
+void ReferenceSynth::updateEnvelope()
+{
+    attackStep = attackSec > 0.0f ? static_cast<float>(1.0 / (attackSec * currentSampleRate)) : 1.0f;
+    decayCoefficient = getSixtyDbCoefficient(decaySec, currentSampleRate);
+    releaseCoefficient = getSixtyDbCoefficient(releaseSec, currentSampleRate);
+}
+
+void ReferenceSynth::prepareToPlay(double sampleRate, int)
+{
+    currentSampleRate = sampleRate;
+    updateEnvelope();
+    reset();
+}
+
+void ReferenceSynth::releaseResources()
+{
+}
+
+void ReferenceSynth::reset()
+{
+    for (auto& voice : voices)
+        voice = Voice();
+}
+
+void ReferenceSynth::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi)
+{
+    buffer.clear();
+
+    int position = 0;
+    const int numSamples = buffer.getNumSamples();
+
+    // Render up to each event so note-ons and note-offs are sample accurate
+    for (const auto metadata : midi)
+    {
+        int eventPosition = juce::jlimit(0, numSamples, metadata.samplePosition);
+        renderVoices(buffer, position, eventPosition - position);
+        handleMidiEvent(metadata.getMessage());
+        position = eventPosition;
+    }
+
+    renderVoices(buffer, position, numSamples - position);
+}
+
+void ReferenceSynth::handleMidiEvent(const juce::MidiMessage& message)
+{
+    if (message.isNoteOn())
+    {
+        // Take a free voice, otherwise steal the first one
+        Voice* target = &voices[0];
+        for (auto& voice : voices)
+        {
+            if (voice.note < 0)
+            {
+                target = &voice;
+                break;
+            }
+        }
+
+        target->note = message.getNoteNumber();
+        target->stage = Stage::Attack;
+        target->level = 0.0f;
+        target->gain = gain * message.getFloatVelocity();
+        target->phase = 0.0;
+        target->phaseDelta = juce::MathConstants<double>::twoPi
+            * juce::MidiMessage::getMidiNoteInHertz(target->note) / currentSampleRate;
+    }
+    else if (message.isNoteOff())
+    {
+        for (auto& voice : voices)
+        {
+            if (voice.note == message.getNoteNumber())
+                voice.stage = Stage::Release;
+        }
+    }
+    else if (message.isAllNotesOff() || message.isAllSoundOff())
+    {
+        reset();
+    }
+}
+
+float ReferenceSynth::advanceEnvelope(Voice& voice) const
+{
+    switch (voice.stage)
+    {
+        case Stage::Attack:
+            voice.level += attackStep;
+            if (voice.level >= 1.0f)
+            {
+                voice.level = 1.0f;
+                voice.stage = Stage::Decay;
+            }
+            break;
+
+        case Stage::Decay:
+            voice.level = sustainLevel + (voice.level - sustainLevel) * decayCoefficient;
+            if (voice.level - sustainLevel < silenceLevel * 0.1f)
+            {
+                voice.level = sustainLevel;
+                voice.stage = Stage::Sustain;
+            }
+            break;
+
+        case Stage::Sustain:
+            break;
+
+        case Stage::Release:
+            voice.level *= releaseCoefficient;
+            break;
+    }
+
+    return voice.level;
+}
+
+void ReferenceSynth::renderVoices(juce::AudioBuffer<float>& buffer, int startSample, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    const int numChannels = buffer.getNumChannels();
+
+    for (auto& voice : voices)
+    {
+        if (voice.note < 0)
+            continue;
+
+        // 1/h amplitudes, normalized, without partials above Nyquist
+        int harmonics = juce::jlimit(1, numHarmonics,
+                                     static_cast<int>(juce::MathConstants<double>::pi / voice.phaseDelta));
+        float harmonicNorm = 0.0f;
+        for (int h = 1; h <= harmonics; ++h)
+            harmonicNorm += 1.0f / static_cast<float>(h);
+        harmonicNorm = 1.0f / harmonicNorm;
+
+        float* left = buffer.getWritePointer(0, startSample);
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float envelope = advanceEnvelope(voice);
+
+            double sample = 0.0;
+            for (int h = 1; h <= harmonics; ++h)
+                sample += std::sin(voice.phase * h) / h;
+
+            left[i] += voice.gain * envelope * harmonicNorm * static_cast<float>(sample);
+            voice.phase += voice.phaseDelta;
+
+            if (voice.stage == Stage::Release && voice.level < silenceLevel)
+            {
+                voice = Voice();
+                break;
+            }
+        }
+
+        if (voice.phase > juce::MathConstants<double>::twoPi)
+            voice.phase = std::fmod(voice.phase, juce::MathConstants<double>::twoPi);
+    }
+
+    // Output is mono-centred; copy to the remaining channels
+    for (int ch = 1; ch < numChannels; ++ch)
+        buffer.copyFrom(ch, startSample, buffer, 0, startSample, numSamples);
+}
+
+void ReferenceSynth::getStateInformation(juce::MemoryBlock& destData)
+{
+    juce::MemoryOutputStream stream(destData, false);
+    stream.writeInt(stateMagicV2);
+    stream.writeFloat(gain);
+    stream.writeFloat(attackSec);
+    stream.writeFloat(decaySec);
+    stream.writeFloat(sustainLevel);
+    stream.writeFloat(releaseSec);
+    stream.writeInt(numHarmonics);
+}
+
+void ReferenceSynth::setStateInformation(const void* data, int sizeInBytes)
+{
+    juce::MemoryInputStream stream(data, static_cast<size_t>(sizeInBytes), false);
+    int magic = stream.readInt();
+
+    if (magic == stateMagic)
+    {
+        gain = juce::jlimit(0.0f, 1.0f, stream.readFloat());
+        releaseSec = juce::jmax(0.0f, stream.readFloat());
+    }
+    else if (magic == stateMagicV2)
+    {
+        gain = juce::jlimit(0.0f, 1.0f, stream.readFloat());
+        float attack = stream.readFloat();
+        float decay = stream.readFloat();
+        float sustain = stream.readFloat();
+        float release = stream.readFloat();
+        setEnvelope(attack, decay, sustain, release);
+        setNumHarmonics(stream.readInt());
+    }
+    else
+    {
+        return;
+    }
+
+    prepareToPlay(currentSampleRate, getBlockSize());
+}
+
+} // namespace serum
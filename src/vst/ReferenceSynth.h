@@ -0,0 +1,114 @@
+#pragma once
+
+#include <JuceHeader.h>
+#include <array>
+
+namespace serum {
+
+/**
+ * Built-in deterministic synth used in place of Serum2
+ * Lets the render pipeline run on machines without the VST3 installed
+ *
+ * Additive voices with an ADSR envelope (exponential decay and release).
+ * The number of harmonics sets the CPU cost per voice and sample, so
+ * benchmarks can stand in for light or heavy patches.
+ */
+class ReferenceSynth : public juce::AudioPluginInstance
+{
+public:
+    ReferenceSynth();
+    ~ReferenceSynth() override;
+
+    /**
+     * Plugin format name used to identify the built-in synth in a PluginDescription
+     */
+    static const char* const formatName;
+
+    /**
+     * Create a description that PluginFactory resolves to this synth
+     */
+    static juce::PluginDescription createDescription();
+
+    /**
+     * Harmonics summed per voice and sample (1 = pure sine, the cheapest)
+     */
+    void setNumHarmonics(int numHarmonics);
+    int getNumHarmonics() const { return numHarmonics; }
+
+    /**
+     * Envelope times in seconds; decay and release fall by 60 dB over their time
+     * @param sustain Sustain level (0-1)
+     */
+    void setEnvelope(float attackSec, float decaySec, float sustain, float releaseSec);
+
+    // AudioPluginInstance
+    void fillInPluginDescription(juce::PluginDescription& description) const override;
+
+    // AudioProcessor
+    const juce::String getName() const override { return "Reference Synth"; }
+    void prepareToPlay(double sampleRate, int maximumExpectedSamplesPerBlock) override;
+    void releaseResources() override;
+    void reset() override;
+    void processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midi) override;
+
+    double getTailLengthSeconds() const override { return releaseSec; }
+    bool acceptsMidi() const override { return true; }
+    bool producesMidi() const override { return false; }
+
+    juce::AudioProcessorEditor* createEditor() override { return nullptr; }
+    bool hasEditor() const override { return false; }
+
+    int getNumPrograms() override { return 1; }
+    int getCurrentProgram() override { return 0; }
+    void setCurrentProgram(int) override {}
+    const juce::String getProgramName(int) override { return "Default"; }
+    void changeProgramName(int, const juce::String&) override {}
+
+    void getStateInformation(juce::MemoryBlock& destData) override;
+    void setStateInformation(const void* data, int sizeInBytes) override;
+
+private:
+    enum class Stage
+    {
+        Attack,
+        Decay,
+        Sustain,
+        Release
+    };
+
+    struct Voice
+    {
+        int note = -1;
+        Stage stage = Stage::Attack;
+        float level = 0.0f;
+        float gain = 0.0f;
+        double phase = 0.0;
+        double phaseDelta = 0.0;
+    };
+
+    static constexpr int maxVoices = 16;
+    static constexpr int maxHarmonics = 64;
+
+    std::array<Voice, maxVoices> voices;
+    double currentSampleRate = 44100.0;
+    float gain = 0.5f;
+    float attackSec = 0.002f;
+    float decaySec = 0.3f;
+    float sustainLevel = 0.6f;
+    float releaseSec = 0.25f;
+    int numHarmonics = 1;
+
+    // Per-sample envelope steps, derived from the times at prepareToPlay()
+    float attackStep = 1.0f;
+    float decayCoefficient = 0.0f;
+    float releaseCoefficient = 0.0f;
+
+    void updateEnvelope();
+    void handleMidiEvent(const juce::MidiMessage& message);
+    void renderVoices(juce::AudioBuffer<float>& buffer, int startSample, int numSamples);
+    float advanceEnvelope(Voice& voice) const;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(ReferenceSynth)
+};
+
+} // namespace serum